@@ -7,78 +7,60 @@
 #include "Validator.hpp"
 
 #include <cstdint>
+#include <memory>
 
 
 class Build_Params;
 class Validation_Params;
 
 
-// The top-level application class for the compaction algorithm.
-/*
-定义了一个模板类Application，它接受两个模板参数：一个无符号16位整数k和一个模板模板参数T_App。这个类主要用于表示一个应用程序的实例，并且这个实例在某种层次结构（top-down
-hierarchy）中与其它应用程序实例相关联。
-
-typename:表示T_App是一个类型参数,与之相对比就是
-k,不是类型参数,声明时直接使用数字即可.
-T_APP是 需要 template <uint16_t k> class kmer_Enumeration_Stats; 声明的参数
-*/
-template <uint16_t k, template<uint16_t> typename T_App>
+// The top-level application class for the compaction algorithm. It dispatches the k-value of
+// the parameters, once, to a driver instance of `T_App` specialized for that k-value.
+template <template<uint16_t> typename T_App>
 class Application
 {
 private:
 
-    // Pointer to an application instance of the next `Application` class in the top-down hierarchy (on `k`).
-    Application<k - 2, T_App>* const app_next_level;
-
-    // Pointer to a driver object that operates with the k-value `k`.
-    T_App<k>* const app;
-
-    // TODO: Make the validator member generic, like `T_App`.
-    // Pointer to a `Validator` object that operates with the k-value `k`.
-    Validator<k>* const validator;
-
-
-public:
-
-    // Constructs an `Application` instance with the provided build-parameters,
-    // if the provided `k` parameter matches to the specialized template argument `k`.
-    Application(const Build_Params& params);
-
-    // Constructs an `Application` instance with the provided validation-parameters,
-    // if the provided `k` parameter matches to the specialized template argument `k`.
-    Application(const Validation_Params& params);
+    // Interface to a driver instance specialized for some k-value.
+    class Instance
+    {
+    public:
 
-    ~Application();
+        virtual ~Instance() {}
 
-    // Executes the compaction algorithm.
-    // 本质是在cpp文件里调用app->execute()
-    void execute() const;
+        // Executes the compaction algorithm.
+        virtual void execute() = 0;
 
-    // Validates the result of the compaction algorithm.
-    bool validate() const;
-};
+        // Validates the result of the compaction algorithm.
+        virtual bool validate() = 0;
+    };
 
+    // Driver instance specialized for the k-value `k`.
+    template <uint16_t k> class Instance_k;
 
-template <template<uint16_t> typename T_App>
-class Application<1, T_App>
-{
-private:
+    // The driver instance for the provided k-value.
+    const std::unique_ptr<Instance> instance;
 
-    T_App<1>* const app;
 
-    Validator<1>* const validator;
+    // Returns a driver instance for the k-value in the parameters `params`.
+    template <typename T_Params_>
+    static Instance* instantiate(const T_Params_& params);
 
 
 public:
 
+    // Constructs an `Application` instance with the provided build-parameters.
     Application(const Build_Params& params);
 
+    // Constructs an `Application` instance with the provided validation-parameters.
     Application(const Validation_Params& params);
 
     ~Application();
 
+    // Executes the compaction algorithm.
     void execute() const;
 
+    // Validates the result of the compaction algorithm.
     bool validate() const;
 };
 
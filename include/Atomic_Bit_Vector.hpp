@@ -0,0 +1,120 @@
+
+#ifndef ATOMIC_BIT_VECTOR_HPP
+#define ATOMIC_BIT_VECTOR_HPP
+
+
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <algorithm>
+
+
+// A fixed-size vector of bits, where the bits can be tested and set concurrently by multiple
+// threads without any locks. The bits can only be set, i.e. never cleared, once the vector
+// has been sized.
+class Atomic_Bit_Vector
+{
+private:
+
+    std::size_t size_;  // Number of bits in the vector.
+    std::unique_ptr<std::atomic<uint64_t>[]> word;  // The 64-bit words packing the bits.
+
+
+public:
+
+    // Constructs a vector of `size` unset bits.
+    Atomic_Bit_Vector(std::size_t size = 0);
+
+    // Resizes the vector to `size` bits, and unsets all of them. Not thread-safe.
+    void resize(std::size_t size);
+
+    // Returns whether the bit at index `idx` is set.
+    bool test(std::size_t idx) const;
+
+    // Sets the bit at index `idx`. Returns `true` iff the bit was unset before, i.e. exactly one
+    // of the threads concurrently setting the same bit succeeds.
+    bool set(std::size_t idx);
+
+    // Sets the bits at the indices in `idx`, with one atomic operation per word. `idx` is sorted in
+    // place, so that the indices sharing their words are grouped together.
+    void set(std::vector<uint64_t>& idx);
+
+    // Returns the number of bits in the vector.
+    std::size_t size() const;
+
+    // Returns the memory (in bytes) used by the vector.
+    std::size_t memory() const;
+};
+
+
+inline Atomic_Bit_Vector::Atomic_Bit_Vector(const std::size_t size)
+{
+    resize(size);
+}
+
+
+inline void Atomic_Bit_Vector::resize(const std::size_t size)
+{
+    const std::size_t word_count = (size + 63) / 64;
+
+    size_ = size;
+    word.reset(new std::atomic<uint64_t>[word_count]);
+    for(std::size_t i = 0; i < word_count; ++i)
+        word[i].store(0, std::memory_order_relaxed);
+}
+
+
+inline bool Atomic_Bit_Vector::test(const std::size_t idx) const
+{
+    return word[idx >> 6].load(std::memory_order_acquire) & (uint64_t(1) << (idx & 63));
+}
+
+
+inline bool Atomic_Bit_Vector::set(const std::size_t idx)
+{
+    const uint64_t mask = uint64_t(1) << (idx & 63);
+    return !(word[idx >> 6].fetch_or(mask, std::memory_order_acq_rel) & mask);
+}
+
+
+inline void Atomic_Bit_Vector::set(std::vector<uint64_t>& idx)
+{
+    constexpr std::size_t prefetch_dist = 16;   // Number of indices ahead to prefetch the words of.
+
+    std::sort(idx.begin(), idx.end());
+
+    const std::size_t n = idx.size();
+    for(std::size_t i = 0; i < n; )
+    {
+        const std::size_t w = idx[i] >> 6;
+        uint64_t mask = 0;
+        for(; i < n && (idx[i] >> 6) == w; ++i)
+        {
+            if(i + prefetch_dist < n)
+                __builtin_prefetch(&word[idx[i + prefetch_dist] >> 6], 1);
+
+            mask |= uint64_t(1) << (idx[i] & 63);
+        }
+
+        word[w].fetch_or(mask, std::memory_order_acq_rel);
+    }
+}
+
+
+inline std::size_t Atomic_Bit_Vector::size() const
+{
+    return size_;
+}
+
+
+inline std::size_t Atomic_Bit_Vector::memory() const
+{
+    return ((size_ + 63) / 64) * sizeof(uint64_t);
+}
+
+
+
+#endif
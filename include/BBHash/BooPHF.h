@@ -19,6 +19,10 @@
 #include <unistd.h>
 #include <chrono>
 #include <thread>
+#include <atomic>
+#include <type_traits>
+#include <utility>
+#include <algorithm>
 
 
 
@@ -225,6 +229,28 @@ namespace boomphf {
 	}
 
 
+	// Whether the CPU provides the population count instruction; detected at runtime.	Added by ourselves.
+	inline const bool cpu_has_popcnt = []() { __builtin_cpu_init(); return __builtin_cpu_supports("popcnt") != 0; }();
+
+	// Population count through the hardware instruction where it is available, and through the
+	// software `popcount_64` otherwise.	Added by ourselves.
+	inline unsigned int popcount_hw(uint64_t x)
+	{
+	#if defined(__POPCNT__) || !defined(__x86_64__)
+		return __builtin_popcountll(x);
+	#else
+		if(cpu_has_popcnt)
+		{
+			uint64_t count;
+			__asm__("popcntq %1, %0" : "=r"(count) : "r"(x));
+			return static_cast<unsigned int>(count);
+		}
+
+		return popcount_64(x);
+	#endif
+	}
+
+
 	///// progress bar
 	class Progress
 	{
@@ -480,6 +506,24 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 
 
 
+    // Whether the hasher `Hasher_t` computes both the seeding hashes of a key of type `Item` at
+    // once, through a method `hash_pair(key, h0, h1)`.	Added by ourselves.
+    template <typename Hasher_t, typename Item, typename = void>
+    struct has_hash_pair: std::false_type {};
+
+    template <typename Hasher_t, typename Item>
+    struct has_hash_pair<Hasher_t, Item, std::void_t<decltype(std::declval<const Hasher_t&>().hash_pair(std::declval<const Item&>(), std::declval<uint64_t&>(), std::declval<uint64_t&>()))>>: std::true_type {};
+
+
+    // Whether the hasher `Hasher_t` computes the seeding hashes of an array of keys of type `Item`
+    // at once, through a method `hash_pairs(keys, n, h0, h1)`.	Added by ourselves.
+    template <typename Hasher_t, typename Item, typename = void>
+    struct has_hash_pairs: std::false_type {};
+
+    template <typename Hasher_t, typename Item>
+    struct has_hash_pairs<Hasher_t, Item, std::void_t<decltype(std::declval<const Hasher_t&>().hash_pairs(std::declval<const Item*>(), std::size_t(), std::declval<uint64_t*>(), std::declval<uint64_t*>()))>>: std::true_type {};
+
+
     template <typename Item, class SingleHasher_t> class XorshiftHashFunctors
     {
         /*  Xorshift128*
@@ -512,15 +556,44 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
         public:
 
 
+		// With a pair-hashing single hasher, both the seeds of the state are set here.
 		uint64_t h0(hash_pair_t  & s, const Item& key )
 		{
-			s[0] =  singleHasher (key, 0xAAAAAAAA55555555ULL);
+			if constexpr(has_hash_pair<SingleHasher_t, Item>::value)
+				singleHasher.hash_pair(key, s[0], s[1]);
+			else
+				s[0] =  singleHasher (key, 0xAAAAAAAA55555555ULL);
 			return s[0];
 		}
 
+		// Sets the states `s` of the `n` keys at `keys`, as with `h0`, hashing the keys in one
+		// batch through the single hasher where it supports that.	Added by ourselves.
+		void h0s(hash_pair_t* const s, const Item* const keys, const std::size_t n)
+		{
+			if constexpr(has_hash_pairs<SingleHasher_t, Item>::value)
+			{
+				constexpr std::size_t chunk_sz = 64;
+				uint64_t h0[chunk_sz], h1[chunk_sz];
+				for(std::size_t b = 0; b < n; b += chunk_sz)
+				{
+					const std::size_t count = std::min(chunk_sz, n - b);
+					singleHasher.hash_pairs(keys + b, count, h0, h1);
+					for(std::size_t j = 0; j < count; ++j)
+						s[b + j][0] = h0[j], s[b + j][1] = h1[j];
+				}
+			}
+			else
+				for(std::size_t j = 0; j < n; ++j)
+					h0(s[j], keys[j]);
+		}
+
+		// With a pair-hashing single hasher, `h0` must have been computed into `s` for `key` earlier.
 		uint64_t h1(hash_pair_t  & s, const Item& key )
 		{
-			s[1] =  singleHasher (key, 0x33333333CCCCCCCCULL);
+			if constexpr(!has_hash_pair<SingleHasher_t, Item>::value)
+				s[1] =  singleHasher (key, 0x33333333CCCCCCCCULL);
+			else
+				(void)key;
 			return s[1];
 		}
 
@@ -550,8 +623,13 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 
             hash_set_t   hset;
 
-            hset[0] =  singleHasher (key, 0xAAAAAAAA55555555ULL);
-            hset[1] =  singleHasher (key, 0x33333333CCCCCCCCULL);
+            if constexpr(has_hash_pair<SingleHasher_t, Item>::value)
+                singleHasher.hash_pair(key, hset[0], hset[1]);
+            else
+            {
+                hset[0] =  singleHasher (key, 0xAAAAAAAA55555555ULL);
+                hset[1] =  singleHasher (key, 0x33333333CCCCCCCCULL);
+            }
 
             s[0] = hset[0];
             s[1] = hset[1];
@@ -611,6 +689,10 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 #pragma mark BitVector
 ////////////////////////////////////////////////////////////////
 
+	// The bits are laid out flat while a level is being built. Once its ranks are built, the level is
+	// immutable, and the bits are laid out interleaved with the rank samples instead: in 64-byte
+	// blocks of a rank sample followed by 7 words of bits, so that a bit test and a rank each touch
+	// a single cache line.	Modified by ourselves.
 	class bitVector {
 
 	public:
@@ -630,16 +712,14 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 		{
 			if(_bitArray != nullptr)
 				free(_bitArray);
+			if(_blocks != nullptr)
+				free(_blocks);
 		}
 
 		 //copy constructor
-		 bitVector(bitVector const &r)
+		 bitVector(bitVector const &r) : _bitArray(nullptr), _size(0)
 		 {
-			 _size =  r._size;
-			 _nchar = r._nchar;
-			 _ranks = r._ranks;
-			 _bitArray = (uint64_t *) calloc (_nchar,sizeof(uint64_t));
-			 memcpy(_bitArray, r._bitArray, _nchar*sizeof(uint64_t) );
+			 *this = r;
 		 }
 		
 		// Copy assignment operator
@@ -649,11 +729,25 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 			{
 				_size =  r._size;
 				_nchar = r._nchar;
-				_ranks = r._ranks;
+				_nblocks = r._nblocks;
 				if(_bitArray != nullptr)
 					free(_bitArray);
-				_bitArray = (uint64_t *) calloc (_nchar,sizeof(uint64_t));
-				memcpy(_bitArray, r._bitArray, _nchar*sizeof(uint64_t) );
+				if(_blocks != nullptr)
+					free(_blocks);
+				_bitArray = nullptr;
+				_blocks = nullptr;
+
+				if(r._bitArray != nullptr)
+				{
+					_bitArray = (uint64_t *) calloc (_nchar,sizeof(uint64_t));
+					memcpy(_bitArray, r._bitArray, _nchar*sizeof(uint64_t) );
+				}
+
+				if(r._blocks != nullptr)
+				{
+					_blocks = alloc_blocks(_nblocks);
+					memcpy(_blocks, r._blocks, _nblocks*_block_bytes);
+				}
 			}
 			return *this;
 		}
@@ -666,12 +760,16 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 			{
 				if(_bitArray != nullptr)
 					free(_bitArray);
+				if(_blocks != nullptr)
+					free(_blocks);
 				
 				_size =  std::move (r._size);
 				_nchar = std::move (r._nchar);
-				_ranks = std::move (r._ranks);
+				_nblocks = std::move (r._nblocks);
 				_bitArray = r._bitArray;
 				r._bitArray = nullptr;
+				_blocks = r._blocks;
+				r._blocks = nullptr;
 			}
 			return *this;
 		}
@@ -695,7 +793,7 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 			return _size;
 		}
 
-		uint64_t bitSize() const {return (_nchar*64ULL + _ranks.capacity()*64ULL );}
+		uint64_t bitSize() const {return (_blocks != nullptr ? _nblocks*_block_bytes*8ULL : _nchar*64ULL);}
 
 		//clear whole array
 		void clear()
@@ -734,17 +832,10 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 			{
 				if(ii%10==0)
 					printf(" (%llu) ",(long long unsigned int)ii);
-				int val = (_bitArray[ii >> 6] >> (ii & 63 ) ) & 1;
+				int val = get(ii);
 				printf("%i",val);
 			}
 			printf("\n");
-
-			printf("rank array : size %lu \n",_ranks.size());
-			for (uint64_t ii = 0; ii< _ranks.size(); ii++)
-			{
-				printf("%llu :  %lli,  ",(long long unsigned int)ii,(long long int)_ranks[ii]);
-			}
-			printf("\n");
 		}
 
 		//return value at pos
@@ -753,6 +844,12 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 			//unsigned char * _bitArray8 = (unsigned char *) _bitArray;
 			//return (_bitArray8[pos >> 3ULL] >> (pos & 7 ) ) & 1;
 
+			if(_blocks != nullptr)
+			{
+				const uint64_t offset = pos % _bits_per_block;
+				return (block_of(pos)[1 + (offset >> 6ULL)] >> (offset & 63)) & 1;
+			}
+
 			return (_bitArray[pos >> 6ULL] >> (pos & 63 ) ) & 1;
 
 		}
@@ -771,6 +868,15 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 			return (*this)[pos];
 		}
 
+		// Prefetches the cache line holding the bit `pos` and its rank sample.	Added by ourselves.
+		void prefetch(uint64_t pos) const
+		{
+			if(_blocks != nullptr)
+				__builtin_prefetch(block_of(pos));
+			else
+				__builtin_prefetch(_bitArray + (pos >> 6));
+		}
+
 		uint64_t get64(uint64_t cell64) const
 		{
 			return _bitArray[cell64];
@@ -793,50 +899,70 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 
 		//return value of  last rank
 		// add offset to  all ranks  computed
+		// The bits are moved into the interleaved layout, and the flat one is released.
 		uint64_t build_ranks(uint64_t offset =0)
 		{
-			_ranks.reserve(2+ _size/_nb_bits_per_rank_sample);
+			_nblocks = (_size + _bits_per_block - 1) / _bits_per_block + 1;
+			_blocks = alloc_blocks(_nblocks);
+			memset(_blocks, 0, _nblocks*_block_bytes);
 
 			uint64_t curent_rank = offset;
-			for (size_t ii = 0; ii < _nchar; ii++) {
-				if (((ii*64)  % _nb_bits_per_rank_sample) == 0) {
-					_ranks.push_back(curent_rank);
+			for (uint64_t b = 0; b < _nblocks; b++) {
+				uint64_t * const block = _blocks + b*_words_per_block;
+				block[0] = curent_rank;
+				for (uint64_t w = 0; w < _words_per_block - 1; w++) {
+					const uint64_t ii = b*(_words_per_block - 1) + w;
+					if (ii < _nchar) {
+						block[1 + w] = _bitArray[ii];
+						curent_rank += popcount_hw(_bitArray[ii]);
+					}
 				}
-				curent_rank +=  popcount_64(_bitArray[ii]);
 			}
 
+			free(_bitArray);
+			_bitArray = nullptr;
+
 			return curent_rank;
 		}
 
 		uint64_t rank(uint64_t pos) const
 		{
-			uint64_t word_idx = pos / 64ULL;
-			uint64_t word_offset = pos % 64;
-			uint64_t block = pos / _nb_bits_per_rank_sample;
-			uint64_t r = _ranks[block];
-			for (uint64_t w = block * _nb_bits_per_rank_sample / 64; w < word_idx; ++w) {
-				r += popcount_64( _bitArray[w] );
+			const uint64_t * const block = block_of(pos);
+			const uint64_t offset = pos % _bits_per_block;
+			const uint64_t word_idx = offset / 64ULL;
+			uint64_t r = block[0];
+			for (uint64_t w = 0; w < word_idx; ++w) {
+				r += popcount_hw( block[1 + w] );
 			}
-			uint64_t mask = (uint64_t(1) << word_offset ) - 1;
-			r += popcount_64( _bitArray[word_idx] & mask);
+			uint64_t mask = (uint64_t(1) << (offset % 64) ) - 1;
+			r += popcount_hw( block[1 + word_idx] & mask);
 
 			return r;
 		}
 
 
 
+		// Format version 2 onward: the interleaved blocks.
 		void save(std::ostream& os) const
 		{
 			os.write(reinterpret_cast<char const*>(&_size), sizeof(_size));
-			os.write(reinterpret_cast<char const*>(&_nchar), sizeof(_nchar));
-			os.write(reinterpret_cast<char const*>(_bitArray), (std::streamsize)(sizeof(uint64_t) * _nchar));
-			size_t sizer = _ranks.size();
-			os.write(reinterpret_cast<char const*>(&sizer),  sizeof(size_t));
-			os.write(reinterpret_cast<char const*>(_ranks.data()), (std::streamsize)(sizeof(_ranks[0]) * _ranks.size()));
+			os.write(reinterpret_cast<char const*>(&_nblocks), sizeof(_nblocks));
+			os.write(reinterpret_cast<char const*>(_blocks), (std::streamsize)(_nblocks*_block_bytes));
 		}
 
-		void load(std::istream& is)
+		// Loads a bit vector saved with the format version `version`; the version 1 format, of the
+		// flat layout with a separate rank array, is converted into the interleaved layout.
+		void load(std::istream& is, uint64_t version)
 		{
+			if(version >= 2)
+			{
+				is.read(reinterpret_cast<char*>(&_size), sizeof(_size));
+				is.read(reinterpret_cast<char*>(&_nblocks), sizeof(_nblocks));
+				_blocks = alloc_blocks(_nblocks);
+				is.read(reinterpret_cast<char *>(_blocks), (std::streamsize)(_nblocks*_block_bytes));
+				return;
+			}
+
 			is.read(reinterpret_cast<char*>(&_size), sizeof(_size));
 			is.read(reinterpret_cast<char*>(&_nchar), sizeof(_nchar));
 			this->resize(_size);
@@ -844,21 +970,34 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 
 			size_t sizer;
 			is.read(reinterpret_cast<char *>(&sizer),  sizeof(size_t));
-			_ranks.resize(sizer);
-			is.read(reinterpret_cast<char*>(_ranks.data()), (std::streamsize)(sizeof(_ranks[0]) * _ranks.size()));
+			std::vector<uint64_t> ranks(sizer);
+			is.read(reinterpret_cast<char*>(ranks.data()), (std::streamsize)(sizeof(ranks[0]) * ranks.size()));
+
+			build_ranks(ranks.empty() ? 0 : ranks[0]);
 		}
 
 
 	protected:
-		uint64_t*  _bitArray;
+		uint64_t*  _bitArray;	// The flat layout of the bits, while the ranks are not built.
 		//uint64_t* _bitArray;
 		uint64_t _size;
 		uint64_t _nchar;
 
-		 // epsilon =  64 / _nb_bits_per_rank_sample   bits
-		// additional size for rank is epsilon * _size
-		static const uint64_t _nb_bits_per_rank_sample = 512; //512 seems ok
-		std::vector<uint64_t> _ranks;
+		static constexpr uint64_t _block_bytes = 64;	// Size of an interleaved block: a cache line.
+		static constexpr uint64_t _words_per_block = _block_bytes / sizeof(uint64_t);
+		static constexpr uint64_t _bits_per_block = (_words_per_block - 1) * 64;	// One word of a block holds its rank sample.
+		uint64_t* _blocks = nullptr;	// The interleaved layout of the bits and the rank samples, once the ranks are built.
+		uint64_t _nblocks = 0;
+
+		static uint64_t* alloc_blocks(uint64_t nblocks)
+		{
+			return static_cast<uint64_t*>(aligned_alloc(_block_bytes, nblocks*_block_bytes));
+		}
+
+		const uint64_t* block_of(uint64_t pos) const
+		{
+			return _blocks + (pos / _bits_per_block)*_words_per_block;
+		}
 	};
 
 ////////////////////////////////////////////////////////////////
@@ -888,6 +1027,11 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 			uint64_t hashi = fastrange64(hash_raw,hash_domain);
 			return bitset.get(hashi);
 		}
+
+		void prefetch(uint64_t hash_raw) const
+		{
+			bitset.prefetch(fastrange64(hash_raw,hash_domain));
+		}
 		
 		uint64_t idx_begin;
 		uint64_t hash_domain;
@@ -1061,10 +1205,45 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 
 					// 如果未构建完成，则返回最大值
 					//auto hashes = _hasher(elem);
+					hash_pair_t bbhash;
+					_hasher.h0(bbhash,elem);
+
+					return lookup_hashed(elem, bbhash);
+				}
+
+		// Looks up the `n` keys at `elems` in a batch, into `hp`. All the keys of a batch are hashed
+		// first, and their bits at the first level prefetched, so that the keys' accesses to memory
+		// overlap rather than stall one after another.	Added by ourselves.
+		void lookup(const elem_t* const elems, const std::size_t n, uint64_t* const hp)
+		{
+			if(! _built)
+			{
+				std::fill(hp, hp + n, ULLONG_MAX);
+				return;
+			}
+
+			constexpr std::size_t batch_sz = 16;
+			hash_pair_t bbhash[batch_sz];
+			for(std::size_t b = 0; b < n; b += batch_sz)
+			{
+				const std::size_t count = std::min(batch_sz, n - b);
+
+				_hasher.h0s(bbhash, elems + b, count);
+				for(std::size_t j = 0; j < count; ++j)
+					_levels[0].prefetch(bbhash[j][0]);
+
+				for(std::size_t j = 0; j < count; ++j)
+					hp[b + j] = lookup_hashed(elems[b + j], bbhash[j]);
+			}
+		}
+
+		// Looks up the key `elem`, with its first-level hash already computed into `bbhash`.
+				uint64_t lookup_hashed(const elem_t& elem, hash_pair_t& bbhash)
+				{
 					uint64_t non_minimal_hp,minimal_hp;
 
-					hash_pair_t bbhash;  int level;
-					uint64_t level_hash = getLevel(bbhash,elem,&level);
+					int level;
+					uint64_t level_hash = getLevel(bbhash,elem,&level,100,0,true);
 
 					if( level == (_nb_levels-1))
 					{
@@ -1136,6 +1315,7 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 
 			uint64_t writebuff =0;
 			std::vector< elem_t > & myWriteBuff = bufferperThread[tid];
+			std::vector< hash_pair_t > bbhashes;	// Hash states of the keys of the buffer.	Added by ourselves.
 
 
 			for (bool isRunning=true;  isRunning ; )
@@ -1154,7 +1334,10 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 				}
 				else	// Use the BBHash `bfile_iterator` to read keys from their temporary binary files.
 				{
-					pthread_mutex_lock(&_mutex);
+					// With the levels written to disk, each thread reads its own spill file of the
+					// previous level, so the read needs no synchronization.
+					if(!_writeEachLevel)
+						pthread_mutex_lock(&_mutex);
 
 					// TODO: try optimizing by including the value fetch into the iterator advancement.
 					for(; inbuff < LARGE_CHUNK_SZ && (*shared_it) != until;  ++(*shared_it))
@@ -1163,24 +1346,30 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 					if((*shared_it) == until)
 						isRunning = false;
 
-					pthread_mutex_unlock(&_mutex);
+					if(!_writeEachLevel)
+						pthread_mutex_unlock(&_mutex);
 				}
 
 				//do work on the n elems of the buffer
 			//	printf("filling input  buff \n");
 
+				// Hash the keys of the buffer in one batch.
+				if(bbhashes.size() < inbuff)
+					bbhashes.resize(inbuff);
+				_hasher.h0s(bbhashes.data(), buffer.data(), inbuff);
+
                 for(uint64_t ii=0; ii<inbuff ; ii++)
 				{
 					elem_t val = buffer[ii];
 					//printf("processing %llu  level %i\n",val, i);
 
 					//auto hashes = _hasher(val);
-					hash_pair_t bbhash;  int level;
+					hash_pair_t& bbhash = bbhashes[ii];  int level;
 					uint64_t level_hash;
 					if(_writeEachLevel)
-						getLevel(bbhash,val,&level, i,i-1);
+						getLevel(bbhash,val,&level, i,i-1,true);
 					else
-						getLevel(bbhash,val,&level, i);
+						getLevel(bbhash,val,&level, i,0,true);
 
 					
 					//uint64_t level_hash = getLevel(bbhash,val,&level, i);
@@ -1209,13 +1398,8 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 						//insert to level i+1 : either next level of the cascade or final hash if last level reached
 						if(i == _nb_levels-1) //stop cascade here, insert into exact hash
 						{
-
-							uint64_t hashidx =  __sync_fetch_and_add (& _hashidx, 1);
-
-							pthread_mutex_lock(&_mutex); //see later if possible to avoid this, mais pas bcp item vont la
-							// calc rank de fin  precedent level qq part, puis init hashidx avec ce rank, direct minimal, pas besoin inser ds bitset et rank
-							_final_hash[val] = hashidx;
-							pthread_mutex_unlock(&_mutex);
+							// Collected per thread, and merged into the exact hash after the level.
+							_final_keys[thread_id].push_back(val);
 						}
 						else
 						{
@@ -1229,9 +1413,7 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 								if(writebuff>=WRITE_BUFF_SZ)
 								{
 									//flush buffer
-									flockfile(_currlevelFile);
-									fwrite(myWriteBuff.data(),sizeof(elem_t),writebuff,_currlevelFile);
-									funlockfile(_currlevelFile);
+									fwrite(myWriteBuff.data(),sizeof(elem_t),writebuff,_levelFiles[thread_id]);
 									writebuff = 0;
 								
 								}
@@ -1248,7 +1430,7 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 							//computes next hash
 
 							if ( level == 0)
-								level_hash = _hasher.h0(bbhash,val);
+								level_hash = bbhash[0];
 							else if ( level == 1)
 								level_hash = _hasher.h1(bbhash,val);
 							else
@@ -1270,9 +1452,7 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 			if(_writeEachLevel && writebuff>0)
 			{
 				//flush buffer
-				flockfile(_currlevelFile);
-				fwrite(myWriteBuff.data(),sizeof(elem_t),writebuff,_currlevelFile);
-				funlockfile(_currlevelFile);
+				fwrite(myWriteBuff.data(),sizeof(elem_t),writebuff,_levelFiles[thread_id]);
 				writebuff = 0;
 			}
 		}
@@ -1280,7 +1460,8 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 		
 		void save(std::ostream& os) const
 		{
-
+			const uint64_t format_magic = _format_magic | _format_version;
+			os.write(reinterpret_cast<char const*>(&format_magic), sizeof(format_magic));
 			os.write(reinterpret_cast<char const*>(&_gamma), sizeof(_gamma));
 			os.write(reinterpret_cast<char const*>(&_nb_levels), sizeof(_nb_levels));
 			os.write(reinterpret_cast<char const*>(&_lastbitsetrank), sizeof(_lastbitsetrank));
@@ -1312,10 +1493,28 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 		 *
 		 * @param is 输入流引用
 		 */
-		void load(std::istream& is)
+		// The format version is about the layout only; the key hashes that the levels were built
+		// over are for the caller to stamp and check. Returns `false`, without loading anything
+		// further, iff the saved file is of a newer format version than this one.	Added by ourselves.
+		bool load(std::istream& is)
 		{
-			// 读取_gamma的值
-			is.read(reinterpret_cast<char*>(&_gamma), sizeof(_gamma));
+			// Files of the format version 1 have no version header, and start with `_gamma`
+			// instead; which is never a NaN, unlike the header.	Added by ourselves.
+			uint64_t version = 1;
+			uint64_t header;
+			is.read(reinterpret_cast<char*>(&header), sizeof(header));
+			if((header & ~_format_version_mask) == _format_magic)
+			{
+				version = header & _format_version_mask;
+				if(version > _format_version)
+					return false;
+
+				// 读取_gamma的值
+				is.read(reinterpret_cast<char*>(&_gamma), sizeof(_gamma));
+			}
+			else
+				memcpy(&_gamma, &header, sizeof(_gamma));
+
 			// 读取_nb_levels的值
 			is.read(reinterpret_cast<char*>(&_nb_levels), sizeof(_nb_levels));
 			// 读取_lastbitsetrank的值
@@ -1331,7 +1530,7 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 			{
 				// 加载_levels[ii]的bitset数据
 				//_levels[ii].bitset = new bitVector();
-				_levels[ii].bitset.load(is);
+				_levels[ii].bitset.load(is, version);
 			}
 
 			// 最小设置，重新计算每个级别的大小
@@ -1375,6 +1574,8 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 
 			// 标记为已构建
 			_built = true;
+
+			return true;
 		}
 
 
@@ -1388,6 +1589,11 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 			// 获取当前进程的PID，并和线程ID拼接成_pid
 			_pid = getpid() + printPt(pthread_self()) ;// + pthread_self();
 
+			// The thread-ID sum above may collide across the threads building MPHFs concurrently, so
+			// the spill files are also keyed by a process-wide instance number.	Added by ourselves.
+			static std::atomic<int> instance_count(0);
+			_instance = instance_count.fetch_add(1);
+
 			// 初始化_cptTotalProcessed为0
 			_cptTotalProcessed=0;
 
@@ -1400,6 +1606,8 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 
 			// 初始化bufferperThread数组
 			bufferperThread.resize(_num_thread);
+			_levelFiles.resize(_num_thread);
+			_final_keys.resize(_num_thread);
 			if(_writeEachLevel)
 			{
 				// 遍历每个线程对应的buffer
@@ -1487,7 +1695,8 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 
 
 		//compute level and returns hash of last level reached
-		uint64_t getLevel(hash_pair_t & bbhash, elem_t val,int * res_level, int maxlevel = 100, int minlevel =0)
+		// `h0_computed` denotes whether the first-level hash of `val` is already in `bbhash`.
+		uint64_t getLevel(hash_pair_t & bbhash, elem_t val,int * res_level, int maxlevel = 100, int minlevel =0, bool h0_computed = false)
 		//uint64_t getLevel(hash_pair_t & bbhash, elem_t val,int * res_level, int maxlevel = 100, int minlevel =0)
 
 		{
@@ -1499,7 +1708,7 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 
 				//calc le hash suivant
 				 if ( ii == 0)
-					hash_raw = _hasher.h0(bbhash,val);
+					hash_raw = (h0_computed ? bbhash[0] : _hasher.h0(bbhash,val));
 				else if ( ii == 1)
 					hash_raw = _hasher.h1(bbhash,val);
 				else
@@ -1554,28 +1763,31 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 
 			//printf("---process level %i   wr %i fast %i ---\n",i,_writeEachLevel,_fastmode);
 			
-			std::string fname_fmt = _working_dir + "/temp_p%i_level_%i";
-			char fname_old[1000];
-			sprintf(fname_old,fname_fmt.c_str(),_pid,i-2);
-			
-			char fname_curr[1000];
-			sprintf(fname_curr,fname_fmt.c_str(),_pid,i);
-			
-			char fname_prev[1000];
-			sprintf(fname_prev,fname_fmt.c_str(),_pid,i-1);
+			// Each thread spills the keys it passes through a level into a file of its own, and
+			// reads back that file at the next level.
+			std::string fname_fmt = _working_dir + "/temp_p%i_i" + std::to_string(_instance) + "_level_%i_thread_%i";
+			std::vector<std::string> fname_prev(_num_thread);
 			
 			if(_writeEachLevel)
 			{
 				//file management :
-				
-				if(i>2) //delete previous file
-				{
-					unlink(fname_old);
-				}
-				
-				if(i< _nb_levels-1 && i > 0 ) //create curr file
+				char fname[1000];
+				for(int ii=0;ii<_num_thread;ii++)
 				{
-					_currlevelFile = fopen(fname_curr,"w");
+					if(i>2) //delete previous file
+					{
+						sprintf(fname,fname_fmt.c_str(),_pid,i-2,ii);
+						unlink(fname);
+					}
+					
+					if(i< _nb_levels-1 && i > 0 ) //create curr file
+					{
+						sprintf(fname,fname_fmt.c_str(),_pid,i,ii);
+						_levelFiles[ii] = fopen(fname,"w");
+					}
+
+					sprintf(fname,fname_fmt.c_str(),_pid,i-1,ii);
+					fname_prev[ii] = fname;
 				}
 			}
 			
@@ -1600,17 +1812,24 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 
 			if(_writeEachLevel && (i > 1))	// Reading keys from BBHash-made binary files.
 			{
+				typedef bfile_iterator<elem_t> disklevel_it_type;
+				std::vector<boomphf::thread_args<Range, disklevel_it_type>> disk_thread_args(_num_thread);
+				std::vector<std::unique_ptr<file_binary<elem_t>>> data_iterator_level(_num_thread);
 
-				auto data_iterator_level = file_binary<elem_t>(fname_prev);
-				
-				typedef decltype(data_iterator_level.begin()) disklevel_it_type;
-				
-				//data_iterator_level.begin();
-				t_arg.it_p = std::static_pointer_cast<void>(std::make_shared<disklevel_it_type>(data_iterator_level.begin()));
-				t_arg.until_p = std::static_pointer_cast<void>(std::make_shared<disklevel_it_type>(data_iterator_level.end()));
+				for(int ii=0;ii<_num_thread;ii++)
+				{
+					data_iterator_level[ii].reset(new file_binary<elem_t>(fname_prev[ii].c_str()));
+
+					disk_thread_args[ii].boophf = this;
+					disk_thread_args[ii].range = &input_range;
+					disk_thread_args[ii].it_p = std::static_pointer_cast<void>(std::make_shared<disklevel_it_type>(data_iterator_level[ii]->begin()));
+					disk_thread_args[ii].until_p = std::static_pointer_cast<void>(std::make_shared<disklevel_it_type>(data_iterator_level[ii]->end()));
+					disk_thread_args[ii].level = i;
+					disk_thread_args[ii].thread_id = ii;
+				}
 				
 				for(int ii=0;ii<_num_thread;ii++)
-					pthread_create (&tab_threads[ii], NULL,  thread_processLevel<elem_t, Hasher_t, Range, disklevel_it_type>, &t_arg); //&t_arg[ii]
+					pthread_create (&tab_threads[ii], NULL,  thread_processLevel<elem_t, Hasher_t, Range, disklevel_it_type>, &disk_thread_args[ii]);
 			
 			
 				//must join here before the block is closed and file_binary is destroyed (and closes the file)
@@ -1669,21 +1888,40 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 			
 			if(_writeEachLevel)
 			{
-				if(i< _nb_levels-1 && i>0)
+				for(int ii=0;ii<_num_thread;ii++)
 				{
-					fflush(_currlevelFile);
-					fclose(_currlevelFile);
-				}
-				
-					if(i== _nb_levels- 1) //delete last file
+					if(i< _nb_levels-1 && i>0)
 					{
-						unlink(fname_prev);
+						fflush(_levelFiles[ii]);
+						fclose(_levelFiles[ii]);
 					}
+					
+					if(i== _nb_levels- 1) //delete last file
+						unlink(fname_prev[ii].c_str());
+				}
+			}
+
+			if(i == _nb_levels-1)	// Merge the threads' keys reaching the last level into the exact hash.
+			{
+				for(int ii=0;ii<_num_thread;ii++)
+				{
+					for(const elem_t& key : _final_keys[ii])
+						_final_hash[key] = _hashidx++;
+
+					std::vector<elem_t>().swap(_final_keys[ii]);
+				}
 			}
 
 		}
 
 	private:
+		// Header of the saved files, from the format version 2 onward: the magic, with the version
+		// in its low bits. Read as a `double`, it is a NaN. The version covers the layout of the
+		// files only: version 2 introduced the interleaved bit vector layout.	Added by ourselves.
+		static constexpr uint64_t _format_magic = 0x7FF8A5A542424800ULL;
+		static constexpr uint64_t _format_version_mask = 0xFFULL;
+		static constexpr uint64_t _format_version = 2;
+
 		//level ** _levels;
 		std::vector<level> _levels;
 		int _nb_levels;
@@ -1717,8 +1955,10 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 		bool _withprogress;
 		bool _built;
 		bool _writeEachLevel;
-		FILE * _currlevelFile;
+		std::vector<FILE *> _levelFiles;	// The threads' spill files of the current level.
+		std::vector<std::vector<elem_t>> _final_keys;	// The threads' keys reaching the last level.
 		int _pid;
+		int _instance;	// Process-wide number of this instance, to key its spill files.	Added by ourselves.
 	public:
 		pthread_mutex_t _mutex;
 	};
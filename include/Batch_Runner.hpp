@@ -0,0 +1,96 @@
+
+#ifndef BATCH_RUNNER_HPP
+#define BATCH_RUNNER_HPP
+
+
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <optional>
+#include <mutex>
+#include <condition_variable>
+
+
+class Build_Params;
+
+
+// A driver to construct many independent compacted de Bruijn graphs in a single process, from a
+// manifest of jobs, sharing the process start-up and the allocator's warmed-up memory. The jobs
+// are admitted against a budget of threads: the small jobs run concurrently with a share of the
+// budget each, and the large ones run alone with all of it; each job runs its own threads within
+// its share. Each job gets its own metadata (JSON) file, as with a `build`, and its own working
+// subdirectory; and the jobs whose graphs have been constructed earlier are skipped.
+class Batch_Runner
+{
+public:
+
+    // Configuration of a batch.
+    struct Config
+    {
+        std::string manifest_path;  // Path to the manifest of the jobs.
+        uint16_t thread_count;  // Budget of threads for the concurrent jobs.
+        uint16_t job_count; // Maximum number of small jobs to run concurrently.
+        std::size_t large_input;    // Total size (in bytes) of the input of a job from which it is large.
+        std::optional<std::size_t> max_memory;  // Maximum memory (in GB) shared by the jobs.
+        bool strict_memory; // Whether to impose the memory limit.
+        std::string working_dir_path;   // Directory for the temporary files of the jobs.
+    };
+
+
+private:
+
+    // A job: one compacted graph to construct.
+    struct Job
+    {
+        bool is_read_graph; // Whether the graph is a read de Bruijn graph, or a reference one.
+        uint16_t k; // The k-mer length.
+        std::string output_file_path;   // Output prefix of the graph.
+        std::vector<std::string> seqs;  // The input sequence files.
+        std::vector<std::string> dirs;  // The input directories.
+        std::optional<uint32_t> cutoff; // Frequency cutoff for the (k + 1)-mers.
+        std::size_t input_size; // Total size (in bytes) of the input files.
+        uint16_t thread_count;  // Number of threads to use for the job.
+    };
+
+    const Config config;    // Configuration of the batch.
+    std::vector<Job> jobs;  // The jobs, from the largest input to the smallest.
+
+    std::size_t next_job;   // Index of the next job to be taken up by a worker.
+    std::size_t started_jobs;   // Number of the jobs started; the jobs start in order.
+    uint16_t free_threads;  // Number of threads not used by the running jobs.
+    std::mutex lock;    // Mutual exclusion lock for the scheduling.
+    std::condition_variable schedule_changed;   // Notifies the workers of the jobs started and of the threads freed.
+
+
+    // Reads the jobs from the manifest, and assigns their thread counts.
+    void read_manifest();
+
+    // Returns the working subdirectory of the job `job`, keeping its temporary files apart from the
+    // ones of the concurrent jobs.
+    std::string working_dir_path(const Job& job) const;
+
+    // Returns the build parameters for the job `job` with `thread_count` threads.
+    Build_Params params(const Job& job, uint16_t thread_count) const;
+
+    // Constructs the graph of the job `job`, unless it has been constructed earlier.
+    void run(const Job& job);
+
+    // Takes up the jobs one at a time, and runs each once the jobs before it have started and
+    // enough threads are free, till no jobs remain.
+    void work();
+
+
+public:
+
+    // Constructs a batch driver with the configuration `config`.
+    Batch_Runner(const Config& config);
+
+    // Runs all the jobs of the batch.
+    void execute();
+};
+
+
+
+#endif
@@ -9,6 +9,7 @@
 #include "Output_Format.hpp"
 #include "File_Extensions.hpp"
 #include "Input_Defaults.hpp"
+#include "Unitig_Sink.hpp"
 
 #include <cstdint>
 #include <cstddef>
@@ -39,12 +40,17 @@ private:
     const bool poly_n_stretch_; // Whether to include tiles in GFA-reduced output that track the polyN stretches in the input.
     const std::string working_dir_path_;    // Path to the working directory (for temporary files).
     const bool path_cover_; // Whether to extract a maximal path cover of the de Bruijn graph.
+    const bool partitioned_;    // Whether to construct the graph out-of-core, over minimizer-partitioned buckets of its vertices and edges.
+    const bool minimizer_layout_;   // Whether to lay out the hash table such that the vertices sharing minimizers get contiguous buckets.
+    const bool owner_computes_; // Whether to compute the DFA states with each thread owning a slice of the hash table, without locks.
+    const bool coalesce_edges_; // Whether to coalesce the state updates for the runs of edges sharing their prefix vertex.
     const bool save_mph_;   // Option to save the MPH over the vertex set of the de Bruijn graph.
     const bool save_buckets_;   // Option to save the DFA-states collection of the vertices of the de Bruijn graph.
     const bool save_vertices_;  // Option to save the vertex set of the de Bruijn graph (in KMC database format).
 #ifdef CF_DEVELOP_MODE
     const double gamma_;    // The gamma parameter for the BBHash MPHF.
 #endif
+    Unitig_Sink unitig_sink_;   // Sink for the maximal unitigs, in place of the output file; empty if none.
 
 
     // Returns the extension of the output file, depending on the output format requested.
@@ -94,6 +100,10 @@ public:
                     bool poly_n_stretch,
                     const std::string& working_dir_path,
                     bool path_cover,
+                    bool partitioned,
+                    bool minimizer_layout,
+                    bool owner_computes,
+                    bool coalesce_edges,
                     bool save_mph,
                     bool save_buckets,
                     bool save_vertices
@@ -173,6 +183,13 @@ public:
     }
 
 
+    // Returns whether the soft maximum memory limit is specified explicitly.
+    bool max_memory_specified() const
+    {
+        return max_memory_.has_value();
+    }
+
+
     // Returns whether strict memory limit restriction is specifiied.
     bool strict_memory() const
     {
@@ -242,6 +259,36 @@ public:
     }
 
 
+    bool partitioned() const
+    {
+        return partitioned_;
+    }
+
+
+    // Returns whether to lay out the hash table such that the vertices sharing minimizers
+    // get contiguous buckets.
+    bool minimizer_layout() const
+    {
+        return minimizer_layout_;
+    }
+
+
+    // Returns whether to compute the DFA states with each thread owning a slice of the hash
+    // table, i.e. without synchronized updates to the states.
+    bool owner_computes() const
+    {
+        return owner_computes_;
+    }
+
+
+    // Returns whether to coalesce the state updates for the runs of consecutive edges sharing
+    // their prefix vertex, in the DFA states computation.
+    bool coalesce_edges() const
+    {
+        return coalesce_edges_;
+    }
+
+
     // Returns the path to the optional MPH file.
     const std::string mph_file_path() const
     {
@@ -276,7 +323,23 @@ public:
     }
 
 
+    // Sets the sink `sink` for the maximal unitigs, in place of the output file.
+    void set_unitig_sink(const Unitig_Sink& sink)
+    {
+        unitig_sink_ = sink;
+    }
+
+
+    // Returns the sink for the maximal unitigs; empty if the unitigs are to be written to the output file.
+    const Unitig_Sink& unitig_sink() const
+    {
+        return unitig_sink_;
+    }
+
+
     // Returns the path to the optional file storing meta-information about the graph and cuttlefish executions.
+    // The builds into a unitig sink produce no output file, and get a distinct path so that they do not
+    // mark the output as constructed.
     /**
      * @brief 获取 JSON 文件路径
      *
@@ -287,7 +350,7 @@ public:
     const std::string json_file_path() const
     {
         //输出文件路径 + JSON 文件扩展名
-        return output_file_path_ + cuttlefish::file_ext::json_ext;
+        return output_file_path_ + (unitig_sink_ ? cuttlefish::file_ext::sink_json_ext : cuttlefish::file_ext::json_ext);
     }
 
 
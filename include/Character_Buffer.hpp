@@ -7,6 +7,7 @@
 #include "Spin_Lock.hpp"
 #include "Async_Logger_Wrapper.hpp"
 #include "FASTA_Record.hpp"
+#include "Trace.hpp"
 
 #include <cstdint>
 #include <cstddef>
@@ -195,6 +196,7 @@ inline void Character_Buffer<CAPACITY, T_sink_>::ensure_space(const std::size_t
 template <std::size_t CAPACITY, typename T_sink_>
 inline void Character_Buffer<CAPACITY, T_sink_>::flush()
 {
+    const Trace_Span span("output flush");
     Character_Buffer_Flusher<T_sink_>::write(buffer, sink);
 
     buffer.clear();
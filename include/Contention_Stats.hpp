@@ -0,0 +1,91 @@
+
+#ifndef CONTENTION_STATS_HPP
+#define CONTENTION_STATS_HPP
+
+
+
+#include "Spin_Lock.hpp"
+#include "nlohmann/json.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <vector>
+
+
+// Profiling counters for the contention over the hash table: lookups, state-updates and their
+// failures, and lock acquisitions and their spins, along with the spins per lock-stripe. These
+// are counted only in builds with `CF_CONTENTION_STATS` defined. Each thread counts into its own
+// thread-local counters, which are merged into the global totals when the thread exits; so the
+// totals are complete once the worker threads of a phase have been joined.
+class Contention_Stats
+{
+private:
+
+    // Counters of a thread, or the totals over the threads.
+    struct Counters
+    {
+        uint64_t lookups = 0;   // Number of hash lookups.
+        uint64_t updates = 0;   // Number of attempted (CAS) state-updates.
+        uint64_t failed_updates = 0;    // Number of state-updates failed due to concurrent updates.
+        uint64_t lock_acquisitions = 0; // Number of lock-stripe acquisitions.
+        uint64_t contended_acquisitions = 0;    // Number of lock-stripe acquisitions that had to spin.
+        uint64_t spins = 0; // Number of spin iterations over all the lock-stripe acquisitions.
+
+        // Adds the counts of `rhs` to these.
+        void merge(const Counters& rhs);
+    };
+
+    // Thread-local counters, merged into the totals at the exit of their thread.
+    struct Thread_Counters: Counters
+    {
+        ~Thread_Counters();
+    };
+
+    // Spin counters of a collection of lock-stripes.
+    struct Stripe_Spins
+    {
+        std::atomic<uint64_t>* spins;   // Spins per stripe.
+        std::size_t stripe_count;   // Number of stripes.
+    };
+
+    static constexpr std::size_t HOT_STRIPE_COUNT = 8;  // Number of the hottest stripes to report.
+
+    static thread_local Thread_Counters local;  // Counters of the executing thread.
+    static Counters total;  // Totals over the exited threads.
+    static std::vector<Stripe_Spins> stripe_spins;  // Spin counters of the live lock-stripe collections.
+    static Spin_Lock lock;  // Mutual exclusion lock for the totals and the stripe-spin registry.
+
+
+public:
+
+    // Counts a hash lookup.
+    static void count_lookup() { local.lookups++; }
+
+    // Counts an attempted state-update, with its success status `success`.
+    static void count_update(const bool success) { local.updates++; local.failed_updates += !success; }
+
+    // Counts a lock-stripe acquisition that took `spins` spin iterations.
+    static void count_lock(const uint64_t spins) { local.lock_acquisitions++; local.contended_acquisitions += (spins > 0); local.spins += spins; }
+
+    // Registers the `stripe_count` spin counters at `spins` of a lock-stripe collection.
+    static void register_stripes(std::atomic<uint64_t>* spins, std::size_t stripe_count);
+
+    // Deregisters the spin counters at `spins` of a lock-stripe collection.
+    static void deregister_stripes(const std::atomic<uint64_t>* spins);
+
+    // Returns the counts since the last collection, with the histograms of the spins per stripe
+    // of the registered lock-stripe collections and their hottest stripes, and resets those. The
+    // counts of the live threads other than the caller are not included.
+    static nlohmann::ordered_json collect();
+};
+
+
+inline thread_local Contention_Stats::Thread_Counters Contention_Stats::local;
+inline Contention_Stats::Counters Contention_Stats::total;
+inline std::vector<Contention_Stats::Stripe_Spins> Contention_Stats::stripe_spins;
+inline Spin_Lock Contention_Stats::lock;
+
+
+
+#endif
@@ -0,0 +1,54 @@
+
+#ifndef CUTTLEFISH_API_HPP
+#define CUTTLEFISH_API_HPP
+
+
+
+#include "Unitig_Sink.hpp"
+#include "Input_Defaults.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <optional>
+
+
+// The in-process library interface to the compacted de Bruijn graph construction, for linking
+// against `cfcore_static` instead of driving the executable.
+namespace cuttlefish
+{
+    // Configuration of a compacted de Bruijn graph construction; the fields mirror the options of
+    // `cuttlefish build`.
+    struct Build_Config
+    {
+        std::vector<std::string> seqs;  // Input sequence files.
+        std::vector<std::string> lists; // Input files listing the sequence files.
+        std::vector<std::string> dirs;  // Input directories of the sequence files.
+        bool is_ref_graph = false;  // Whether the input is reference sequences, instead of sequencing reads.
+        uint16_t k = _default::K;   // The k-mer length.
+        std::optional<uint32_t> cutoff; // Frequency cutoff for the (k + 1)-mers; defaults per the input type.
+        uint16_t thread_count = _default::THREAD_COUNT; // Number of threads to use.
+        std::optional<std::size_t> max_memory;  // Soft maximum memory limit (in GB).
+        bool strict_memory = true;  // Whether to impose the memory limit.
+        std::string output_prefix;  // Path prefix for the output file and the metadata (JSON) file.
+        std::string working_dir_path = _default::WORK_DIR;  // Directory for the temporary files.
+        bool path_cover = false;    // Whether to extract a maximal path cover instead of the maximal unitigs.
+        bool partitioned = false;   // Whether to construct out-of-core, over minimizer-partitioned buckets.
+        bool minimizer_layout = false;  // Whether to lay out the vertices sharing minimizers contiguously in the hash table.
+        bool owner_computes = false;    // Whether to compute the DFA states with each thread owning a slice of the hash table.
+        bool coalesce_edges = false;    // Whether to coalesce the state updates of consecutive edges sharing their prefix vertex.
+    };
+
+
+    // Constructs the compacted de Bruijn graph per the configuration `config`. If `sink` is
+    // provided, then the maximal unitigs are passed to it from the worker threads as they are
+    // extracted, instead of being written to the output file; the metadata file is written
+    // regardless. Returns `false` iff the configuration is invalid. As with the executable,
+    // unrecoverable errors during the construction terminate the process.
+    bool build(const Build_Config& config, const Unitig_Sink& sink = Unitig_Sink());
+}
+
+
+
+#endif
@@ -0,0 +1,152 @@
+
+#ifndef DIRECT_KMER_INDEX_HPP
+#define DIRECT_KMER_INDEX_HPP
+
+
+
+#include "Kmer.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+template <uint16_t k> class Kmer_SPMC_Iterator;
+
+
+// A keyed index over a small set of k-mers, used in place of an MPHF for small graphs: an
+// open-addressing (linear probing) table of the k-mers, in their 2-bit-packed form. No IDs are
+// stored: the slots are tracked in an occupancy bitmap, and the dense ID in `[0, kmer_count)` of
+// a k-mer is the rank of its slot among the occupied ones, from rank samples interleaved with the
+// bitmap words. It is built in a single pass over the k-mers, without any temporary files, and
+// being keyed, it also answers membership queries exactly.
+//
+// The keys take `8 * ceil(k / 32)` bytes per slot, with no padding, and the bitmap with the rank
+// samples two bits per slot; at the load factor of 2/3, that is ~12.4 bytes per k-mer for
+// `k <= 32`, and ~24.4 bytes for `k <= 64` — an order of magnitude more than BBHash. Hence it is
+// used only for up-to `MAX_KMER_COUNT` k-mers, i.e. ~52 MB at most for `k <= 32`.
+template <uint16_t k>
+class Direct_Kmer_Index
+{
+public:
+
+    static constexpr uint64_t MAX_KMER_COUNT = (1ULL << 22);    // Maximum number of k-mers to use the index for: ~4M.
+    static constexpr uint64_t absent = ~0ULL;   // ID returned for the k-mers not in the index.
+
+
+private:
+
+    typedef typename Kmer<k>::width_t key_t;    // Type of the keys: k-mers without any k-value.
+
+    // A block of 64 slots of the table: their occupancy bits, and the number of the occupied slots
+    // before the block.
+    struct Block
+    {
+        uint64_t occupied = 0;
+        uint64_t rank = 0;
+    };
+
+    uint64_t kmer_count_ = 0;   // Number of k-mers in the index.
+    std::vector<key_t> key; // The keys at the slots of the table.
+    std::vector<Block> block;   // The occupancy bitmap of the slots, with rank samples per 64 slots.
+    uint64_t inserted = 0;  // Number of k-mers inserted into the table, during construction.
+
+
+    // Returns the number of slots for a table of `kmer_count` k-mers; keeps the load factor at 2/3.
+    static uint64_t slot_count(uint64_t kmer_count);
+
+    // Returns the home slot of the k-mer `kmer`.
+    uint64_t home(const Kmer<k>& kmer) const;
+
+    // Returns the next slot to probe after the slot `s`.
+    uint64_t next(uint64_t s) const;
+
+    // Inserts the k-mers provided to the consumer thread with ID `thread_id` from the parser
+    // `kmer_parser` into the table.
+    void insert_kmers(Kmer_SPMC_Iterator<k>& kmer_parser, uint16_t thread_id);
+
+
+public:
+
+    // Returns the memory (in bytes) used by an index over `kmer_count` k-mers.
+    static std::size_t memory(uint64_t kmer_count);
+
+    // Constructs the index over the `kmer_count` k-mers of the KMC database at path `kmc_db_path`,
+    // using up-to `thread_count` threads.
+    void construct(const std::string& kmc_db_path, uint64_t kmer_count, uint16_t thread_count);
+
+    // Returns the ID of the k-mer `kmer`; `absent` if it is not in the index.
+    uint64_t lookup(const Kmer<k>& kmer) const;
+
+    // Puts the IDs of the `n` k-mers at `kmers` into `ids`, prefetching their home slots in batches.
+    void lookup(const Kmer<k>* kmers, std::size_t n, uint64_t* ids) const;
+
+    // Returns whether the k-mer `kmer` is in the index.
+    bool contains(const Kmer<k>& kmer) const;
+
+    // Returns the total size (in bits) of the index.
+    uint64_t totalBitSize() const;
+};
+
+
+template <uint16_t k>
+inline uint64_t Direct_Kmer_Index<k>::home(const Kmer<k>& kmer) const
+{
+    return static_cast<uint64_t>((static_cast<__uint128_t>(kmer.to_u64()) * key.size()) >> 64);
+}
+
+
+template <uint16_t k>
+inline uint64_t Direct_Kmer_Index<k>::next(const uint64_t s) const
+{
+    return s + 1 == key.size() ? 0 : s + 1;
+}
+
+
+template <uint16_t k>
+inline uint64_t Direct_Kmer_Index<k>::lookup(const Kmer<k>& kmer) const
+{
+    for(uint64_t s = home(kmer); ; s = next(s))
+    {
+        const Block& b = block[s >> 6];
+        const uint64_t bit = (1ULL << (s & 63));
+        if(!(b.occupied & bit))
+            return absent;
+
+        if(key[s] == kmer)
+            return b.rank + __builtin_popcountll(b.occupied & (bit - 1));
+    }
+}
+
+
+template <uint16_t k>
+inline void Direct_Kmer_Index<k>::lookup(const Kmer<k>* const kmers, const std::size_t n, uint64_t* const ids) const
+{
+    constexpr std::size_t batch_sz = 16;
+
+    for(std::size_t i = 0; i < n; i += batch_sz)
+    {
+        const std::size_t batch_end = (i + batch_sz < n ? i + batch_sz : n);
+        for(std::size_t j = i; j < batch_end; ++j)
+        {
+            const uint64_t s = home(kmers[j]);
+            __builtin_prefetch(&block[s >> 6]);
+            __builtin_prefetch(&key[s]);
+        }
+
+        for(std::size_t j = i; j < batch_end; ++j)
+            ids[j] = lookup(kmers[j]);
+    }
+}
+
+
+template <uint16_t k>
+inline bool Direct_Kmer_Index<k>::contains(const Kmer<k>& kmer) const
+{
+    return lookup(kmer) != absent;
+}
+
+
+
+#endif
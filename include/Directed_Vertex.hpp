@@ -9,6 +9,7 @@
 #include "Kmer_Hash_Table.hpp"
 
 #include <cstdint>
+#include <limits>
 #include <iostream>
 
 
@@ -28,9 +29,25 @@ private:
     const Kmer<k>* kmer_hat_ptr;    // Pointer to the canonical form of the k-mer associated to the vertex.
     uint64_t h; // Hash value of the vertex, i.e. hash of the canonical k-mer.
 
+    // The orientation-independent minimizer of the vertex, maintained only with the minimizer
+    // layout of the hash table, so that its rolling does not recompute the minimizer per vertex.
+    typename Kmer<k>::minimizer_t min_lmer = 0;
+    uint16_t min_idx = 0;   // Index of the last base of the minimizer-window from the end of `kmer_`.
+
     // Initialize the data of the class once the observed k-mer `kmer_` is set.
     void init(const Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>& hash);
 
+    // Initialize the data of the class once the observed k-mer `kmer_` is set, except for the
+    // hash value of the vertex.
+    void init_forms();
+
+    // Computes the orientation-independent minimizer `min_lmer` of the vertex, and its window
+    // `min_idx`, from scratch. The latest window is picked among ties, to live the longest.
+    void compute_minimizer();
+
+    // Returns the hash value of the canonical k-mer of the vertex through the hash table `hash`.
+    uint64_t hash_canonical(const Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>& hash) const;
+
 
 public:
 
@@ -63,6 +80,17 @@ public:
     // and uses the hash table `hash` to get the hash value of the vertex.
     void from_suffix(const Kmer<k + 1>& e, const Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>& hash);
 
+    // Configures the vertex with the source (i.e. prefix) k-mer of the edge (k + 1)-mer `e`,
+    // leaving its hash value to be set with `set_hash`.
+    void from_prefix(const Kmer<k + 1>& e);
+
+    // Configures the vertex with the sink (i.e. suffix) k-mer of the edge (k + 1)-mer `e`,
+    // leaving its hash value to be set with `set_hash`.
+    void from_suffix(const Kmer<k + 1>& e);
+
+    // Sets the hash value of the vertex to `h`.
+    void set_hash(uint64_t h);
+
     // Returns the observed k-mer for the vertex.
     const Kmer<k>& kmer() const;
 
@@ -111,11 +139,48 @@ inline void Directed_Vertex<k>::init(const Kmer_Hash_Table<k, cuttlefish::BITS_P
     kmer_hat_ptr = Kmer<k>::canonical(kmer_, kmer_bar_);
     // 计算canonical的hash值,然后存入对象的属性中
     // TODO: 是否存入了hash表?
-    h = hash(*kmer_hat_ptr);
+    if(hash.minimizer_layout())
+        compute_minimizer();
+
+    h = hash_canonical(hash);
    // std::cout<<kmer_.string_label()<<"的hash值是"<<h<<std::endl;
 }
 
 
+template <uint16_t k>
+inline void Directed_Vertex<k>::init_forms()
+{
+    kmer_bar_.as_reverse_complement(kmer_);
+    kmer_hat_ptr = Kmer<k>::canonical(kmer_, kmer_bar_);
+}
+
+
+template <uint16_t k>
+inline void Directed_Vertex<k>::compute_minimizer()
+{
+    constexpr uint8_t l = Minimizer_MPHF<k>::l;
+
+    // The window ending at index `idx` from the end of `kmer_` ends at index `k - l - idx` from
+    // the end of `kmer_bar_`.
+    min_lmer = std::numeric_limits<typename Kmer<k>::minimizer_t>::max();
+    for(uint16_t idx = k - l + 1; idx-- > 0;)
+    {
+        const typename Kmer<k>::minimizer_t fwd = kmer_.template lmer_at<l>(idx);
+        const typename Kmer<k>::minimizer_t bwd = kmer_bar_.template lmer_at<l>(k - l - idx);
+        const typename Kmer<k>::minimizer_t lmer = (fwd < bwd ? fwd : bwd);
+        if(lmer <= min_lmer)
+            min_lmer = lmer, min_idx = idx;
+    }
+}
+
+
+template <uint16_t k>
+inline uint64_t Directed_Vertex<k>::hash_canonical(const Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>& hash) const
+{
+    return hash.minimizer_layout() ? hash.bucket_id(*kmer_hat_ptr, min_lmer) : hash(*kmer_hat_ptr);
+}
+
+
 template <uint16_t k>
 /**
  * @brief 构造有向顶点
@@ -137,7 +202,9 @@ inline Directed_Vertex<k>::Directed_Vertex(const Directed_Vertex<k>& rhs):
     kmer_(rhs.kmer_),
     kmer_bar_(rhs.kmer_bar_),
     kmer_hat_ptr(rhs.kmer_hat_ptr == &rhs.kmer_ ? &kmer_ : &kmer_bar_),
-    h(rhs.h)
+    h(rhs.h),
+    min_lmer(rhs.min_lmer),
+    min_idx(rhs.min_idx)
 {}
 
 
@@ -148,6 +215,8 @@ inline const Directed_Vertex<k>& Directed_Vertex<k>::operator=(const Directed_Ve
     kmer_bar_ = rhs.kmer_bar_;
     kmer_hat_ptr = (rhs.kmer_hat_ptr == &rhs.kmer_ ? &kmer_ : &kmer_bar_);
     h = rhs.h;
+    min_lmer = rhs.min_lmer;
+    min_idx = rhs.min_idx;
 
     return *this;
 }
@@ -192,6 +261,29 @@ inline void Directed_Vertex<k>::from_suffix(const Kmer<k + 1>& e, const Kmer_Has
 }
 
 
+template <uint16_t k>
+inline void Directed_Vertex<k>::from_prefix(const Kmer<k + 1>& e)
+{
+    kmer_.from_prefix(e);
+    init_forms();
+}
+
+
+template <uint16_t k>
+inline void Directed_Vertex<k>::from_suffix(const Kmer<k + 1>& e)
+{
+    kmer_.from_suffix(e);
+    init_forms();
+}
+
+
+template <uint16_t k>
+inline void Directed_Vertex<k>::set_hash(const uint64_t h)
+{
+    this->h = h;
+}
+
+
 template <uint16_t k>
 /**
  * @brief 获取 kmer 值
@@ -242,8 +334,28 @@ inline void Directed_Vertex<k>::roll_forward(const cuttlefish::base_t b, const K
     kmer_.roll_to_next_kmer(b, kmer_bar_);
     //比较获得 cannonical 的指针
     kmer_hat_ptr = Kmer<k>::canonical(kmer_, kmer_bar_);
+    // Roll the minimizer: the windows move one base away from the end of the k-mer, and the
+    // new last window joins, in both the orientations.
+    if(hash.minimizer_layout())
+    {
+        constexpr uint8_t l = Minimizer_MPHF<k>::l;
+
+        if(min_idx == k - l)    // The minimizer-window has been rolled out.
+            compute_minimizer();
+        else
+        {
+            min_idx++;
+
+            const typename Kmer<k>::minimizer_t fwd = kmer_.template lmer_at<l>(0);
+            const typename Kmer<k>::minimizer_t bwd = kmer_bar_.template lmer_at<l>(k - l);
+            const typename Kmer<k>::minimizer_t lmer = (fwd < bwd ? fwd : bwd);
+            if(lmer <= min_lmer)
+                min_lmer = lmer, min_idx = 0;
+        }
+    }
+
     //计算hash值
-    h = hash(*kmer_hat_ptr);
+    h = hash_canonical(hash);
 }
 
 
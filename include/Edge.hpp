@@ -51,6 +51,19 @@ public:
     // 配置边数据，即设置边缘实例的相关信息。使用哈希表` hash `来获取端点顶点的哈希值。必须在使用` e() `更新边缘(k + 1)-mer时使用。
     void configure(const Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>& hash);
 
+    // Configures the edge data similar to `configure`, but reuses the source endpoint `u` if the
+    // prefix k-mer of the edge is the same as the one of the last configured edge in this object.
+    // Returns `true` iff `u` is reused. Must be used only after some earlier configuration.
+    bool configure_reusing_prefix(const Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>& hash);
+
+    // Configures the edge data similar to `configure`, except for the hash values of the endpoint
+    // vertices, which are to be set with `set_hashes` — so that the hashes of a batch of edges
+    // can be computed together.
+    void configure();
+
+    // Sets the hash values of the source and the sink endpoint vertices to `h_u` and `h_v`.
+    void set_hashes(uint64_t h_u, uint64_t h_v);
+
     // Returns `true` iff the edge is a loop.
     bool is_loop() const;
 };
@@ -100,6 +113,32 @@ inline void Edge<k>::configure(const Kmer_Hash_Table<k, cuttlefish::BITS_PER_REA
 }
 
 
+template <uint16_t k>
+inline bool Edge<k>::configure_reusing_prefix(const Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>& hash)
+{
+    const bool same_prefix = u_.from_prefix_reusing(e_, hash);
+    v_.from_suffix(e_, hash);
+
+    return same_prefix;
+}
+
+
+template <uint16_t k>
+inline void Edge<k>::configure()
+{
+    u_.from_prefix(e_);
+    v_.from_suffix(e_);
+}
+
+
+template <uint16_t k>
+inline void Edge<k>::set_hashes(const uint64_t h_u, const uint64_t h_v)
+{
+    u_.set_hash(h_u);
+    v_.set_hash(h_v);
+}
+
+
 template <uint16_t k>
 inline bool Edge<k>::is_loop() const
 {
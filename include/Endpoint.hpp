@@ -62,10 +62,28 @@ public:
     // and uses the hash table `hash` to get the hash value of the vertex.
     void from_prefix(const Kmer<k + 1>& e, const Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>& hash);
 
+    // Configures the endpoint with the source (i.e. prefix) k-mer of the edge (k + 1)-mer `e`,
+    // similar to `from_prefix`; but if the prefix is the same k-mer that is observed for this
+    // endpoint already, then only the edge-encoding is updated and the hash table `hash` is not
+    // queried. Returns `true` iff the prefix was the same. Must be used only on endpoints that
+    // have been configured earlier.
+    bool from_prefix_reusing(const Kmer<k + 1>& e, const Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>& hash);
+
     // Configures the endpoint with the sink (i.e. suffix) k-mer of the edge (k + 1)-mer `e`;
     // and uses the hash table `hash` to get the hash value of the vertex.
     void from_suffix(const Kmer<k + 1>& e, const Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>& hash);
 
+    // Configures the endpoint with the source (i.e. prefix) k-mer of the edge (k + 1)-mer `e`,
+    // leaving the hash value of the vertex to be set with `set_hash`.
+    void from_prefix(const Kmer<k + 1>& e);
+
+    // Configures the endpoint with the sink (i.e. suffix) k-mer of the edge (k + 1)-mer `e`,
+    // leaving the hash value of the vertex to be set with `set_hash`.
+    void from_suffix(const Kmer<k + 1>& e);
+
+    // Sets the hash value of the vertex associated to this endpoint to `h`.
+    void set_hash(uint64_t h);
+
     // Returns the neighboring endpoint of this endpoint that's connected with an edge encoded
     // with the code `e`, from the point-of-view of this endpoint. Uses the hash table `hash`
     // to get the hash value of the corresponding neighbor vertex.
@@ -123,6 +141,24 @@ inline void Endpoint<k>::from_prefix(const Kmer<k + 1>& e, const Kmer_Hash_Table
 }
 
 
+template <uint16_t k>
+inline bool Endpoint<k>::from_prefix_reusing(const Kmer<k + 1>& e, const Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>& hash)
+{
+    Kmer<k> prefix;
+    prefix.from_prefix(e);
+
+    const bool same_prefix = (prefix == v.kmer());
+    if(!same_prefix)
+    {
+        v.from_kmer(prefix, hash);
+        s = exit_side();
+    }
+
+    this->e = exit_edge(e);
+    return same_prefix;
+}
+
+
 template <uint16_t k>
 /**
  * @brief 从后缀生成 Endpoint 对象
@@ -140,6 +176,33 @@ inline void Endpoint<k>::from_suffix(const Kmer<k + 1>& e, const Kmer_Hash_Table
     this->e = entrance_edge(e);
 }
 
+
+template <uint16_t k>
+inline void Endpoint<k>::from_prefix(const Kmer<k + 1>& e)
+{
+    v.from_prefix(e);
+
+    s = exit_side();
+    this->e = exit_edge(e);
+}
+
+
+template <uint16_t k>
+inline void Endpoint<k>::from_suffix(const Kmer<k + 1>& e)
+{
+    v.from_suffix(e);
+
+    s = entrance_side();
+    this->e = entrance_edge(e);
+}
+
+
+template <uint16_t k>
+inline void Endpoint<k>::set_hash(const uint64_t h)
+{
+    v.set_hash(h);
+}
+
 template <uint16_t k>
 /**
  * @brief 获取退出方向
@@ -15,7 +15,18 @@ namespace cuttlefish
         constexpr char buckets_ext[] = ".cf_hb";
         constexpr char unipaths_ext[] = ".fa";
         constexpr char json_ext[] = ".json";
+        constexpr char sink_json_ext[] = ".sink.json";
         constexpr char temp[] = ".cf_op";
+        constexpr char vertex_bucket_ext[] = ".cf_PV";
+        constexpr char edge_bucket_ext[] = ".cf_PE";
+        constexpr char fragments_ext[] = ".cf_PF";
+        constexpr char fragment_ends_ext[] = ".cf_PFE";
+        constexpr char group_bucket_ext[] = ".cf_G";
+        constexpr char long_walk_ext[] = ".cf_LW";
+        constexpr char long_walk_hash_ext[] = ".cf_LH";
+        constexpr char long_unitigs_ext[] = ".cf_LU";
+        constexpr char cycle_candidates_ext[] = ".cf_CC";
+        constexpr char job_dir_ext[] = ".cf_J";
         
         // For reference dBGs only:
 
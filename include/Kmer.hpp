@@ -6,9 +6,9 @@
 
 #include "DNA_Utility.hpp"
 #include "Kmer_Utility.hpp"
+#include "Kmer_W.hpp"
 #include "utility.hpp"
 #include "kmc_api/kmc_file.h"
-#include "xxHash/xxh3.h"
 
 #include <cstdint>
 #include <cstddef>
@@ -26,16 +26,23 @@
 #define ODD_K
 
 
+// The k-mer with the k-value `k` fixed at compile-time. Its words and the kernels over those are
+// of its width class, `Kmer_W`, shared by all the k-values with the same number of words.
 template <uint16_t k>
-class Kmer
+class Kmer: public Kmer_W<(k + 31) / 32>
 {
     // Make k-mers friend for (k + 1)-mer, so that de Bruijn graph vertices, i.e. k-mers,
     // may access private information (the raw data) from edges, i.e. (k + 1)-mers.
     friend class Kmer<k - 1>;
 
+public:
+
     // Minimizers can be represented using 32-bit integers.
     typedef uint32_t minimizer_t;
 
+    // The k-mer type of the width class of the k-mer, with the k-value at runtime.
+    typedef Kmer_W<(k + 31) / 32> width_t;
+
 private:
 
     // Number of 64-bit integers required to compactly represent the underlying k-mer with 2-bits/base encoding.
@@ -44,30 +51,9 @@ private:
     // Bitmask used to clear the most significant DNA base character, i.e. the first base of the k-mer which is at the bits `2k-1 : 2k-2`.
     static constexpr const uint64_t CLEAR_MSN_MASK = ~(uint64_t(0b11) << (2 * ((k - 1) % 32)));
 
-    // The underlying k-mer represented with 2-bit encoding, as a collection of
-    // 64-bit integers. A k-mer `n_{k - 1} ... n_1 n_0` is stored in the array
-    // `kmer_data` such that, `kmer_data[0]` stores the suffix `n_63 ... n_0`,
-    // then `kmer_data[1]` stores `n_127 ... n_64`, and so on. That is, the
-    // suffix is aligned with a byte boundary.
-    // TODO: reverse this store-order of the data — i.e. `n_{k - 1}` as the
-    // least significant base (so stored in `kmer_data[0]`) and `n_0` as the
-    // most significant base (so stored in `kmer_data[0]`). This would optimize
-    // at least the following:
-    //      i) `from_KMC_data` () — aligning with the KMC data alignment and
-    //      thus `memcpy` instead of bit-twiddling; ii) `operator<` — `memcmp`
-    //      instead of highest-to-lowest index looping comparison.
-    // 实际用于存储 kmer的数据,即uint64_t的数组~
-    uint64_t kmer_data[NUM_INTS];
-
-
-    // Left-shifts the collection of the bits at the `kmer_data` array by one base (2-bits).
-    void left_shift();
-
-    // Right-shifts the collection of the bits at the `kmer_data` array by one base (2-bits).
-    void right_shift();
-
-    // Left-shifts the collection of the bits at the `kmer_data` array by `B` bases (2B-bits).
-    template <uint16_t B> void left_shift();
+    using width_t::kmer_data;
+    using width_t::left_shift;
+    using width_t::right_shift;
 
 
 public:
@@ -102,6 +88,10 @@ public:
     // Returns a 64-bit hash value for the k-mer.
     uint64_t to_u64(uint64_t seed=0) const;
 
+    // Computes a 128-bit hash value for the k-mer with the seed `seed`, into its lower and higher
+    // 64-bit halves `lo` and `hi`.
+    void to_u128(uint64_t seed, uint64_t& lo, uint64_t& hi) const;
+
     // Gets the k-mer from the KMC api object `kmer_api`.
     void from_CKmerAPI(const CKmerAPI& kmer_api);
 
@@ -222,86 +212,31 @@ public:
     // Accumulates the counts of the l-mers of the k-mer into `count`.
     template <uint8_t l>
     void count_lmers(std::vector<uint64_t>& count) const;
-};
-
-
-template <uint16_t k>
-inline void Kmer<k>::left_shift()
-{
-    left_shift<1>();
-}
-
-
-template <uint16_t k>
-/**
- * @brief 将 Kmer 向右移动两位
- *
- * 将 Kmer 向右移动两位，通过循环遍历 kmer_data 数组，并将每个元素右移两位。
- * 同时，将下一个元素的最低两位左移 62 位，然后与前一个元素进行或运算。
- * 相当于整个数组向右移2位
- * @tparam k Kmer 的长度
- */
-inline void Kmer<k>::right_shift()
-{
-    constexpr uint64_t mask_LSN = 0b11;
 
-    for(uint16_t idx = 0; idx < NUM_INTS - 1; ++idx)
-    //idx >> 2位,然后idx+1 取最后2位 << 62位
-        kmer_data[idx] = (kmer_data[idx] >> 2) | ((kmer_data[idx + 1] & mask_LSN) << 62);
-
-    kmer_data[NUM_INTS - 1] >>= 2;
-}
+    // Returns the l-mer of the k-mer whose last base is at index `idx`
+    // from the end of the k-mer.
+    template <uint8_t l>
+    minimizer_t lmer_at(uint16_t idx) const;
+};
 
 
 template <uint16_t k>
-template <uint16_t B>
-inline void Kmer<k>::left_shift()
+inline uint64_t Kmer<k>::to_u64(const uint64_t seed) const
 {
-    static_assert(B < 32, "invalid bit-shift amount");
-
-    if constexpr(B != 0)
-    {
-        constexpr uint16_t num_bit_shift = 2 * B;
-        // if B = 1, mask_MSNs = 11 << 62
-        constexpr uint64_t mask_MSNs = ((static_cast<uint64_t>(1) << num_bit_shift) - 1) << (64 - num_bit_shift);
-        // idx的末尾62 bit 和 idx-1 的最高 2bit拼接
-        for(uint16_t idx = NUM_INTS - 1; idx > 0; --idx)
-            kmer_data[idx] = (kmer_data[idx] << num_bit_shift) | ((kmer_data[idx - 1] & mask_MSNs) >> (64 - num_bit_shift));
-
-        kmer_data[0] <<= num_bit_shift;
-    }
+    return width_t::to_u64(seed);
 }
 
 
 template <uint16_t k>
-/**
- * @brief 将 Kmer 转换为 64 位无符号整数
- *
- * 使用给定的种子值，将 Kmer 对象转换为 64 位无符号整数。
- *
- * @param seed 种子值
- *
- * @return 转换后的 64 位无符号整数
- */
-inline uint64_t Kmer<k>::to_u64(const uint64_t seed) const
+inline void Kmer<k>::to_u128(const uint64_t seed, uint64_t& lo, uint64_t& hi) const
 {
-    //k值向上取整自4的倍数
-    constexpr uint16_t NUM_BYTES = (k + 3) / 4;
-    /**
-在C++中，这段代码似乎是为了将一个长度为k的k-mer（即一个由k个核苷酸组成的序列）转换为一个64位无符号整数（uint64_t）。转换过程中使用了XXH3_64bits_withSeed函数，它可能是一个来自某个哈希库（如xxHash）的哈希函数。
-NUM_BYTES计算的是k-mer的字节长度。k-mer通常由DNA序列的核苷酸（A, C, G,
-T）组成，每个核苷酸可以编码为2比特信息（如果使用二进制编码）。因此，理论上一个k-mer需要的比特数是2
-* k。但是，在实际处理中，我们通常使用字节（8比特）作为数据的基本单位。 (k + 3) /
-4这个表达式是用来计算将k-mer转换为字节所需要的最少字节数。由于每个字节包含8比特，所以每个k-mer需要的字节数应该是2
-* k除以8。但是，由于我们不能有“部分字节”，所以我们需要向上取整来确保有足够的空间来存储整个k-mer。 (k + 3) / 4这个计算等同于(k + 7) / 8（因为除以4等于除以8然后乘以2，加上3等于加上7），后者是常见的向上取整到最接近的字节数的技巧。加7然后除以8确保了当k是8的倍数时，结果不会向下取整。然后，结果乘以2（因为k是按比特计算的，而我们需要字节），所以实际上是(k + 7) / 4。但在这个代码中，用了(k + 3) / 4，这实际上是一个简化，因为当k不是4的倍数时，结果仍然是正确的（向上取整到最近的4的倍数），但是当k是4的倍数时，它不会增加额外的字节。这可能是因为k-mer数据已经以某种方式确保了足够的存储，或者这个简化在上下文中是可以接受的。 简而言之，(k + 3) / 4是计算存储k-mer所需的最小字节数的近似值，并向上取整到最近的4的倍数。这种近似在某些情况下可能是可以接受的，尽管更精确的计算可能是(k + 7) / 8然后乘以2（转换为字节）。但需要注意的是，这里的解释假设k-mer的编码是以比特为基础的，并且每个核苷酸编码为2比特。实际实现可能有所不同，所以具体细节可能需要查看Kmer类的其余部分或相关文档。
-     */
-    return XXH3_64bits_withSeed(kmer_data, NUM_BYTES, seed);
+    width_t::to_u128(seed, lo, hi);
 }
 
 
 template <uint16_t k>
 inline Kmer<k>::Kmer():
-    kmer_data() // Value-initializes the data array, i.e. zeroes it out.
+    width_t()
 {}
 
 
@@ -349,16 +284,15 @@ inline Kmer<k>::Kmer(const CKmerAPI& kmer_api)
 
 
 template <uint16_t k>
-inline Kmer<k>::Kmer(const Kmer<k>& rhs)
-{
-    std::memcpy(kmer_data, rhs.kmer_data, NUM_INTS * sizeof(uint64_t));
-}
+inline Kmer<k>::Kmer(const Kmer<k>& rhs):
+    width_t(rhs)
+{}
 
 
 template <uint16_t k>
 inline Kmer<k>& Kmer<k>::operator=(const Kmer<k>& rhs)
 {
-    std::memcpy(kmer_data, rhs.kmer_data, NUM_INTS * sizeof(uint64_t));
+    width_t::operator=(rhs);
 
     return *this;
 }
@@ -456,70 +390,36 @@ inline Kmer<k> Kmer<k>::reverse_complement() const
 
 
 template <uint16_t k>
-/**
- * @brief 获取另一个Kmer的反向互补序列
- *
- * 将给定的Kmer对象的反向互补序列赋值给当前Kmer对象。
- * 在处理过程中，每次处理一个字节而不是64位整数。
- *
- * @param other 另一个Kmer对象
- */
 inline void Kmer<k>::as_reverse_complement(const Kmer<k>& other)
 {
-    // Working with bytes instead of 64-bit words at a time.
-
-    uint8_t* const rev_compl = reinterpret_cast<uint8_t*>(kmer_data);
-    const uint8_t* const data = reinterpret_cast<const uint8_t*>(other.kmer_data);
-
-
-    // Get the reverse complement for the fully packed bytes.
-
-    constexpr uint16_t packed_byte_count = k / 4;
-    for(uint16_t byte_idx = 0; byte_idx < packed_byte_count; ++byte_idx)
-        rev_compl[packed_byte_count - 1 - byte_idx] = Kmer_Utility::reverse_complement(data[byte_idx]);
-
-
-    // Get the reverse complement for the only byte that might be partially packed (possible for the highest-indexed byte only).
-
-    constexpr uint16_t rem_base_count = k % 4;
-    if constexpr(rem_base_count == 0)
+    if constexpr(NUM_INTS == 1)
+    {
+        kmer_data[0] = Kmer_Utility::reverse_complement_word<k>(other.kmer_data[0]);
         return;
-    
-    rev_compl[packed_byte_count] = 0;
-    left_shift<rem_base_count>();
+    }
 
-    for(int i = 0; i < rem_base_count; ++i)
-        rev_compl[0] |= (DNA_Utility::complement(DNA::Base((data[packed_byte_count] & (0b11 << (2 * i))) >> (2 * i)))
-                                        << (2 * (rem_base_count - 1 - i)));
+    width_t::as_reverse_complement(other, k);
 }
 
 
 template <uint16_t k>
 inline bool Kmer<k>::operator<(const Kmer<k>& rhs) const
 {
-    for(int16_t idx = NUM_INTS - 1; idx >= 0; --idx)
-        if(kmer_data[idx] != rhs.kmer_data[idx])
-            return kmer_data[idx] < rhs.kmer_data[idx];
-
-    return false;
+    return width_t::operator<(rhs);
 }
 
 
 template <uint16_t k>
 inline bool Kmer<k>::operator>(const Kmer<k>& rhs) const
 {
-    for(int16_t idx = NUM_INTS - 1; idx >= 0; --idx)
-        if(kmer_data[idx] != rhs.kmer_data[idx])
-            return kmer_data[idx] > rhs.kmer_data[idx];
-
-    return false;
+    return width_t::operator>(rhs);
 }
 
 
 template <uint16_t k>
 inline bool Kmer<k>::operator==(const Kmer<k>& rhs) const
 {
-    return std::memcmp(kmer_data, rhs.kmer_data, NUM_INTS * sizeof(uint64_t)) == 0;
+    return width_t::operator==(rhs);
 }
 
 
@@ -531,32 +431,16 @@ inline bool Kmer<k>::operator!=(const Kmer<k>& rhs) const
 
 
 template <uint16_t k>
-/**
- * @brief 获取Kmer对象的第一个碱基
- *
- * 获取Kmer对象的第一个碱基，即最高位的碱基。
- *
- * @return DNA::Base Kmer对象的第一个碱基
- */
 inline DNA::Base Kmer<k>::front() const
 {
-    // Relative index of the most significant nucleotide in it's 64-bit word.
-    constexpr uint16_t rel_idx_MSN = 2 * ((k - 1) % 32);
-
-    // Mask to extract the most significant nucleotide.
-    constexpr uint64_t mask_MSN = (static_cast<uint64_t>(0b11) << rel_idx_MSN);
-
-    return DNA::Base((kmer_data[NUM_INTS - 1] & mask_MSN) >> rel_idx_MSN);
+    return width_t::front(k);
 }
 
 
 template <uint16_t k>
 inline DNA::Base Kmer<k>::back() const
 {
-    // Mask to extract the least significant nucleotide.
-    constexpr uint64_t mask_LSN = static_cast<uint64_t>(0b11);
-
-    return DNA::Base(kmer_data[0] & mask_LSN);
+    return width_t::back();
 }
 
 
@@ -585,26 +469,9 @@ inline void Kmer<k>::roll_to_next_kmer(const char next_base, Kmer<k>& rev_compl)
 
 
 template <uint16_t k>
-/**
- * @brief 将当前Kmer滚动到下一个Kmer
- *
- * 将当前Kmer滚动到下一个Kmer，并更新其反向互补序列。
- *
- * @param base DNA碱基
- * @param rev_compl 反向互补序列的引用
- */
 inline void Kmer<k>::roll_to_next_kmer(const DNA::Base base, Kmer<k>& rev_compl)
 {
-    // Logically, since a left shift moves the MSN out of the length `k` boundary, the clearing of the base
-    // may seem redundant. But, the `to_u64` hashing method implementation works with bytes — not clearing
-    // out this base breaks the consistency of the hashing.
-    kmer_data[NUM_INTS - 1] &= CLEAR_MSN_MASK;
-    left_shift();
-    //整体左移2bit,然后 | base
-    kmer_data[0] |= base;
-    //整体右移2bit,然后 | base
-    rev_compl.right_shift();
-    rev_compl.kmer_data[NUM_INTS - 1] |= (static_cast<uint64_t>(DNA_Utility::complement(base)) << (2 * ((k - 1) & 31)));
+    width_t::roll_to_next_kmer(base, rev_compl, k);
 }
 
 
@@ -620,24 +487,14 @@ inline void Kmer<k>::roll_to_next_kmer(const DNA::Extended_Base edge, Kmer<k>& r
 template <uint16_t k>
 inline void Kmer<k>::roll_forward(const DNA::Extended_Base edge)
 {
-    const DNA::Base mapped_base = DNA_Utility::map_base(edge);
-
-    kmer_data[NUM_INTS - 1] &= CLEAR_MSN_MASK;
-    left_shift<1>();
-    kmer_data[0] |= static_cast<uint64_t>(mapped_base);
+    width_t::roll_forward(DNA_Utility::map_base(edge), k);
 }
 
 
 template <uint16_t k>
 inline void Kmer<k>::roll_backward(const DNA::Extended_Base edge)
 {
-    // Relative index of the most significant nucleotide in it's 64-bit word.
-    constexpr uint16_t rel_idx_MSN = 2 * ((k - 1) % 32);
-
-    const DNA::Base mapped_base = DNA_Utility::map_base(edge);
-
-    right_shift();
-    kmer_data[NUM_INTS - 1] |= (static_cast<uint64_t>(mapped_base) << rel_idx_MSN);
+    width_t::roll_backward(DNA_Utility::map_base(edge), k);
 }
 
 
@@ -658,6 +515,13 @@ inline Kmer<k> Kmer<k>::canonical() const
 template <uint16_t k>
 inline const Kmer<k>* Kmer<k>::canonical(const Kmer<k>& kmer, const Kmer<k>& rev_compl)
 {
+    // The choice between the two forms is unpredictable, so it is made branch-free for single-word k-mers.
+    if constexpr(NUM_INTS == 1)
+    {
+        const uintptr_t select = -static_cast<uintptr_t>(kmer.kmer_data[0] < rev_compl.kmer_data[0]);
+        return reinterpret_cast<const Kmer<k>*>((reinterpret_cast<uintptr_t>(&kmer) & select) | (reinterpret_cast<uintptr_t>(&rev_compl) & ~select));
+    }
+
     return kmer < rev_compl ? &kmer : &rev_compl;
 }
 
@@ -840,5 +704,20 @@ inline void Kmer<k>::count_lmers(std::vector<uint64_t>& count) const
 }
 
 
+template <uint16_t k>
+template <uint8_t l>
+inline typename Kmer<k>::minimizer_t Kmer<k>::lmer_at(const uint16_t idx) const
+{
+    const uint16_t word_idx = (idx >> 5);
+    const uint16_t base_idx = (idx & 31);
+
+    uint64_t lmer = kmer_data[word_idx] >> (2 * base_idx);
+    if(base_idx + l > 32 && word_idx + 1 < NUM_INTS)    // The l-mer straddles two words.
+        lmer |= kmer_data[word_idx + 1] << (2 * (32 - base_idx));
+
+    return lmer & ((1ULL << (2 * l)) - 1);
+}
+
+
 
 #endif
@@ -0,0 +1,279 @@
+
+#ifndef KMER_BUCKET_ITERATOR_HPP
+#define KMER_BUCKET_ITERATOR_HPP
+
+
+
+#include "Kmer.hpp"
+#include "Spin_Lock.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+
+
+// A multi-consumer iterator over a bucket of k-mers, i.e. a flat binary file of raw `Kmer<k>` records,
+// as produced by the minimizer-partitioning of the vertex and the edge sets. It exposes the same
+// consumer-side interface as `Kmer_SPMC_Iterator` so that it can be plugged into the BBHash
+// construction, but there is no dedicated producer thread: the consumers pull chunks of the bucket
+// off disk by themselves, with mutually exclusive access to the file.
+template <uint16_t k>
+class Kmer_Bucket_Iterator
+{
+    typedef Kmer_Bucket_Iterator iterator;
+
+
+private:
+
+    // Parsing data required for each consumer.
+    struct alignas(L1_CACHE_LINE_SIZE) Consumer_Buffer
+    {
+        std::vector<Kmer<k>> buf;   // Buffer for the k-mers read off the bucket.
+        std::size_t available;      // Number of k-mers present in the current buffer.
+        std::size_t parsed;         // Number of k-mers parsed from the current buffer.
+    };
+
+    static constexpr std::size_t BUF_SZ_PER_CONSUMER = (1 << 20);   // Size of the consumer-specific buffers (in bytes): 1 MB.
+    static constexpr std::size_t BUF_KMER_COUNT = BUF_SZ_PER_CONSUMER / sizeof(Kmer<k>);    // Number of k-mers fitting in a consumer-specific buffer.
+
+    const std::string bucket_path;  // Path to the bucket file.
+    const uint64_t kmer_count;  // Number of k-mers present in the bucket.
+    const uint64_t start;   // Index of the first k-mer of the bucket in its file.
+    const std::size_t consumer_count;   // Total number of consumer threads of the iterator.
+
+    uint64_t kmers_read;    // Number of raw k-mers read (off disk) by the iterator.
+
+    std::FILE* bucket{nullptr}; // The bucket file.
+    Spin_Lock lock; // Lock for mutually exclusive reads by the consumers off the bucket.
+    volatile bool depleted{false};  // Whether the bucket has been read off completely.
+
+    std::vector<Consumer_Buffer> consumer;  // Parsing data required for each consumer.
+
+
+    // Refills the buffer of the consumer with ID `consumer_id` from the bucket. Returns `false` iff
+    // the bucket has already been depleted.
+    bool refill(std::size_t consumer_id);
+
+
+public:
+
+    // Constructs an iterator for the bucket of `kmer_count` k-mers at path `bucket_path`, that would
+    // be consumed by `consumer_count` threads. Its position is at the beginning of the bucket if
+    // `at_begin` is `true`, and at the end if `at_end` is `true` — exactly one of them needs to be
+    // `true`. The bucket may be a range of the file, starting at its k-mer with index `start`.
+    Kmer_Bucket_Iterator(const std::string& bucket_path, uint64_t kmer_count, std::size_t consumer_count, bool at_begin = true, bool at_end = false, uint64_t start = 0);
+
+    // Copy constructs an iterator from another one `other`. The copy is not launched even if `other`
+    // has been.
+    Kmer_Bucket_Iterator(const iterator& other);
+
+    // Destructs the iterator.
+    ~Kmer_Bucket_Iterator();
+
+    // Copy assignment operator is deleted, as for `Kmer_SPMC_Iterator`.
+    iterator& operator=(const iterator& rhs) = delete;
+
+    // Tries to parse the next k-mer for the consumer with ID `consumer_id` into `kmer`. Returns
+    // `true` iff a k-mer could be parsed.
+    bool value_at(std::size_t consumer_id, Kmer<k>& kmer);
+
+    // Tries to parse the next k-mer for the consumer with ID `consumer_id` into `kmer`, in the form
+    // of its width class, i.e. as the keys of the MPHFs. Returns `true` iff a k-mer could be parsed.
+    bool value_at(std::size_t consumer_id, typename Kmer<k>::width_t& kmer);
+
+    // Returns `true` iff this and `rhs` are at the same position of the same bucket.
+    bool operator==(const iterator& rhs) const;
+
+    // Returns `true` iff this and `rhs` are not at the same position of the same bucket.
+    bool operator!=(const iterator& rhs) const;
+
+    // Opens the bucket and sets up the consumer buffers.
+    void launch_production();
+
+    // Returns whether the iteration has been launched.
+    bool launched() const;
+
+    // No producer exists to be waited on; present to conform to the `Kmer_SPMC_Iterator` interface.
+    void seize_production();
+
+    // Returns `true` iff the consumer with ID `consumer_id` may be provided more k-mers.
+    bool tasks_expected(std::size_t consumer_id) const;
+
+    // Returns the memory (in bytes) used by an iterator with `consumer_count` consumers.
+    static std::size_t memory(std::size_t consumer_count);
+
+    // Dummy methods.
+    const iterator& operator++() { return *this; }
+    Kmer<k> operator*() { return Kmer<k>(); }
+};
+
+
+template <uint16_t k>
+inline Kmer_Bucket_Iterator<k>::Kmer_Bucket_Iterator(const std::string& bucket_path, const uint64_t kmer_count, const std::size_t consumer_count, const bool at_begin, const bool at_end, const uint64_t start):
+    bucket_path(bucket_path),
+    kmer_count(kmer_count),
+    start(start),
+    consumer_count(consumer_count),
+    kmers_read(at_end ? kmer_count : 0)
+{
+    if(!(at_begin ^ at_end))
+    {
+        std::cerr << "Invalid position provided for k-mer bucket iterator construction. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+
+template <uint16_t k>
+inline Kmer_Bucket_Iterator<k>::Kmer_Bucket_Iterator(const iterator& other):
+    bucket_path(other.bucket_path),
+    kmer_count(other.kmer_count),
+    start(other.start),
+    consumer_count(other.consumer_count),
+    kmers_read(other.kmers_read)
+{}
+
+
+template <uint16_t k>
+inline Kmer_Bucket_Iterator<k>::~Kmer_Bucket_Iterator()
+{
+    if(bucket != nullptr)
+        std::fclose(bucket);
+}
+
+
+template <uint16_t k>
+inline void Kmer_Bucket_Iterator<k>::launch_production()
+{
+    if(launched())
+        return;
+
+    bucket = std::fopen(bucket_path.c_str(), "rb");
+    if(bucket == nullptr)
+    {
+        std::cerr << "Error opening k-mer bucket " << bucket_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    if(start > 0 && std::fseek(bucket, static_cast<long>(start * sizeof(Kmer<k>)), SEEK_SET) != 0)
+    {
+        std::cerr << "Error seeking into k-mer bucket " << bucket_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    consumer.resize(consumer_count);
+    for(auto& consumer_state: consumer)
+    {
+        consumer_state.buf.resize(BUF_KMER_COUNT);
+        consumer_state.available = consumer_state.parsed = 0;
+    }
+
+    depleted = (kmer_count == 0);
+}
+
+
+template <uint16_t k>
+inline bool Kmer_Bucket_Iterator<k>::launched() const
+{
+    return bucket != nullptr;
+}
+
+
+template <uint16_t k>
+inline void Kmer_Bucket_Iterator<k>::seize_production()
+{}
+
+
+template <uint16_t k>
+inline bool Kmer_Bucket_Iterator<k>::refill(const std::size_t consumer_id)
+{
+    auto& consumer_state = consumer[consumer_id];
+
+    lock.lock();
+
+    if(depleted)
+    {
+        lock.unlock();
+        return false;
+    }
+
+    // The bucket may be a range of its file, so the reads stop at its last k-mer.
+    const std::size_t to_read = std::min<uint64_t>(BUF_KMER_COUNT, kmer_count - kmers_read);
+    consumer_state.available = std::fread(consumer_state.buf.data(), sizeof(Kmer<k>), to_read, bucket);
+    consumer_state.parsed = 0;
+    kmers_read += consumer_state.available;
+
+    if(consumer_state.available < to_read)
+    {
+        std::cerr << "Error reading the k-mer bucket " << bucket_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    if(kmers_read == kmer_count)
+        depleted = true;
+
+    lock.unlock();
+
+    return consumer_state.available > 0;
+}
+
+
+template <uint16_t k>
+inline bool Kmer_Bucket_Iterator<k>::value_at(const std::size_t consumer_id, typename Kmer<k>::width_t& kmer)
+{
+    Kmer<k> kmer_k;
+    if(!value_at(consumer_id, kmer_k))
+        return false;
+
+    kmer = kmer_k;
+    return true;
+}
+
+
+template <uint16_t k>
+inline bool Kmer_Bucket_Iterator<k>::value_at(const std::size_t consumer_id, Kmer<k>& kmer)
+{
+    auto& consumer_state = consumer[consumer_id];
+    if(consumer_state.parsed == consumer_state.available && !refill(consumer_id))
+        return false;
+
+    kmer = consumer_state.buf[consumer_state.parsed++];
+    return true;
+}
+
+
+template <uint16_t k>
+inline bool Kmer_Bucket_Iterator<k>::operator==(const iterator& rhs) const
+{
+    return bucket_path == rhs.bucket_path && start == rhs.start && kmers_read == rhs.kmers_read;
+}
+
+
+template <uint16_t k>
+inline bool Kmer_Bucket_Iterator<k>::operator!=(const iterator& rhs) const
+{
+    return !operator==(rhs);
+}
+
+
+template <uint16_t k>
+inline bool Kmer_Bucket_Iterator<k>::tasks_expected(const std::size_t consumer_id) const
+{
+    return consumer[consumer_id].parsed < consumer[consumer_id].available || !depleted;
+}
+
+
+template <uint16_t k>
+inline std::size_t Kmer_Bucket_Iterator<k>::memory(const std::size_t consumer_count)
+{
+    return consumer_count * BUF_SZ_PER_CONSUMER;
+}
+
+
+
+#endif
@@ -0,0 +1,85 @@
+
+#ifndef KMER_DB_CACHE_HPP
+#define KMER_DB_CACHE_HPP
+
+
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <utility>
+
+
+// An in-memory cache of a k-mer database, to be shared by the passes over the database. The
+// k-mers are kept in the database's own compressed form: the raw binary suffixes, bucketed by
+// their prefixes, in the blocks read off disk by the SPMC iterators. The cache is filled during
+// the first pass over the database, and the later passes iterate over it in parallel from memory.
+class Kmer_DB_Cache
+{
+public:
+
+    // A block of raw binary k-mers.
+    struct Block
+    {
+        std::vector<uint8_t> suff;  // The raw binary suffixes of the k-mers.
+        std::vector<std::pair<uint64_t, uint64_t>> pref;    // The prefixes of the k-mers, in the form: <prefix, #corresponding_suffix>
+        uint64_t kmer_count;    // Number of k-mers in the block.
+    };
+
+
+private:
+
+    static std::string db_path_;    // Path prefix of the database to be cached; empty if none.
+    static std::size_t capacity_;   // Maximum memory (in bytes) to be used by the cache.
+    static std::size_t planned_;    // Memory (in bytes) planned for the cache: the size of the database's suffixes.
+    static std::size_t size_;   // Memory (in bytes) used by the cache.
+    static bool complete_;  // Whether the whole database has been cached.
+    static std::vector<Block> blocks_;  // The cached blocks.
+    static bool disabled_;  // Whether caching is disabled.
+
+
+public:
+
+    // Plans to cache the k-mer database at path prefix `db_path` in the next pass over it, if its
+    // suffixes fit into `capacity` bytes. Returns `true` iff the database is to be cached.
+    static bool plan(const std::string& db_path, std::size_t capacity);
+
+    // Disables caching, for the builds running concurrently in the process, as the cache is
+    // process-wide.
+    static void disable() { disabled_ = true; }
+
+    // Returns `true` iff the whole k-mer database at path prefix `db_path` is cached.
+    static bool cached(const std::string& db_path);
+
+    // Returns `true` iff the k-mer database at path prefix `db_path` is to be cached in the
+    // ongoing pass over it.
+    static bool filling(const std::string& db_path);
+
+    // Adds a block of `kmer_count` raw binary k-mers, with the suffixes `suff` of `suff_bytes`
+    // bytes and the prefixes `pref`, to the cache. The cache is abandoned if it grows beyond its
+    // capacity.
+    static void add(const uint8_t* suff, std::size_t suff_bytes, const std::vector<std::pair<uint64_t, uint64_t>>& pref, uint64_t kmer_count);
+
+    // Marks the cache as complete, i.e. the pass filling it has read the whole database.
+    static void complete();
+
+    // Returns the number of the cached blocks.
+    static std::size_t block_count() { return blocks_.size(); }
+
+    // Returns the `idx`'th cached block.
+    static const Block& block(std::size_t idx) { return blocks_[idx]; }
+
+    // Returns the memory (in bytes) planned for the cache; `0` if no database is to be cached.
+    static std::size_t planned_memory() { return planned_; }
+
+    // Returns the memory (in bytes) used by the cache.
+    static std::size_t memory() { return size_; }
+
+    // Drops the cache, releasing its memory.
+    static void clear();
+};
+
+
+
+#endif
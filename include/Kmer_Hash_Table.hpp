@@ -3,18 +3,27 @@
 #define KMER_HASH_TABLE_HPP
 
 #include "BBHash/BooPHF.h"
+#include "Direct_Kmer_Index.hpp"
 #include "Kmer.hpp"
 #include "Kmer_Hash_Entry_API.hpp"
 #include "Kmer_Hasher.hpp"
+#include "Minimizer_MPHF.hpp"
 #include "Sparse_Lock.hpp"
 #include "Spin_Lock.hpp"
 #include "State.hpp"
 #include "compact_vector/compact_vector.hpp"
 #include "globals.hpp"
+#ifdef CF_CONTENTION_STATS
+#include "Contention_Stats.hpp"
+#endif
 #include <boost/type_index.hpp>
+#include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <string>
+#include <vector>
+#include <algorithm>
 
 class Build_Params;
 
@@ -22,7 +31,7 @@ class Build_Params;
 template <uint16_t k, uint8_t BITS_PER_KEY>
 class Kmer_Hash_Table
 {
-    typedef boomphf::mphf<Kmer<k>, Kmer_Hasher<k>> mphf_t;    // The MPH function type.
+    typedef boomphf::mphf<typename Kmer<k>::width_t, Kmer_Hasher<Kmer<k>::width_t::word_count>> mphf_t;    // The MPH function type.
 
     typedef compact::ts_vector<cuttlefish::state_code_t, BITS_PER_KEY, uint64_t, std::allocator<uint64_t>> bitvector_t;
 
@@ -53,6 +62,10 @@ private:
     // The resolution of gamma that we support.
     static constexpr double gamma_resolution = 0.1;
 
+    // Magic number starting the saved MPHF files, followed by the k-mer hash scheme and the k-mer
+    // length that the MPHF has been built with, and whether it is in the minimizer layout.
+    static constexpr uint64_t mph_file_magic = 0x4850'4D5F'4643'0001ULL;
+
     // The gamma parameter of the BBHash function.
     // Lowest bits/elem is achieved with gamma = 1, higher values lead to larger mphf but faster construction/query.
     double gamma;
@@ -67,9 +80,21 @@ private:
     // TODO: Initialize with `std::nullptr`.
     mphf_t* mph = NULL;
 
+    // The locality-preserving MPH function, used in place of `mph` with the minimizer layout
+    // of the hash table (see `Minimizer_MPHF`).
+    Minimizer_MPHF<k>* minimizer_mph = NULL;
+
+    // The keyed index, used in place of `mph` for small sets of k-mers (see `Direct_Kmer_Index`).
+    Direct_Kmer_Index<k>* direct_index = NULL;
+
+    // Maximum memory (in bytes) to be used by the hash table.
+    std::size_t memory_budget = std::numeric_limits<std::size_t>::max();
+
     // The buckets collection (raw `State` representations) for the hash table
     // structure. Keys (`Kmer<k>`) are passed to the MPHF, and the resulting
-    // function-value is used as index into the buckets table.
+    // function-value is used as index into the buckets table. Allocated only once
+    // the MPHF is built, so as not to co-exist with the working memory of its
+    // construction.
     // 哈希表的桶
     bitvector_t hash_table;
 
@@ -85,18 +110,29 @@ private:
     // hash table does not incur more than `max_memory` bytes of space.
     void set_gamma(std::size_t max_memory);
 
+    // Allocates the (zeroed) hash table buckets for the k-mers.
+    void allocate_buckets();
+
     // Builds the minimal perfect hash function `mph` over the set of
     // k-mers present at the KMC database container `kmer_container`,
     // using `thread_count` number of threads. Uses the directory
     // at `working_dir_path` to store temporary files. If the MPHF is
     // found present at the file `mph_file_path`, then it is loaded
-    // instead.
+    // instead. If `minimizer_layout` is specified, then the locality-
+    // preserving `minimizer_mph` is built instead of `mph`.
     // 使用`thread_count`线程数，在KMC数据库容器`kmer_container`中的k-mers集合上构建最小完美哈希函数`mph`。使用`working_dir_path`目录来存储临时文件。如果MPHF存在于`mph_file_path`文件中，则加载它。
-    void build_mph_function(uint16_t thread_count, const std::string& working_dir_path, const std::string& mph_file_path);
+    void build_mph_function(uint16_t thread_count, const std::string& working_dir_path, const std::string& mph_file_path, bool minimizer_layout);
+
+    // Returns whether the keyed `direct_index` is to be used in place of an MPHF: for small sets
+    // of k-mers, whose index fits in the memory budget, when no MPHF is to be loaded or saved at
+    // `mph_file_path` and the minimizer layout is not asked for.
+    bool use_direct_index(const std::string& mph_file_path, bool save_mph, bool minimizer_layout) const;
 
-    // Loads an MPH function from the file at `file_path` into `mph`.
+    // Loads an MPH function from the file at `file_path` into `mph`, or into
+    // `minimizer_mph` if `minimizer_layout` is specified. Aborts if the file has
+    // been saved with a different k-mer hash scheme, k-mer length, or layout.
     // 从文件`file_path`加载一个MPH函数到` MPH `中。
-    void load_mph_function(const std::string& file_path);
+    void load_mph_function(const std::string& file_path, bool minimizer_layout);
 
     // Saves the MPH function `mph` into a file at `file_path`.
     // 将MPH函数` MPH `保存到`file_path`文件中。
@@ -130,13 +166,46 @@ public:
     // using up-to `thread_count` number of threads. The existence of an MPHF is
     // checked at the path `mph_file_path`—if found, it is loaded from the file.
     // If `save_mph` is specified, then the MPHF is saved into the file `mph_file_path`.
-    void construct(uint16_t thread_count, const std::string& working_dir_path, const std::string& mph_file_path, const bool save_mph = false);
+    // If `minimizer_layout` is specified, then the k-mers sharing minimizers are laid
+    // out in contiguous ranges of buckets (see `Minimizer_MPHF`). For small sets of
+    // k-mers, a keyed index is built instead of the MPHF (see `Direct_Kmer_Index`).
+    void construct(uint16_t thread_count, const std::string& working_dir_path, const std::string& mph_file_path, const bool save_mph = false, bool minimizer_layout = false);
+
+    // Constructs a minimal perfect hash function (specifically, the BBHash) for
+    // the collection of k-mers present at the raw k-mer bucket at path `kmc_db_path`
+    // (see `Kmer_Bucket_Iterator`), using up-to `thread_count` number of threads and
+    // the directory at `working_dir_path` for temporary files; and allocates the
+    // hash table buckets. Used for the partitions of the vertex set in the out-of-core
+    // construction.
+    void construct_over_bucket(uint16_t thread_count, const std::string& working_dir_path);
+
+    // Returns the minimum memory (in bytes) required by a hash table over `kmer_count` k-mers.
+    static std::size_t min_memory(uint64_t kmer_count);
 
     // Returns the id / number of the bucket in the hash table that is
     // supposed to store value items for the key `kmer`.
     // 实际就是返回哈希值
     uint64_t bucket_id(const Kmer<k>& kmer) const;
 
+    // Returns whether the hash table is in the minimizer layout, i.e. hashes through `minimizer_mph`.
+    bool minimizer_layout() const;
+
+    // Returns the id of the bucket for the key `kmer` whose orientation-independent minimizer is
+    // `minmzr`. Must be used only in the minimizer layout of the hash table.
+    uint64_t bucket_id(const Kmer<k>& kmer, typename Kmer<k>::minimizer_t minmzr) const;
+
+    // Puts the ids of the buckets for the `n` k-mers at `kmers` into `ids`, hashing the k-mers
+    // in batches.
+    void bucket_ids(const Kmer<k>* kmers, std::size_t n, uint64_t* ids) const;
+
+    // Returns whether the hash table answers membership queries exactly, i.e. is keyed through
+    // `direct_index`. An MPHF maps the k-mers not in its key set to arbitrary buckets.
+    bool has_exact_membership() const;
+
+    // Returns whether the k-mer `kmer` is in the key set of the hash table. Valid only if the
+    // table has exact membership.
+    bool contains(const Kmer<k>& kmer) const;
+
     // Returns the hash value of the k-mer `kmer`.
     // 实际是调用上面的函数
     uint64_t operator()(const Kmer<k>& kmer) const;
@@ -180,6 +249,23 @@ public:
     // `bucket_id` through the function `transform`.
     // 通过`transform`函数变换哈希表中ID为`bucket_id`的存储桶中的状态项。
     void update(uint64_t bucket_id, cuttlefish::state_code_t (*transform)(cuttlefish::state_code_t));
+
+    // Transforms the state-entries in the hash-table at the buckets with IDs in `bucket_ids` through
+    // the function `transform`. The buckets are grouped by their locks, so that each lock is
+    // acquired once for all its buckets. `bucket_ids` is sorted in place for the grouping; pass a
+    // scratch copy if its order is needed afterwards.
+    void update(std::vector<uint64_t>& bucket_ids, cuttlefish::state_code_t (*transform)(cuttlefish::state_code_t));
+
+    // Returns an API to the entry at the bucket with ID `bucket_id`, without any
+    // synchronization. Only to be used when the caller thread has exclusive access
+    // to the bucket, or when the hash table is not being updated at all.
+    Kmer_Hash_Entry_API<BITS_PER_KEY> at_exclusive(uint64_t bucket_id);
+
+    // Updates the entry (in the hash table) for the API object `api` to its wrapped
+    // state value, without any synchronization. Only to be used when the caller
+    // thread has exclusive access to the bucket, and to the buckets sharing its
+    // 64-bit word(s) with it.
+    void update_exclusive(Kmer_Hash_Entry_API<BITS_PER_KEY>& api);
     
     // Attempts to update the hash table entries for the API objects `api_1` and
     // `api_2` concurrently, i.e. both the updates need to happen in a tied manner
@@ -229,7 +315,60 @@ template <uint16_t k, uint8_t BITS_PER_KEY>
  */
 inline uint64_t Kmer_Hash_Table<k, BITS_PER_KEY>::bucket_id(const Kmer<k>& kmer) const
 {
-    return mph->lookup(kmer);
+#ifdef CF_CONTENTION_STATS
+    Contention_Stats::count_lookup();
+#endif
+    return direct_index != NULL ? direct_index->lookup(kmer) :
+            minimizer_mph != NULL ? minimizer_mph->lookup(kmer) : mph->lookup(kmer);
+}
+
+
+template <uint16_t k, uint8_t BITS_PER_KEY>
+inline bool Kmer_Hash_Table<k, BITS_PER_KEY>::minimizer_layout() const
+{
+    return minimizer_mph != NULL;
+}
+
+
+template <uint16_t k, uint8_t BITS_PER_KEY>
+inline bool Kmer_Hash_Table<k, BITS_PER_KEY>::has_exact_membership() const
+{
+    return direct_index != NULL;
+}
+
+
+template <uint16_t k, uint8_t BITS_PER_KEY>
+inline bool Kmer_Hash_Table<k, BITS_PER_KEY>::contains(const Kmer<k>& kmer) const
+{
+    assert(has_exact_membership());
+    return direct_index->contains(kmer);
+}
+
+
+template <uint16_t k, uint8_t BITS_PER_KEY>
+inline uint64_t Kmer_Hash_Table<k, BITS_PER_KEY>::bucket_id(const Kmer<k>& kmer, const typename Kmer<k>::minimizer_t minmzr) const
+{
+#ifdef CF_CONTENTION_STATS
+    Contention_Stats::count_lookup();
+#endif
+    return minimizer_mph->lookup(kmer, minmzr);
+}
+
+
+template <uint16_t k, uint8_t BITS_PER_KEY>
+inline void Kmer_Hash_Table<k, BITS_PER_KEY>::bucket_ids(const Kmer<k>* const kmers, const std::size_t n, uint64_t* const ids) const
+{
+#ifdef CF_CONTENTION_STATS
+    for(std::size_t i = 0; i < n; ++i)
+        Contention_Stats::count_lookup();
+#endif
+    if(direct_index != NULL)
+        direct_index->lookup(kmers, n, ids);
+    else if(minimizer_mph != NULL)
+        for(std::size_t i = 0; i < n; ++i)
+            ids[i] = minimizer_mph->lookup(kmers[i]);
+    else
+        mph->lookup(kmers, n, ids);
 }
 
 
@@ -351,6 +490,9 @@ inline bool Kmer_Hash_Table<k, BITS_PER_KEY>::update(Kmer_Hash_Entry_API<BITS_PE
     if(success)//说明api的bv_entry = state_read,使用state_更新bv_entry
         api.bv_entry = api.get_current_state();
     sparse_lock.unlock(bucket);
+#ifdef CF_CONTENTION_STATS
+    Contention_Stats::count_update(success);
+#endif
     // api.bv_entry != api.get_read_state() 会一直循环
     return success;
 }
@@ -391,6 +533,45 @@ inline void Kmer_Hash_Table<k, BITS_PER_KEY>::update(
   sparse_lock.unlock(bucket_id);
 }
 
+template <uint16_t k, uint8_t BITS_PER_KEY>
+inline void Kmer_Hash_Table<k, BITS_PER_KEY>::update(std::vector<uint64_t>& bucket_ids, cuttlefish::state_code_t (*const transform)(cuttlefish::state_code_t))
+{
+    constexpr std::size_t prefetch_dist = 16;   // Number of buckets ahead to prefetch the words of.
+
+    std::sort(bucket_ids.begin(), bucket_ids.end());
+
+    const std::size_t n = bucket_ids.size();
+    for(std::size_t i = 0; i < n; )
+    {
+        const uint64_t run_bucket = bucket_ids[i];  // A bucket of the run guarded by the current lock.
+
+        sparse_lock.lock(run_bucket);
+        for(; i < n && sparse_lock.same_lock(run_bucket, bucket_ids[i]); ++i)
+        {
+            if(i + prefetch_dist < n)
+                __builtin_prefetch(hash_table.get() + (bucket_ids[i + prefetch_dist] * BITS_PER_KEY) / 64, 1);
+
+            hash_table[bucket_ids[i]] = transform(hash_table[bucket_ids[i]]);
+        }
+        sparse_lock.unlock(run_bucket);
+    }
+}
+
+
+template <uint16_t k, uint8_t BITS_PER_KEY>
+inline Kmer_Hash_Entry_API<BITS_PER_KEY> Kmer_Hash_Table<k, BITS_PER_KEY>::at_exclusive(const uint64_t bucket_id)
+{
+    return Kmer_Hash_Entry_API<BITS_PER_KEY>(hash_table[bucket_id]);
+}
+
+
+template <uint16_t k, uint8_t BITS_PER_KEY>
+inline void Kmer_Hash_Table<k, BITS_PER_KEY>::update_exclusive(Kmer_Hash_Entry_API<BITS_PER_KEY>& api)
+{
+    api.bv_entry = api.get_current_state();
+}
+
+
 template <uint16_t k, uint8_t BITS_PER_KEY>
 inline bool Kmer_Hash_Table<k, BITS_PER_KEY>::update_concurrent(Kmer_Hash_Entry_API<BITS_PER_KEY>& api_1, Kmer_Hash_Entry_API<BITS_PER_KEY>& api_2)
 {
@@ -4,19 +4,33 @@
 
 
 
-#include "Kmer.hpp"
+#include "Kmer_W.hpp"
 
 #include <cstdint>
+#include <cstddef>
 
 
-template <uint16_t k>
+// Hasher of the k-mers of the width class of `NUM_INTS` words, i.e. over `Kmer_W<NUM_INTS>`.
+// The hashes are over the words of the k-mers only, so the hasher, and the MPHFs using it, are
+// shared by all the k-values of the width class.
+template <uint16_t NUM_INTS>
 class Kmer_Hasher
 {
 public:
 
+    // Version of the hashes over the k-mers. The saved MPHFs are stamped with it, as they are only
+    // valid over the hashes they were built with; it is to be bumped with any change to these.
+    // Version 2 mixes the single word of the k-mers with `k <= 32`, in place of XXH3; version 3
+    // takes both the level-hashes of the k-mers with `k > 32` from one 128-bit XXH3 hash; version
+    // 4 hashes all the words of the k-mers with `k > 32`, not just the bytes spanned by the k bases;
+    // version 5 derives the second level-hash of the k-mers with `k <= 32` from the first one.
+    static constexpr uint32_t scheme = (NUM_INTS == 1 ? 5 : 4);
+
     // Adopted from the BBHash library.
     // Ref: https://github.com/rizkg/BBHash/blob/48a854a378bce4e2fe4d4cd63bfe5e4f8755dc6e/BooPHF.h#L393
-    uint64_t operator()(const Kmer<k>& key, uint64_t seed = 0xAAAAAAAA55555555ULL) const
+    // For `k <= 32`, the k-mer is hashed through an integer mixer over its only word; the distinct
+    // seeds passed per MPHF level keep the levels' hash functions independent.
+    uint64_t operator()(const Kmer_W<NUM_INTS>& key, uint64_t seed = 0xAAAAAAAA55555555ULL) const
     {
         return key.to_u64(seed);
         /*
@@ -34,6 +48,28 @@ public:
         return hash;
         */
     }
+
+    // Computes the two hashes `h0` and `h1` of the key `key` that seed the xorshift state of the
+    // BBHash levels. For `k <= 32`, the word is mixed once, and `h1` is remixed off `h0`; for
+    // `k > 32`, both are taken from a single 128-bit hash of the key.
+    void hash_pair(const Kmer_W<NUM_INTS>& key, uint64_t& h0, uint64_t& h1) const
+    {
+        if constexpr(NUM_INTS == 1)
+            h0 = key.to_u64(0xAAAAAAAA55555555ULL), h1 = Kmer_Utility::remix(h0);
+        else
+            key.to_u128(0xAAAAAAAA55555555ULL, h0, h1);
+    }
+
+    // Computes the hash pairs of the `n` keys at `keys` into `h0` and `h1`, as with `hash_pair`.
+    // For `k <= 32`, the loop is branch-free over contiguous words, and is vectorized by the
+    // compiler where the target has 64-bit vector multiplies (AVX-512DQ); it is not hand-written
+    // with intrinsics, as the hashing is ~2 ns per key on scalar code, against a cache-miss per key
+    // of the lookups that it feeds, and AVX2, lacking those multiplies, measured no faster.
+    void hash_pairs(const Kmer_W<NUM_INTS>* const keys, const std::size_t n, uint64_t* const h0, uint64_t* const h1) const
+    {
+        for(std::size_t i = 0; i < n; ++i)
+            hash_pair(keys[i], h0[i], h1[i]);
+    }
 };
 
 
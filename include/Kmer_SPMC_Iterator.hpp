@@ -7,6 +7,9 @@
 #include "Kmer.hpp"
 #include "Kmer_Container.hpp"
 #include "kmc_api/kmc_file.h"
+#include "Trace.hpp"
+#include "Memory_Budget.hpp"
+#include "Kmer_DB_Cache.hpp"
 
 #include <cstdint>
 #include <cstddef>
@@ -28,11 +31,13 @@ struct alignas(L1_CACHE_LINE_SIZE)
     Consumer_Data
 {
     uint8_t* suff_buf{nullptr}; // Buffer for the raw binary suffixes of the k-mers.
+    const uint8_t* suff{nullptr};   // The raw binary suffixes being parsed: from the buffer, or from a cached block.
     uint64_t kmers_available;   // Number of k-mers present in the current buffer.
     uint64_t kmers_parsed;      // Number of k-mers parsed from the current buffers.
     std::vector<std::pair<uint64_t, uint64_t>> pref_buf;    // Buffer for the raw binary prefixes of the k-mers, in the form: <prefix, #corresponding_suffix>
     // 指向开始解析k-mers的前缀的指针。
     std::vector<std::pair<uint64_t, uint64_t>>::iterator pref_it;   // Pointer to the prefix to start parsing k-mers from.
+    uint64_t wait_begin{0};     // Time when the consumer started waiting for k-mers; `0` if not traced.
     // uint64_t pad_[1];           // Padding to avoid false-sharing.
 };
 
@@ -53,12 +58,14 @@ private:
 
     const uint64_t kmer_count;  // Number of k-mers present in the underlying database.
     const size_t consumer_count;  // Total number of consumer threads of the iterator.
+    const size_t buf_sz_per_consumer;   // Size of the consumer-specific buffers (in bytes), as planned by the memory budget.
 
     uint64_t kmers_read;    // Number of raw k-mers read (off disk) by the iterator.
 
-    std::unique_ptr<std::thread> reader{nullptr};   // The thread doing the actual disk-read of the binary data, i.e. the producer thread.
+    bool from_cache{false}; // Whether the k-mers are read from the in-memory cache of the database.
+    bool to_cache{false};   // Whether the k-mers read off disk are to be cached.
 
-    static constexpr size_t BUF_SZ_PER_CONSUMER = (1 << 24);   // Size of the consumer-specific buffers (in bytes): 16 MB.
+    std::unique_ptr<std::thread> reader{nullptr};   // The thread doing the actual disk-read of the binary data, i.e. the producer thread.
 
     std::vector<Consumer_Data> consumer;   // Parsing data required for each consumer.
 
@@ -84,6 +91,10 @@ private:
     // has been depleted.
     void read_raw_kmers();
 
+    // Makes the raw binary k-mers of the in-memory cache of the database available for
+    // consumer threads, block by block.
+    void read_cached_kmers();
+
     // Returns the id (number) of an idle consumer thread.
     size_t get_idle_consumer() const;
 
@@ -112,6 +123,10 @@ public:
     // Returns `true` iff it's successful, i.e. k-mers were remaining for this consumer.
     bool value_at(size_t consumer_id, Kmer<k>& kmer);
 
+    // Tries to parse the next k-mer for the consumer with ID `consumer_id` into `kmer`, in the form
+    // of its width class, i.e. as the keys of the MPHFs. Returns `true` iff a k-mer could be parsed.
+    bool value_at(size_t consumer_id, typename Kmer<k>::width_t& kmer);
+
     // Returns `true` iff this and `rhs` — both the iterators refer to the same container and
     // the same number of raw k-mers have been read (from disk) for both.
     bool operator==(const iterator& rhs) const;
@@ -166,6 +181,7 @@ inline Kmer_SPMC_Iterator<k>::Kmer_SPMC_Iterator(const Kmer_Container<k>* const
     kmer_container(kmer_container),
     kmer_count{kmer_container->size()},
     consumer_count{consumer_count},
+    buf_sz_per_consumer{Memory_Budget::parser_buffer_size()},
     kmers_read{at_end ? kmer_count : 0}
 {
   // ^: 不同为1相同为0
@@ -183,6 +199,7 @@ inline Kmer_SPMC_Iterator<k>::Kmer_SPMC_Iterator(const iterator& other):
     kmer_container(other.kmer_container),
     kmer_count{other.kmer_count},
     consumer_count{other.consumer_count},
+    buf_sz_per_consumer{other.buf_sz_per_consumer},
     kmers_read{other.kmers_read}
 {}
 
@@ -252,6 +269,8 @@ inline void Kmer_SPMC_Iterator<k>::launch_production()
     // 每个消费者线程创建对应状态,构成数组
     // 线程的状态读取需要从内存读取,不允许优化
     task_status = new volatile Task_Status[consumer_count];
+    from_cache = Kmer_DB_Cache::cached(kmer_container->container_location());
+    to_cache = (!from_cache && Kmer_DB_Cache::filling(kmer_container->container_location()));
     // 将consumer vector的容量设置为consumer_count
     // 里面为空值
     consumer.resize(consumer_count);
@@ -259,11 +278,12 @@ inline void Kmer_SPMC_Iterator<k>::launch_production()
     for(size_t id = 0; id < consumer_count; ++id)
     {
         auto& consumer_state = consumer[id];
-        consumer_state.suff_buf = new uint8_t[BUF_SZ_PER_CONSUMER];
+        consumer_state.suff_buf = (from_cache ? nullptr : new uint8_t[buf_sz_per_consumer]);
         consumer_state.kmers_available = 0;
         consumer_state.kmers_parsed = 0;
         consumer_state.pref_buf.clear();
         consumer_state.pref_it = consumer_state.pref_buf.begin();
+        consumer_state.wait_begin = (Trace::enabled() ? Trace::now() : 0);
         task_status[id] = Task_Status::pending;//等待读取kmer
     }
 
@@ -281,7 +301,10 @@ inline void Kmer_SPMC_Iterator<k>::launch_production()
     reader.reset(
         new std::thread([this]()
             {
-                read_raw_kmers();
+                if(from_cache)
+                    read_cached_kmers();
+                else
+                    read_raw_kmers();
             }
         )
     );
@@ -313,12 +336,20 @@ inline void Kmer_SPMC_Iterator<k>::read_raw_kmers()
     while(!kmer_database.Eof())
     {
         // 找到空闲线程
-        const size_t consumer_id = get_idle_consumer();
+        size_t consumer_id;
+        {
+            const Trace_Span span("SPMC producer wait");
+            consumer_id = get_idle_consumer();
+        }
+
         Consumer_Data& consumer_state = consumer[consumer_id];
         // 这里返回成功读取的kmer个数
-        consumer_state.kmers_available = kmer_database.read_raw_suffixes(consumer_state.suff_buf, consumer_state.pref_buf, BUF_SZ_PER_CONSUMER);
+        {
+            const Trace_Span span("SPMC fill");
+            consumer_state.kmers_available = kmer_database.read_raw_suffixes(consumer_state.suff_buf, consumer_state.pref_buf, buf_sz_per_consumer);
+        }
+
        // printf("生产者线程给予的当前的线程是%lu,读取的kmer个数是%lu\n", consumer_id, consumer_state.kmers_available);
-        consumer_state.pref_it = consumer_state.pref_buf.begin();
 //1462169
         if(!consumer_state.kmers_available)
         {
@@ -326,6 +357,41 @@ inline void Kmer_SPMC_Iterator<k>::read_raw_kmers()
             std::exit(EXIT_FAILURE);
         }
 
+        if(to_cache)
+            Kmer_DB_Cache::add(consumer_state.suff_buf, consumer_state.kmers_available * kmer_database.suff_record_size(), consumer_state.pref_buf, consumer_state.kmers_available);
+
+        consumer_state.suff = consumer_state.suff_buf;
+        consumer_state.pref_it = consumer_state.pref_buf.begin();
+        kmers_read += consumer_state.kmers_available;
+
+        consumer_state.kmers_parsed = 0;
+        task_status[consumer_id] = Task_Status::available;
+    }
+
+    if(to_cache)
+        Kmer_DB_Cache::complete();
+}
+
+
+template <uint16_t k>
+inline void Kmer_SPMC_Iterator<k>::read_cached_kmers()
+{
+    for(std::size_t block_idx = 0; block_idx < Kmer_DB_Cache::block_count(); ++block_idx)
+    {
+        size_t consumer_id;
+        {
+            const Trace_Span span("SPMC producer wait");
+            consumer_id = get_idle_consumer();
+        }
+
+        // The consumer parses the suffixes right from the cache; only the prefixes are copied over,
+        // as the parsing advances through those.
+        const Kmer_DB_Cache::Block& block = Kmer_DB_Cache::block(block_idx);
+        Consumer_Data& consumer_state = consumer[consumer_id];
+        consumer_state.suff = block.suff.data();
+        consumer_state.pref_buf = block.pref;
+        consumer_state.pref_it = consumer_state.pref_buf.begin();
+        consumer_state.kmers_available = block.kmer_count;
         kmers_read += consumer_state.kmers_available;
 
         consumer_state.kmers_parsed = 0;
@@ -392,6 +458,18 @@ inline void Kmer_SPMC_Iterator<k>::seize_production()
 }
 
 
+template <uint16_t k>
+inline bool Kmer_SPMC_Iterator<k>::value_at(const size_t consumer_id, typename Kmer<k>::width_t& kmer)
+{
+    Kmer<k> kmer_k;
+    if(!value_at(consumer_id, kmer_k))
+        return false;
+
+    kmer = kmer_k;
+    return true;
+}
+
+
 template <uint16_t k>
 /**
  * @brief 获取指定消费者的 Kmer 值
@@ -414,11 +492,19 @@ inline bool Kmer_SPMC_Iterator<k>::value_at(const size_t consumer_id, Kmer<k>& k
     auto& ts = consumer[consumer_id];
     if(ts.kmers_parsed == ts.kmers_available)
     {
+        ts.wait_begin = (Trace::enabled() ? Trace::now() : 0);
         task_status[consumer_id] = Task_Status::pending;
         return false;
     }
+
+    if(ts.kmers_parsed == 0 && ts.wait_begin > 0)   // The wait for this buffer is over.
+    {
+        Trace::record("SPMC consumer wait", ts.wait_begin, Trace::now());
+        ts.wait_begin = 0;
+    }
+
   //  printf("consumer_id: %lu\n", consumer_id);
-    kmer_database.parse_kmer_buf<k>(ts.pref_it, ts.suff_buf, ts.kmers_parsed * kmer_database.suff_record_size(), kmer);
+    kmer_database.parse_kmer_buf<k>(ts.pref_it, ts.suff, ts.kmers_parsed * kmer_database.suff_record_size(), kmer);
     ts.kmers_parsed++;
 
     return true;
@@ -483,14 +569,14 @@ inline bool Kmer_SPMC_Iterator<k>::task_available(const size_t consumer_id) cons
 template <uint16_t k>
 inline std::size_t Kmer_SPMC_Iterator<k>::memory() const
 {
-    return CKMC_DB::pref_buf_memory() + (consumer_count * BUF_SZ_PER_CONSUMER);
+    return CKMC_DB::pref_buf_memory() + (from_cache ? 0 : consumer_count * buf_sz_per_consumer);
 }
 
 
 template <uint16_t k>
 inline std::size_t Kmer_SPMC_Iterator<k>::memory(const std::size_t consumer_count)
 {
-    return CKMC_DB::pref_buf_memory() + (consumer_count * BUF_SZ_PER_CONSUMER);
+    return CKMC_DB::pref_buf_memory() + (consumer_count * Memory_Budget::parser_buffer_size());
 }
 
 
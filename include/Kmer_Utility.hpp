@@ -48,6 +48,19 @@ public:
     // Returns the binary encoding word of the literal k-mer `label`.
     template <uint16_t k>
     static uint64_t encode(const char* label);
+
+    // Returns the reverse complement of the k-mer `word` with `k <= 32` bases, both in the
+    // `DNA::Base` representation, computed in registers.
+    template <uint16_t k>
+    static uint64_t reverse_complement_word(uint64_t word);
+
+    // Returns a 64-bit hash of the word `word` with the seed `seed`, through multiply-xorshift
+    // mixing; different seeds yield independent hash functions.
+    static uint64_t mix(uint64_t word, uint64_t seed);
+
+    // Returns a second 64-bit hash derived from the hash `hash` of `mix`, through a single
+    // multiply-xorshift round; cheaper than a second `mix` with another seed.
+    static uint64_t remix(uint64_t hash);
 };
 
 
@@ -63,5 +76,43 @@ inline uint64_t Kmer_Utility::encode(const char* const label)
 }
 
 
+template <uint16_t k>
+inline uint64_t Kmer_Utility::reverse_complement_word(uint64_t word)
+{
+    static_assert(0 < k && k <= 32, "invalid k-mer length for machine word reverse complement");
+
+    word = ~word;   // The complement of a base `b` is `3 - b`, i.e. `b` with its bits flipped.
+
+    // Reverse the order of the 2-bit bases: swap the bases in each nibble, then the nibbles in each
+    // byte, then the bytes.
+    word = ((word >> 2) & 0x3333333333333333ULL) | ((word & 0x3333333333333333ULL) << 2);
+    word = ((word >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((word & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    word = __builtin_bswap64(word);
+
+    return word >> (64 - 2 * k);
+}
+
+
+inline uint64_t Kmer_Utility::mix(uint64_t word, const uint64_t seed)
+{
+    // The finalizer of SplitMix64, over the word whitened with the seed.
+    word ^= seed * 0x9E3779B97F4A7C15ULL;
+    word = (word ^ (word >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    word = (word ^ (word >> 27)) * 0x94D049BB133111EBULL;
+
+    return word ^ (word >> 31);
+}
+
+
+inline uint64_t Kmer_Utility::remix(uint64_t hash)
+{
+    // `hash` is avalanched already; the round folds its higher half into the lower one and spreads
+    // it back over the higher bits, which are the ones the MPHF levels range-reduce with.
+    hash = (hash ^ (hash >> 32)) * 0xD6E8FEB86659FD93ULL;
+
+    return hash ^ (hash >> 32);
+}
+
+
 
 #endif
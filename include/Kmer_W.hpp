@@ -0,0 +1,288 @@
+#ifndef KMER_W_HPP
+#define KMER_W_HPP
+
+
+
+#include "DNA_Utility.hpp"
+#include "Kmer_Utility.hpp"
+#include "xxHash/xxh3.h"
+
+#include <cstdint>
+#include <cstring>
+
+
+// A k-mer of the width class of `NUM_INTS` 64-bit words, i.e. of any k-value in
+// `(32 * (NUM_INTS - 1), 32 * NUM_INTS]`. The k-value is not a part of the type:
+// the kernels depending on it take it at runtime. Thus the code working over just
+// the words of the k-mers — the hashing, the MPHFs over the k-mers, and the rolls
+// and the reverse complements of the walks — is specialized once per width class,
+// not once per k-value. `Kmer<k>` is the k-mer of its width class with the k-value
+// fixed at compile-time.
+//
+// The k-mer `n_{k - 1} ... n_1 n_0` is stored such that `kmer_data[0]` stores the
+// suffix `n_31 ... n_0`, `kmer_data[1]` stores `n_63 ... n_32`, and so on. The bits
+// past the `2k` bits of the k-mer are always zero; so the k-mer can be hashed and
+// compared over its words only, independent of its k-value.
+template <uint16_t NUM_INTS>
+class Kmer_W
+{
+    static_assert(NUM_INTS > 0, "invalid word count for k-mers");
+
+public:
+
+    // Number of 64-bit words of the k-mers of the width class.
+    static constexpr uint16_t word_count = NUM_INTS;
+
+protected:
+
+    // The underlying k-mer represented with 2-bit encoding, as a collection of 64-bit integers.
+    uint64_t kmer_data[NUM_INTS];
+
+
+    // Left-shifts the collection of the bits at the `kmer_data` array by one base (2-bits).
+    void left_shift();
+
+    // Right-shifts the collection of the bits at the `kmer_data` array by one base (2-bits).
+    void right_shift();
+
+    // Right-shifts the collection of the bits at the `kmer_data` array by `b` bits, `b < 64`.
+    void right_shift_bits(uint16_t b);
+
+    // Returns the bit-index of the most significant nucleotide of a k-mer with the k-value `k`,
+    // in its highest-indexed word.
+    static uint16_t MSN_shift(uint16_t k);
+
+
+public:
+
+    // Default constructs the k-mer with a 0-value, equivalent to "AA...A".
+    Kmer_W();
+
+    // Copy constructs the k-mer from another k-mer `rhs`.
+    Kmer_W(const Kmer_W& rhs);
+
+    // Copy assignment operator.
+    Kmer_W& operator=(const Kmer_W& rhs);
+
+    // Returns a 64-bit hash value for the k-mer with the seed `seed`.
+    uint64_t to_u64(uint64_t seed = 0) const;
+
+    // Computes a 128-bit hash value for the k-mer with the seed `seed`, into its lower and higher
+    // 64-bit halves `lo` and `hi`.
+    void to_u128(uint64_t seed, uint64_t& lo, uint64_t& hi) const;
+
+    // Gets the k-mer that is the reverse complement of the k-mer `other`, for the k-value `k`.
+    void as_reverse_complement(const Kmer_W& other, uint16_t k);
+
+    // Returns the `DNA::Base` encoding of the first base of the k-mer, for the k-value `k`.
+    DNA::Base front(uint16_t k) const;
+
+    // Returns the `DNA::Base` encoding of the last base of the k-mer.
+    DNA::Base back() const;
+
+    // Transforms this k-mer, for the k-value `k`, by chopping off the first base and appending
+    // the base `base` to the end. Also sets its reverse complement `rev_compl` accordingly.
+    void roll_to_next_kmer(DNA::Base base, Kmer_W& rev_compl, uint16_t k);
+
+    // Transforms this k-mer, for the k-value `k`, by chopping off the first base and appending
+    // the base `base` to the end.
+    void roll_forward(DNA::Base base, uint16_t k);
+
+    // Transforms this k-mer, for the k-value `k`, by chopping off the last base and appending
+    // the base `base` to the beginning.
+    void roll_backward(DNA::Base base, uint16_t k);
+
+    // Returns `true` iff the bitwise encoding of this k-mer is lesser to that of `rhs`.
+    bool operator<(const Kmer_W& rhs) const;
+
+    // Returns `true` iff the bitwise encoding of this k-mer is larger to that of `rhs`.
+    bool operator>(const Kmer_W& rhs) const;
+
+    // Returns `true` iff this k-mer is identical to the k-mer `rhs`.
+    bool operator==(const Kmer_W& rhs) const;
+
+    // Returns `true` iff this k-mer is not identical to the k-mer `rhs`.
+    bool operator!=(const Kmer_W& rhs) const;
+};
+
+
+template <uint16_t NUM_INTS>
+inline void Kmer_W<NUM_INTS>::left_shift()
+{
+    for(uint16_t idx = NUM_INTS - 1; idx > 0; --idx)
+        kmer_data[idx] = (kmer_data[idx] << 2) | (kmer_data[idx - 1] >> 62);
+
+    kmer_data[0] <<= 2;
+}
+
+
+template <uint16_t NUM_INTS>
+inline void Kmer_W<NUM_INTS>::right_shift()
+{
+    for(uint16_t idx = 0; idx < NUM_INTS - 1; ++idx)
+        kmer_data[idx] = (kmer_data[idx] >> 2) | (kmer_data[idx + 1] << 62);
+
+    kmer_data[NUM_INTS - 1] >>= 2;
+}
+
+
+template <uint16_t NUM_INTS>
+inline void Kmer_W<NUM_INTS>::right_shift_bits(const uint16_t b)
+{
+    if(b == 0)
+        return;
+
+    for(uint16_t idx = 0; idx < NUM_INTS - 1; ++idx)
+        kmer_data[idx] = (kmer_data[idx] >> b) | (kmer_data[idx + 1] << (64 - b));
+
+    kmer_data[NUM_INTS - 1] >>= b;
+}
+
+
+template <uint16_t NUM_INTS>
+inline uint16_t Kmer_W<NUM_INTS>::MSN_shift(const uint16_t k)
+{
+    return 2 * ((k - 1) & 31);
+}
+
+
+template <uint16_t NUM_INTS>
+inline Kmer_W<NUM_INTS>::Kmer_W():
+    kmer_data() // Value-initializes the data array, i.e. zeroes it out.
+{}
+
+
+template <uint16_t NUM_INTS>
+inline Kmer_W<NUM_INTS>::Kmer_W(const Kmer_W& rhs)
+{
+    std::memcpy(kmer_data, rhs.kmer_data, NUM_INTS * sizeof(uint64_t));
+}
+
+
+template <uint16_t NUM_INTS>
+inline Kmer_W<NUM_INTS>& Kmer_W<NUM_INTS>::operator=(const Kmer_W& rhs)
+{
+    std::memcpy(kmer_data, rhs.kmer_data, NUM_INTS * sizeof(uint64_t));
+
+    return *this;
+}
+
+
+template <uint16_t NUM_INTS>
+inline uint64_t Kmer_W<NUM_INTS>::to_u64(const uint64_t seed) const
+{
+    // A k-mer fitting in a single word is hashed in registers, by mixing the word itself.
+    if constexpr(NUM_INTS == 1)
+        return Kmer_Utility::mix(kmer_data[0], seed);
+
+    return XXH3_64bits_withSeed(kmer_data, NUM_INTS * sizeof(uint64_t), seed);
+}
+
+
+template <uint16_t NUM_INTS>
+inline void Kmer_W<NUM_INTS>::to_u128(const uint64_t seed, uint64_t& lo, uint64_t& hi) const
+{
+    const XXH128_hash_t hash = XXH3_128bits_withSeed(kmer_data, NUM_INTS * sizeof(uint64_t), seed);
+
+    lo = hash.low64, hi = hash.high64;
+}
+
+
+template <uint16_t NUM_INTS>
+inline void Kmer_W<NUM_INTS>::as_reverse_complement(const Kmer_W& other, const uint16_t k)
+{
+    // Reverse-complement each word in full, and reverse the order of the words. The zeroed bits past
+    // the k-mer turn into the `64 * NUM_INTS - 2k` lowest bits then, which are shifted out.
+    uint64_t rev_compl[NUM_INTS];   // `other` may be this k-mer itself.
+    for(uint16_t idx = 0; idx < NUM_INTS; ++idx)
+        rev_compl[NUM_INTS - 1 - idx] = Kmer_Utility::reverse_complement_word<32>(other.kmer_data[idx]);
+
+    std::memcpy(kmer_data, rev_compl, NUM_INTS * sizeof(uint64_t));
+
+    right_shift_bits(64 * NUM_INTS - 2 * k);
+}
+
+
+template <uint16_t NUM_INTS>
+inline DNA::Base Kmer_W<NUM_INTS>::front(const uint16_t k) const
+{
+    return DNA::Base((kmer_data[NUM_INTS - 1] >> MSN_shift(k)) & 0b11);
+}
+
+
+template <uint16_t NUM_INTS>
+inline DNA::Base Kmer_W<NUM_INTS>::back() const
+{
+    return DNA::Base(kmer_data[0] & 0b11);
+}
+
+
+template <uint16_t NUM_INTS>
+inline void Kmer_W<NUM_INTS>::roll_to_next_kmer(const DNA::Base base, Kmer_W& rev_compl, const uint16_t k)
+{
+    roll_forward(base, k);
+
+    rev_compl.right_shift();
+    rev_compl.kmer_data[NUM_INTS - 1] |= (static_cast<uint64_t>(DNA_Utility::complement(base)) << MSN_shift(k));
+}
+
+
+template <uint16_t NUM_INTS>
+inline void Kmer_W<NUM_INTS>::roll_forward(const DNA::Base base, const uint16_t k)
+{
+    // Logically, since a left shift moves the MSN out of the length `k` boundary, the clearing of the base
+    // may seem redundant. But, the bits past the k-mer are to be kept zeroed for the hashing and the comparisons.
+    kmer_data[NUM_INTS - 1] &= ~(uint64_t(0b11) << MSN_shift(k));
+    left_shift();
+    kmer_data[0] |= static_cast<uint64_t>(base);
+}
+
+
+template <uint16_t NUM_INTS>
+inline void Kmer_W<NUM_INTS>::roll_backward(const DNA::Base base, const uint16_t k)
+{
+    right_shift();
+    kmer_data[NUM_INTS - 1] |= (static_cast<uint64_t>(base) << MSN_shift(k));
+}
+
+
+template <uint16_t NUM_INTS>
+inline bool Kmer_W<NUM_INTS>::operator<(const Kmer_W& rhs) const
+{
+    if constexpr(NUM_INTS == 1)
+        return kmer_data[0] < rhs.kmer_data[0];
+
+    for(int16_t idx = NUM_INTS - 1; idx >= 0; --idx)
+        if(kmer_data[idx] != rhs.kmer_data[idx])
+            return kmer_data[idx] < rhs.kmer_data[idx];
+
+    return false;
+}
+
+
+template <uint16_t NUM_INTS>
+inline bool Kmer_W<NUM_INTS>::operator>(const Kmer_W& rhs) const
+{
+    return rhs < *this;
+}
+
+
+template <uint16_t NUM_INTS>
+inline bool Kmer_W<NUM_INTS>::operator==(const Kmer_W& rhs) const
+{
+    if constexpr(NUM_INTS == 1)
+        return kmer_data[0] == rhs.kmer_data[0];
+
+    return std::memcmp(kmer_data, rhs.kmer_data, NUM_INTS * sizeof(uint64_t)) == 0;
+}
+
+
+template <uint16_t NUM_INTS>
+inline bool Kmer_W<NUM_INTS>::operator!=(const Kmer_W& rhs) const
+{
+    return !operator==(rhs);
+}
+
+
+
+#endif
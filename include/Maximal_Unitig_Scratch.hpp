@@ -7,6 +7,7 @@
 #include "Unitig_Scratch.hpp"
 #include "FASTA_Record.hpp"
 #include "Character_Buffer.hpp"
+#include "Unitig_Sink.hpp"
 
 #include <cstdint>
 #include <cstddef>
@@ -47,6 +48,9 @@ public:
     // class body).
     Unitig_Scratch<k>& unitig(const cuttlefish::side_t s);
 
+    // Returns the unitig scratch `u_b` or `u_f`, based on `s`, for reading.
+    const Unitig_Scratch<k>& unitig(cuttlefish::side_t s) const;
+
     // Returns the unique ID of the maximal unitig.
     uint64_t id() const;
 
@@ -78,18 +82,35 @@ public:
     // Signals the scratch that the unitig pieces `u_b` and `u_f` are in their
     // final forms and will not be modified anymore. So it restructures the
     // maximal unitig so as to put its label in canonical form and sets its
-    // unique ID.
-    void finalize();
+    // unique ID, offset by `id_offset` (required when the vertex hashes are
+    // local to some partition of the graph).
+    void finalize(uint64_t id_offset = 0);
 
     // Returns `true` iff the maximal unitig has been marked as a cycle.
     bool is_cycle() const;
 
+    // Returns whether the label of the maximal unitig has been spilled out of the scratch while
+    // being walked, through the unitig `u_b` or `u_f` (see note above class body), with the other
+    // one then being just the meeting-point vertex. Applicable when the maximal unitig is linear.
+    bool is_streamed() const;
+
+    // Returns the side of the meeting-point vertex whose unitig has been spilled out of the scratch.
+    // Applicable when the maximal unitig is streamed.
+    cuttlefish::side_t streamed_side() const;
+
+    // Returns whether the spilled label of the streamed unitig, followed by its label retained in the
+    // scratch, is the canonical form of the maximal unitig; otherwise its reverse complement is.
+    bool is_streamed_canonical() const;
+
     // Returns a FASTA record of the maximal unitig (in canonical form).
     // Applicable when the maximal unitig is linear.
     const FASTA_Record<std::vector<char>> fasta_rec() const;
 
     // Adds a corresponding FASTA record for the maximal unitig into `buffer`.
     template <std::size_t CAPACITY, typename T_sink_> void add_fasta_rec_to_buffer(Character_Buffer<CAPACITY, T_sink_>& buffer) const;
+
+    // Returns a view of the label of the maximal unitig (in canonical form), like its FASTA record.
+    Unitig_View view() const;
 };
 
 
@@ -108,6 +129,13 @@ inline Unitig_Scratch<k>& Maximal_Unitig_Scratch<k>::unitig(const cuttlefish::si
 }
 
 
+template <uint16_t k>
+inline const Unitig_Scratch<k>& Maximal_Unitig_Scratch<k>::unitig(const cuttlefish::side_t s) const
+{
+    return s == cuttlefish::side_t::back ? unitig_back : unitig_front;
+}
+
+
 template <uint16_t k>
 /**
  * @brief 判断是否为规范形式
@@ -210,20 +238,23 @@ template <uint16_t k>
  * 如果对象是线性的，则根据是否规范来决定其id和反转互补操作；
  * 如果对象是非线性的，则设置id为最小顶点的哈希值，并根据需要执行反转互补操作。
  */
-inline void Maximal_Unitig_Scratch<k>::finalize()
+inline void Maximal_Unitig_Scratch<k>::finalize(const uint64_t id_offset)
 {
     if(is_linear())
     {
-        if(is_canonical())
-            id_ = unitig_front.endpoint().hash(),//只存储标记顶点的哈希值为id
+        // The label is out of the scratch; it is oriented as it is streamed out.
+        if(is_streamed())
+            id_ = id_offset + (is_canonical() ? unitig_front.endpoint().hash() : unitig_back.endpoint().hash());
+        else if(is_canonical())
+            id_ = id_offset + unitig_front.endpoint().hash(),//只存储标记顶点的哈希值为id
             unitig_front.reverse_complement();//存储更小的unititgs? 标准化存储?
         else
-            id_ = unitig_back.endpoint().hash(),
+            id_ = id_offset + unitig_back.endpoint().hash(),
             unitig_back.reverse_complement();
     }
     else
     {
-        id_ = cycle->min_vertex().hash();
+        id_ = id_offset + cycle->min_vertex().hash();
         if(!cycle->min_vertex().in_canonical_form())
             cycle->reverse_complement();
     }
@@ -244,6 +275,29 @@ inline bool Maximal_Unitig_Scratch<k>::is_cycle() const
 }
 
 
+template <uint16_t k>
+inline bool Maximal_Unitig_Scratch<k>::is_streamed() const
+{
+    return unitig_back.is_spilled() || unitig_front.is_spilled();
+}
+
+
+template <uint16_t k>
+inline cuttlefish::side_t Maximal_Unitig_Scratch<k>::streamed_side() const
+{
+    return unitig_back.is_spilled() ? cuttlefish::side_t::back : cuttlefish::side_t::front;
+}
+
+
+template <uint16_t k>
+inline bool Maximal_Unitig_Scratch<k>::is_streamed_canonical() const
+{
+    // The other unitig is just the meeting-point vertex, so the maximal unitig is the streamed one,
+    // or its reverse complement.
+    return (streamed_side() == cuttlefish::side_t::back) == is_canonical();
+}
+
+
 template <uint16_t k>
 /**
  * @brief 返回 FASTA 记录
@@ -283,5 +337,23 @@ inline void Maximal_Unitig_Scratch<k>::add_fasta_rec_to_buffer(Character_Buffer<
 }
 
 
+template <uint16_t k>
+inline Unitig_View Maximal_Unitig_Scratch<k>::view() const
+{
+    if(is_linear())
+    {
+        const std::vector<char>& first = (is_canonical() ? unitig_front.label() : unitig_back.label());
+        const std::vector<char>& second = (is_canonical() ? unitig_back.label() : unitig_front.label());
+
+        return Unitig_View{id(), {first.data(), second.data() + k}, {first.size(), second.size() - k}, false};
+    }
+
+    // The cycle is right-rotated so that its vertex at index `pivot` is at the front.
+    const std::vector<char>& label = cycle->label();
+    const std::size_t pivot = cycle->min_vertex_idx();
+    return Unitig_View{id(), {label.data() + pivot, label.data() + k - 1}, {label.size() - pivot, pivot}, true};
+}
+
+
 
 #endif
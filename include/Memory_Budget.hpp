@@ -0,0 +1,71 @@
+
+#ifndef MEMORY_BUDGET_HPP
+#define MEMORY_BUDGET_HPP
+
+
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+class Build_Params;
+
+
+// Governor of the memory usage of the whole pipeline against the memory limit. It plans the
+// sizes of the k-mer parser buffers and the budgets of the data structures built in the phases
+// against the limit, returns the memory freed in a phase to the OS before the next one, and
+// reports the headroom left under the limit at the phases. The limit is binding if it is
+// specified explicitly in the strict memory mode; otherwise it is a soft one, extended up to
+// the peak memory already used by the process.
+class Memory_Budget
+{
+private:
+
+    static constexpr std::size_t MIN_PARSER_BUF_SZ = (1 << 20);    // Minimum size of a consumer-specific parser buffer (in bytes): 1 MB.
+    static constexpr std::size_t MAX_PARSER_BUF_SZ = (1 << 24);    // Maximum size of a consumer-specific parser buffer (in bytes): 16 MB.
+    static constexpr std::size_t PARSER_SHARE = 16; // The parser buffers are budgeted to at most `1 / PARSER_SHARE` of the limit.
+
+    static std::size_t limit_;  // The memory limit (in bytes).
+    static bool bounded_;   // Whether the limit is binding.
+    static std::size_t parser_buf_sz;   // Size of the consumer-specific parser buffers (in bytes).
+    static bool held_;  // Whether the budget is held against the later setups.
+
+
+public:
+
+    // Sets up the budget per the parameters `params`, and plans the buffer sizes against it.
+    // No-op if the budget is held.
+    static void setup(const Build_Params& params);
+
+    // Holds the current budget, so that the later setups do not alter it; for the builds sharing
+    // the process, and thus the budget, e.g. in a batch.
+    static void hold() { held_ = true; }
+
+    // Returns whether the memory limit is binding.
+    static bool bounded() { return bounded_; }
+
+    // Returns the memory limit (in bytes).
+    static std::size_t limit() { return limit_; }
+
+    // Returns the size (in bytes) of the consumer-specific buffers of the k-mer parsers.
+    static std::size_t parser_buffer_size() { return parser_buf_sz; }
+
+    // Returns the memory (in bytes) available to a data structure to be built, in addition to
+    // the currently resident memory and to `reserved` bytes to be used alongside it.
+    static std::size_t available(std::size_t reserved);
+
+    // Releases the memory freed by the process back to the OS, purging the allocator's caches.
+    static void release();
+
+    // Returns the headroom (in bytes) left under the limit by the peak memory `peak_rss`;
+    // negative if the limit has been exceeded.
+    static int64_t headroom(std::size_t peak_rss);
+
+    // Reports the peak memory `peak_rss` of the phase `phase` against the limit, if binding.
+    static void report(const std::string& phase, std::size_t peak_rss);
+};
+
+
+
+#endif
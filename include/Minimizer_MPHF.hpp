@@ -0,0 +1,160 @@
+
+#ifndef MINIMIZER_MPHF_HPP
+#define MINIMIZER_MPHF_HPP
+
+
+
+#include "BBHash/BooPHF.h"
+#include "Kmer.hpp"
+#include "Kmer_Hasher.hpp"
+#include "Spin_Lock.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include <iostream>
+
+
+template <uint16_t k> class Kmer_SPMC_Iterator;
+
+
+// A locality-preserving minimal perfect hash function over a set of k-mers. The k-mers are
+// grouped by their (orientation-independent) minimizers, each group gets a contiguous range
+// of hash values, and a separate BBHash maps the k-mers of a group into its range. Since the
+// consecutive vertices of a unitig mostly share their minimizers, walks over the graph then
+// stay within a small slice of any table indexed by these hashes. The number of groups scales
+// with the input such that a group has ~64K k-mers, and thus its slice of a table of a few bits
+// per k-mer spans some tens of KB, fitting in the L2 cache; the accesses inside a slice are
+// still random.
+template <uint16_t k>
+class Minimizer_MPHF
+{
+    typedef boomphf::mphf<typename Kmer<k>::width_t, Kmer_Hasher<Kmer<k>::width_t::word_count>> mphf_t;  // The MPH function type for the groups.
+    typedef typename Kmer<k>::minimizer_t minimizer_t;
+
+public:
+
+    static constexpr uint8_t l = (k < 11 ? k : 11); // Length of the minimizers to group the k-mers with.
+
+private:
+    static constexpr uint64_t GROUP_SIZE = (1 << 16);   // Targeted number of k-mers per group: ~64K, so that a group's slice of the hash table spans some tens of KB.
+    static constexpr uint64_t MAX_GROUP_COUNT = ((1ULL << (2 * l)) + 3) / 4;    // Maximum number of groups: a quarter of the possible minimizers, so that the groups still pool several minimizers each.
+    static constexpr uint16_t MAX_BUCKET_COUNT = 1024;  // Maximum number of buckets of the groups during construction; bounded as each bucket is a separate file, so runs of consecutive groups share buckets.
+    static constexpr std::size_t BUCKET_BUF_SZ = 8 * 1024ULL;   // 8 KB worth of k-mers can be retained per group-bucket per thread, at most, before flushing.
+
+    uint32_t group_count_ = 1;  // Number of groups of the k-mers.
+    uint32_t groups_per_bucket = 1; // Number of consecutive groups sharing a bucket, during construction.
+    uint16_t bucket_count = 0;  // Number of buckets of the groups, during construction.
+    std::vector<uint64_t> offset;   // `offset[g]` is the first hash value for the group `g`; `offset[group_count_]` is the total k-mer count.
+    std::vector<std::unique_ptr<mphf_t>> group_mph; // `group_mph[g]` is the BBHash for the group `g`; `nullptr` if the group is empty.
+
+    std::vector<std::FILE*> bucket; // The buckets of the groups, during construction.
+    std::vector<Spin_Lock> bucket_lock;  // Mutual exclusion locks for the buckets, during construction.
+    Spin_Lock lock; // Mutual exclusion lock for the group-size counters, during construction.
+
+
+    // Returns the path to the bucket with ID `b` for the k-mer database at `kmc_db_path`, in the
+    // directory at `working_dir_path`.
+    static const std::string bucket_path(const std::string& kmc_db_path, const std::string& working_dir_path, uint16_t b);
+
+    // Distributes the k-mers provided to the consumer thread with ID `thread_id` from the parser
+    // `kmer_parser` into the buckets of their groups.
+    void scatter_kmers(Kmer_SPMC_Iterator<k>& kmer_parser, uint16_t thread_id);
+
+    // Flushes the k-mers in `buf` into the bucket with ID `b`, and clears `buf`.
+    void flush_to_bucket(uint16_t b, std::vector<Kmer<k>>& buf);
+
+    // Sorts the k-mers of the bucket at path `path`, whose first group is `g_begin`, by their
+    // groups in-place in its file, using up-to `thread_count` threads.
+    void sort_bucket(const std::string& path, uint32_t g_begin, uint16_t thread_count) const;
+
+    // Builds the BBHashes of the groups of the bucket with ID `b` for the k-mer database at
+    // `kmc_db_path`, using up-to `thread_count` threads, the directory at `working_dir_path` for
+    // temporary files, and the gamma factor `gamma`. The groups are built concurrently, each by a
+    // single thread.
+    void build_bucket(uint16_t b, const std::string& kmc_db_path, uint16_t thread_count, const std::string& working_dir_path, double gamma);
+
+    // Returns the ID of the group of the k-mers with the orientation-independent minimizer `minmzr`.
+    uint32_t group_of(minimizer_t minmzr) const;
+
+
+public:
+
+    // Constructs an empty hash function.
+    Minimizer_MPHF();
+
+    // Constructs the hash function over the `kmer_count` k-mers of the KMC database at path
+    // `kmc_db_path`, using up-to `thread_count` threads, the directory at `working_dir_path`
+    // for temporary files, and the gamma factor `gamma` for the BBHash of each group.
+    void construct(const std::string& kmc_db_path, uint64_t kmer_count, uint16_t thread_count, const std::string& working_dir_path, double gamma);
+
+    // Returns the ID of the group of the k-mer `kmer`.
+    uint32_t group(const Kmer<k>& kmer) const;
+
+    // Returns the hash value of the k-mer `kmer`. Returns an out-of-range value, i.e. the k-mer
+    // count, for a k-mer falling into an empty group, which can only be absent from the set.
+    uint64_t lookup(const Kmer<k>& kmer) const;
+
+    // Returns the hash value of the k-mer `kmer` whose orientation-independent minimizer — the
+    // minimum l-mer over both its orientations — is `minmzr`, so that callers that maintain the
+    // minimizer over rolling k-mers skip its computation.
+    uint64_t lookup(const Kmer<k>& kmer, minimizer_t minmzr) const;
+
+    // Returns the number of groups of the k-mers.
+    uint32_t group_count() const;
+
+    // Returns the total size (in bits) of the hash function.
+    uint64_t totalBitSize() const;
+
+    // Saves the hash function into the stream `output`.
+    void save(std::ostream& output) const;
+
+    // Loads the hash function from the stream `input`.
+    void load(std::istream& input);
+};
+
+
+template <uint16_t k>
+inline uint32_t Minimizer_MPHF<k>::group(const Kmer<k>& kmer) const
+{
+    Kmer<k> kmer_bar;
+    kmer_bar.as_reverse_complement(kmer);
+
+    // The grouping is orientation-independent, as the consecutive vertices of a unitig may
+    // be in different canonical orientations.
+    const uint64_t min_fwd = kmer.template minimizer<l>();
+    const uint64_t min_bwd = kmer_bar.template minimizer<l>();
+    const uint64_t minmzr = (min_fwd < min_bwd ? min_fwd : min_bwd);
+
+    return group_of(minmzr);
+}
+
+
+template <uint16_t k>
+inline uint32_t Minimizer_MPHF<k>::group_of(const minimizer_t minmzr) const
+{
+    return static_cast<uint32_t>(((minmzr * 0x9E3779B97F4A7C15ULL) >> 32) % group_count_);
+}
+
+
+template <uint16_t k>
+inline uint64_t Minimizer_MPHF<k>::lookup(const Kmer<k>& kmer) const
+{
+    const uint32_t g = group(kmer);
+    return group_mph[g] ? offset[g] + group_mph[g]->lookup(kmer) : offset[group_count_];
+}
+
+
+template <uint16_t k>
+inline uint64_t Minimizer_MPHF<k>::lookup(const Kmer<k>& kmer, const minimizer_t minmzr) const
+{
+    const uint32_t g = group_of(minmzr);
+    return group_mph[g] ? offset[g] + group_mph[g]->lookup(kmer) : offset[group_count_];
+}
+
+
+
+#endif
@@ -0,0 +1,384 @@
+
+#ifndef PARTITIONED_CDBG_HPP
+#define PARTITIONED_CDBG_HPP
+
+
+
+#include "globals.hpp"
+#include "Kmer.hpp"
+#include "DNA_Utility.hpp"
+#include "Kmer_Hash_Table.hpp"
+#include "Directed_Vertex.hpp"
+#include "Maximal_Unitig_Scratch.hpp"
+#include "State_Read_Space.hpp"
+#include "Build_Params.hpp"
+#include "Spin_Lock.hpp"
+#include "Async_Logger_Wrapper.hpp"
+#include "Atomic_Bit_Vector.hpp"
+#include "Output_Sink.hpp"
+#include "Phase_Metrics.hpp"
+#include "Unipaths_Meta_info.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+template <uint16_t k> class Kmer_SPMC_Iterator;
+template <uint16_t k> class Kmer_Bucket_Iterator;
+template <uint16_t k> class Read_CdBG_Constructor;
+
+
+// A class to construct compacted read de Bruijn graphs out-of-core, i.e. with memory bounded by
+// the largest partition of the graph rather than by the whole graph. The vertices are partitioned
+// into disk-buckets by their minimizers, and each edge is routed to the buckets of its endpoints.
+// The partitions are then processed one at a time: an MPHF and the DFA-states are built over the
+// vertices of the partition only, and the maximal unitigs are walked while they stay inside it.
+// Walks leaving a partition produce unitig fragments, which are stitched together at the end
+// out-of-core: their ends are sorted on disk, and their labels are read back one at a time.
+template <uint16_t k>
+class Partitioned_CdBG
+{
+private:
+
+    const Build_Params params;  // Required parameters (wrapped inside).
+
+    static constexpr uint8_t l = (k < 11 ? k : 11); // Length of the minimizers to partition the vertices with.
+    static constexpr uint16_t MAX_PARTITION_COUNT = 512;    // Maximum number of partitions; bounded to keep the open buckets and their write-buffers in check.
+    static constexpr double bits_per_vertex = 9.71; // Expected number of bits required per vertex by Cuttlefish 2.
+    static constexpr double skew_factor = 2.0;  // Factor to over-split the graph with, to accommodate the skew in the minimizer frequencies.
+    static constexpr std::size_t BUCKET_BUF_SZ = 8 * 1024ULL;   // 8 KB worth of k-mers can be retained per bucket per thread, at most, before flushing.
+    static constexpr std::size_t BUFF_SZ = 100 * 1024ULL;   // 100 KB (soft limit) worth of maximal unitig records (FASTA) can be retained in memory, at most, before flushing.
+    static constexpr std::size_t END_RUN_SZ = 64 * 1024 * 1024ULL;  // 64 MB worth of fragment ends can be sorted in memory, at most, per run of their external sort.
+    static constexpr std::size_t END_READ_BUF_SZ = 64 * 1024ULL;    // 64 KB worth of fragment ends are read from each sorted run at a time while merging.
+
+    uint16_t partition_count_ = 1;  // Number of partitions of the graph.
+    std::vector<uint64_t> vertex_bucket_size;   // `vertex_bucket_size[p]` is the number of vertices in the partition `p`.
+    std::vector<uint64_t> edge_bucket_size; // `edge_bucket_size[p]` is the number of edges incident to the vertices of the partition `p`.
+    std::vector<std::FILE*> bucket; // The buckets (either of the vertices or of the edges) being written to.
+    std::vector<Spin_Lock> bucket_lock; // Mutual exclusion locks for the buckets being written to.
+
+    uint64_t vertex_count_ = 0; // Number of vertices in the graph.
+    uint64_t edge_count_ = 0;   // Number of edges in the graph.
+
+    uint16_t curr_partition = 0;    // ID of the partition being processed currently.
+    uint64_t curr_id_offset = 0;    // Offset for the IDs of the maximal unitigs from the current partition, to keep those unique across the partitions.
+    std::unique_ptr<Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>> hash_table;    // Hash table for the vertices of the current partition.
+
+    // Flags for the vertices of the current partition (indexed by their hashes) that have been
+    // outputted, as in `Read_CdBG_Extractor`. The DFA-states are not updated during the extraction,
+    // so they are read without the locks of the hash table.
+    Atomic_Bit_Vector outputted;
+
+    typedef Async_Logger_Wrapper sink_t;
+    Output_Sink<sink_t> output_sink;    // Sink for the output maximal unitigs.
+    Output_Sink<std::ofstream> fragment_sink;   // Sink for the unitig fragments crossing the partition boundaries.
+
+    uint64_t fragment_count = 0;    // Number of unitig fragments extracted.
+    mutable Spin_Lock lock; // Mutual exclusion lock to access various unique resources by threads spawned off this class' methods.
+
+    Unipaths_Meta_info<k> unipaths_meta_info_; // Meta-information over the extracted maximal unitigs.
+
+    // Metrics of the phases of the construction, with their names: the partitioning, the processing
+    // of the partitions and of each one of them, and the join of the unitig fragments.
+    std::vector<std::pair<std::string, Phase_Metrics>> phase_metrics_;
+
+
+    // A unitig fragment, i.e. a maximal unitig restricted to some partition, with its label left
+    // in the fragments file.
+    struct Fragment
+    {
+        uint64_t id;    // Unique ID of the fragment.
+        uint64_t offset;    // Offset of the label of the fragment in the fragments file.
+        uint64_t len;   // Length of the label of the fragment.
+        char l; // The base that extends the fragment at its left end into some other partition; `N` if none.
+        char r; // The base that extends the fragment at its right end into some other partition; `N` if none.
+    };
+
+    // An open end of a unitig fragment, keyed by the canonical form of the edge that leaves it.
+    struct Fragment_End
+    {
+        Kmer<k + 1> e;  // Canonical form of the edge crossing out of the fragment.
+        uint64_t frag_idx;  // Index of the fragment.
+        cuttlefish::side_t s;   // The end of the fragment: `front` for the left end and `back` for the right end.
+
+        bool operator<(const Fragment_End& rhs) const { return e < rhs.e; }
+    };
+
+
+    // Returns the ID of the partition of the vertex with the observed k-mer `kmer` and its
+    // reverse complement `kmer_bar`.
+    uint16_t partition(const Kmer<k>& kmer, const Kmer<k>& kmer_bar) const;
+
+    // Returns the ID of the partition of the vertex `v_hat`.
+    uint16_t partition(const Kmer<k>& v_hat) const;
+
+    // Sets the number of partitions of the graph such that each may fit into the memory limit. If
+    // no count up-to `MAX_PARTITION_COUNT` fits, then aborts with a binding limit, and warns and
+    // uses the maximum count otherwise.
+    void set_partition_count();
+
+    // Returns the path to the bucket with ID `p` having the file extension `ext`.
+    const std::string bucket_path(const char* ext, uint16_t p) const;
+
+    // Opens the buckets having the file extension `ext` for writing.
+    void open_buckets(const char* ext);
+
+    // Closes the buckets opened for writing.
+    void close_buckets();
+
+    // Flushes the k-mers in `buf` into the bucket with ID `p`, and clears `buf`.
+    template <uint16_t K>
+    void flush_to_bucket(uint16_t p, std::vector<Kmer<K>>& buf);
+
+    // Partitions the vertices present at the KMC database at path `vertex_db_path` into buckets.
+    void partition_vertices(const std::string& vertex_db_path);
+
+    // Distributes the vertices provided to the consumer thread with ID `thread_id` from the
+    // parser `vertex_parser` into their buckets.
+    void scatter_vertices(Kmer_SPMC_Iterator<k>& vertex_parser, uint16_t thread_id);
+
+    // Partitions the edges present at the KMC database at path `edge_db_path` into the buckets
+    // of their endpoints.
+    void partition_edges(const std::string& edge_db_path);
+
+    // Distributes the edges provided to the consumer thread with ID `thread_id` from the parser
+    // `edge_parser` into the buckets of their endpoints.
+    void scatter_edges(Kmer_SPMC_Iterator<k + 1>& edge_parser, uint16_t thread_id);
+
+    // Processes the partition with ID `p`: constructs its hash table, computes the states of
+    // its vertices, and extracts its maximal unitigs and unitig fragments.
+    void process_partition(uint16_t p);
+
+    // Computes the states of the vertices of the current partition.
+    void compute_DFA_states();
+
+    // Processes the edges provided to the consumer thread with ID `thread_id` from the parser
+    // `edge_parser` with the constructor `cdbg_constructor`, for the current partition.
+    void process_edges(Kmer_Bucket_Iterator<k + 1>& edge_parser, Read_CdBG_Constructor<k>& cdbg_constructor, uint16_t thread_id);
+
+    // Extracts the maximal unitigs and the unitig fragments of the current partition.
+    void extract_fragments();
+
+    // Scans the vertices provided to the consumer thread with ID `thread_id` from the parser
+    // `vertex_parser` for the extraction of the maximal unitigs and the unitig fragments of
+    // the current partition.
+    void process_vertices(Kmer_Bucket_Iterator<k>& vertex_parser, uint16_t thread_id);
+
+    // Extracts the unitig fragment containing the vertex `v_hat` into `fragment`, and sets the
+    // bases extending the fragment out of the current partition through its back and its front
+    // into `ext_back` and `ext_front` respectively, `N` denoting no such extension. Returns
+    // `true` iff the fragment had not been extracted earlier.
+    bool extract_fragment(const Kmer<k>& v_hat, Maximal_Unitig_Scratch<k>& fragment, char& ext_back, char& ext_front);
+
+    // Traverses a unitig fragment starting from the vertex `v_hat` exiting through its side
+    // `s_v_hat`, with the vertex having the state `st_v`, and stores the traversal into `unitig`.
+    // The walk stops at the boundary of the current partition, and the base extending it out
+    // of the partition, if any, is stored in `ext`. Returns `true` iff the walk tried to exit
+    // the containing maximal unitig through an endpoint, as in `Read_CdBG_Extractor`.
+    bool walk_fragment(const Kmer<k>& v_hat, State_Read_Space st_v, cuttlefish::side_t s_v_hat, Unitig_Scratch<k>& unitig, char& ext);
+
+    // Marks the vertex `v` as outputted. Returns `true` iff `v` has not been marked yet.
+    bool mark_vertex(const Directed_Vertex<k>& v);
+
+    // Marks all the vertices in the unitig fragment `fragment` as outputted, using `path_hashes` as
+    // scratch for the hashes of the vertices.
+    void mark_fragment(const Maximal_Unitig_Scratch<k>& fragment, std::vector<uint64_t>& path_hashes);
+
+    // Appends the unitig fragment `fragment` with the extension bases `ext_back` and `ext_front`
+    // to `record`, in its textual format.
+    static void append_fragment_record(Maximal_Unitig_Scratch<k>& fragment, uint64_t id, char ext_back, char ext_front, std::string& record);
+
+    // Returns the path to the file of the unitig fragments.
+    const std::string fragments_path() const;
+
+    // Returns the path to the sorted run with ID `r` of the fragment ends.
+    const std::string fragment_ends_path(std::size_t r) const;
+
+    // Scans the unitig fragments from disk into `fragment`, without their labels; and sorts their
+    // open ends into runs on disk, `run_count` in total.
+    void scan_fragments(std::vector<Fragment>& fragment, std::size_t& run_count) const;
+
+    // Merges the `run_count` sorted runs of the fragment ends, and partners each end, `2i` (left)
+    // or `2i + 1` (right) of fragment `i`, with the end having the same crossing edge, in `partner`.
+    void pair_fragment_ends(std::size_t run_count, std::vector<uint64_t>& partner) const;
+
+    // Reads the label of the fragment `frag` from the fragments file `input` into `label`.
+    void read_fragment_label(std::FILE* input, const Fragment& frag, std::string& label) const;
+
+    // Joins the unitig fragments extracted from all the partitions into maximal unitigs, and
+    // outputs those.
+    void join_fragments();
+
+    // Appends the fragment label `label` to `unitig`, in the forward orientation if `fwd` is
+    // `true` and in the reverse complemented orientation otherwise. If `unitig` is not empty,
+    // the first `k - 1` bases of the orientation, overlapping with `unitig`, are skipped.
+    static void append_fragment(const std::string& label, bool fwd, std::string& unitig);
+
+    // Puts the label `cycle` of a detached chordless cycle in its canonical form, as with the
+    // cycles inside a partition: oriented such that its lexicographically minimum vertex is in
+    // its canonical form. Returns the index of that vertex in `cycle`.
+    static std::size_t canonicalize_cycle(std::string& cycle);
+
+
+public:
+
+    // Constructs a partitioned compacted graph builder with the parameters wrapped in `params`.
+    Partitioned_CdBG(const Build_Params& params);
+
+    // Constructs the compacted graph from the edges and the vertices present at the KMC databases
+    // at paths `edge_db_path` and `vertex_db_path` respectively, with `vertex_count` vertices in
+    // the graph, and writes the maximal unitigs to the output file at path `output_file_path`.
+    void construct(const std::string& edge_db_path, const std::string& vertex_db_path, uint64_t vertex_count, const std::string& output_file_path);
+
+    // Returns the number of vertices in the graph.
+    uint64_t vertex_count() const;
+
+    // Returns the number of edges in the graph.
+    uint64_t edge_count() const;
+
+    // Returns the number of partitions of the graph.
+    uint16_t partition_count() const;
+
+    // Returns the number of vertices in the largest partition.
+    uint64_t max_partition_size() const;
+
+    // Returns the number of unitig fragments crossing the partition boundaries.
+    uint64_t crossing_fragment_count() const;
+
+    // Returns the maximum disk-usage (in bytes) incurred by the buckets.
+    std::size_t bucket_disk_usage() const;
+
+    // Returns the meta-information over the extracted maximal unitigs.
+    const Unipaths_Meta_info<k>& unipaths_meta_info() const;
+
+    // Returns the metrics of the phases of the construction, with their names.
+    const std::vector<std::pair<std::string, Phase_Metrics>>& phase_metrics() const;
+};
+
+
+template <uint16_t k>
+inline uint16_t Partitioned_CdBG<k>::partition(const Kmer<k>& kmer, const Kmer<k>& kmer_bar) const
+{
+    // The minimizer of a vertex is orientation-independent: the smaller of the minimizers of its two k-mer forms.
+    const uint64_t min_fwd = kmer.template minimizer<l>();
+    const uint64_t min_bwd = kmer_bar.template minimizer<l>();
+    const uint64_t minmzr = (min_fwd < min_bwd ? min_fwd : min_bwd);
+
+    // Scramble the minimizer to spread the lexicographically-small ones across the partitions.
+    return static_cast<uint16_t>(((minmzr * 0x9E3779B97F4A7C15ULL) >> 32) % partition_count_);
+}
+
+
+template <uint16_t k>
+inline uint16_t Partitioned_CdBG<k>::partition(const Kmer<k>& v_hat) const
+{
+    return partition(v_hat, v_hat.reverse_complement());
+}
+
+
+template <uint16_t k>
+inline bool Partitioned_CdBG<k>::mark_vertex(const Directed_Vertex<k>& v)
+{
+    return outputted.set(v.hash());
+}
+
+
+template <uint16_t k>
+inline void Partitioned_CdBG<k>::mark_fragment(const Maximal_Unitig_Scratch<k>& fragment, std::vector<uint64_t>& path_hashes)
+{
+    if(fragment.is_linear())
+    {
+        const std::vector<uint64_t>& back_hashes = fragment.unitig_hash(cuttlefish::side_t::back);
+        const std::vector<uint64_t>& front_hashes = fragment.unitig_hash(cuttlefish::side_t::front);
+        path_hashes.assign(back_hashes.begin(), back_hashes.end());
+        path_hashes.insert(path_hashes.end(), front_hashes.begin(), front_hashes.end());
+    }
+    else
+        path_hashes.assign(fragment.cycle_hash().begin(), fragment.cycle_hash().end());
+
+    outputted.set(path_hashes);
+}
+
+
+template <uint16_t k>
+inline bool Partitioned_CdBG<k>::extract_fragment(const Kmer<k>& v_hat, Maximal_Unitig_Scratch<k>& fragment, char& ext_back, char& ext_front)
+{
+    static constexpr cuttlefish::side_t back = cuttlefish::side_t::back;
+    static constexpr cuttlefish::side_t front = cuttlefish::side_t::front;
+
+    const uint64_t h = (*hash_table)(v_hat);
+    if(outputted.test(h))   // The containing fragment has already been outputted.
+        return false;
+
+    const State_Read_Space state = hash_table->at_exclusive(h).state();   // State of the vertex `v_hat`.
+
+    ext_back = ext_front = 'N';
+    fragment.mark_linear();
+    if(!walk_fragment(v_hat, state, back, fragment.unitig(back), ext_back))
+        return false;
+
+    if(fragment.unitig(back).is_cycle())
+        fragment.mark_cycle(back);
+    else
+        if(!walk_fragment(v_hat, state, front, fragment.unitig(front), ext_front))
+            return false;
+
+    return mark_vertex(fragment.sign_vertex());
+}
+
+
+template <uint16_t k>
+inline bool Partitioned_CdBG<k>::walk_fragment(const Kmer<k>& v_hat, const State_Read_Space st_v, const cuttlefish::side_t s_v_hat, Unitig_Scratch<k>& unitig, char& ext)
+{
+    cuttlefish::side_t s_v = s_v_hat;   // The side of the current vertex `v_hat` through which to extend the unitig, i.e. exit `v_hat`.
+    Directed_Vertex<k> v(s_v == cuttlefish::side_t::back ? v_hat : v_hat.reverse_complement(), *hash_table);   // Current vertex being added to the unitig.
+    State_Read_Space state = st_v;  // State of the vertex `v`.
+    cuttlefish::edge_encoding_t e_v;    // The potential next edge from `v` to include into the unitig.
+    cuttlefish::base_t b_ext;   // The nucleobase corresponding to the edge `e_v` and the exiting side `s_v` from `v` to potentially add to the literal form of the unitig.
+    Kmer<k> w, w_bar;   // The observed k-mer for the next vertex, and its reverse complement.
+    unitig.init(v); // Initialize the unitig with the current vertex.
+
+
+    while(true)
+    {
+        e_v = state.edge_at(s_v);
+        if(cuttlefish::is_fuzzy_edge(e_v))  // Reached an endpoint.
+            break;
+
+        b_ext = (s_v == cuttlefish::side_t::back ? DNA_Utility::map_base(e_v) : DNA_Utility::complement(DNA_Utility::map_base(e_v)));
+
+        // The next vertex is to be looked up in the hash table only if it belongs to the current partition.
+        w = v.kmer(), w_bar = v.kmer_bar();
+        w.roll_to_next_kmer(b_ext, w_bar);
+        if(partition(w, w_bar) != curr_partition)
+        {
+            ext = DNA_Utility::map_char(b_ext);
+            break;
+        }
+
+        v.roll_forward(b_ext, *hash_table); // Walk to the next vertex.
+        state = hash_table->at_exclusive(v.hash()).state();
+        s_v = v.entrance_side();
+        if(outputted.test(v.hash()))
+            return state.is_branching_side(s_v);    // If `s_v` is a branching side, then the walk just crossed to a different unitig.
+        if(state.is_branching_side(s_v))    // Crossed an endpoint and reached a different unitig.
+            break;
+
+        if(!unitig.extend(v, DNA_Utility::map_char(b_ext)))
+            break;  // The unitig is a DCC (Detached Chordless Cycle).
+        s_v = cuttlefish::opposite_side(s_v);
+    }
+
+
+    return true;
+}
+
+
+
+#endif
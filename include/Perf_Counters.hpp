@@ -0,0 +1,82 @@
+
+#ifndef PERF_COUNTERS_HPP
+#define PERF_COUNTERS_HPP
+
+
+
+#include "nlohmann/json.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <string>
+
+
+// Hardware performance counters over a scope of execution, through Linux `perf_event_open`:
+// cycles, instructions, last-level cache misses, data-TLB misses, and front- and back-end
+// stalled cycles. Only the user-space execution is counted, so that no extra privileges are
+// required. Events not supported by the processor or the kernel are skipped. These are used
+// only in builds with `CF_PERF_COUNTERS` defined.
+class Perf_Counters
+{
+public:
+
+    static constexpr std::size_t EVENT_COUNT = 6;   // Number of the counted events.
+
+    typedef std::array<double, EVENT_COUNT> counts_t;   // Counts of the events; negative for the unsupported ones.
+
+
+private:
+
+    static const char* const event_name[EVENT_COUNT];   // Names of the events.
+
+    std::array<int, EVENT_COUNT> fd;    // File descriptors of the counters.
+
+
+public:
+
+    // Opens and starts the counters for the calling thread. Iff `inherit` is `true`, the threads
+    // spawned by it afterwards are also counted once they exit.
+    Perf_Counters(bool inherit);
+
+    // Closes the counters.
+    ~Perf_Counters();
+
+    Perf_Counters(const Perf_Counters&) = delete;
+    Perf_Counters& operator=(const Perf_Counters&) = delete;
+
+    // Returns the counts since the start, scaled for the time that the counters were not
+    // scheduled on the hardware, in case of multiplexing.
+    counts_t read() const;
+
+    // Returns the counts `counts` as JSON, with the instructions per cycle and the LLC misses
+    // per kilo-instruction derived.
+    static nlohmann::ordered_json to_json(const counts_t& counts);
+};
+
+
+// A scope of a worker thread whose hardware counters are recorded, at exiting the scope, into
+// the per-thread breakdown of the ongoing phase.
+class Perf_Thread_Scope
+{
+private:
+
+    const std::string name; // Name of the thread.
+    const Perf_Counters counters;   // Counters of the thread.
+
+
+public:
+
+    // Starts counting for the calling thread, named `name`.
+    Perf_Thread_Scope(const std::string& name);
+
+    // Records the counts of the thread.
+    ~Perf_Thread_Scope();
+
+    // Returns the counts of the threads recorded since the last collection, and clears those.
+    static nlohmann::ordered_json collect();
+};
+
+
+
+#endif
@@ -0,0 +1,120 @@
+
+#ifndef PHASE_METRICS_HPP
+#define PHASE_METRICS_HPP
+
+
+
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#if defined(CF_CONTENTION_STATS) || defined(CF_PERF_COUNTERS)
+#include "nlohmann/json.hpp"
+#endif
+#ifdef CF_PERF_COUNTERS
+#include "Perf_Counters.hpp"
+#include <memory>
+#endif
+
+
+// Metrics of the execution of a phase of the algorithm: its wall-clock and CPU times, the
+// peak and the current memory (RSS) of the process, the bytes read and written by the process,
+// and the number of items processed in the phase. The phase starts at the construction of the
+// object, and ends with `end`. The peak memory is only sampled, never reset, so that the sizing
+// decisions based on the process peak see the earlier phases too.
+class Phase_Metrics
+{
+private:
+
+    typedef std::chrono::steady_clock clock_t;
+
+    // A snapshot of the cumulative resource usage of the process.
+    struct Sample
+    {
+        clock_t::time_point wall;   // Wall-clock time.
+        double cpu; // CPU time (user and system) in seconds, over all the threads.
+        uint64_t bytes_read;    // Bytes read through the `read`-family system calls.
+        uint64_t bytes_written; // Bytes written through the `write`-family system calls.
+        std::size_t peak_rss;   // Peak RSS ("high-water-mark") of the process so far, in bytes.
+    };
+
+    Sample start_;  // Resource usage at the start of the phase.
+    Sample end_;    // Resource usage at the end of the phase.
+    std::size_t curr_rss_;  // RSS of the process (in bytes) at the end of the phase.
+    uint64_t items_;    // Number of items processed in the phase.
+#ifdef CF_CONTENTION_STATS
+    nlohmann::ordered_json contention_; // Contention over the hash table during the phase.
+#endif
+#ifdef CF_PERF_COUNTERS
+    std::unique_ptr<Perf_Counters> perf_counters;   // Hardware counters of the process during the phase.
+    nlohmann::ordered_json hw_counters_;    // Hardware counts of the phase, in total and per worker thread.
+#endif
+
+
+    static bool process_shared_;    // Whether the process is shared by concurrent jobs.
+
+
+    // Returns a snapshot of the current resource usage of the process.
+    static Sample sample();
+
+
+public:
+
+    // Marks the process as shared by concurrent jobs. The resource usage of the process then mixes
+    // the jobs together, so the phases do not release the freed memory of the process, and their
+    // process-wide measurements are not to be reported; only their times and items are.
+    static void share_process() { process_shared_ = true; }
+
+    // Returns whether the process is shared by concurrent jobs.
+    static bool process_shared() { return process_shared_; }
+
+    // Starts recording a phase.
+    Phase_Metrics();
+
+    // Ends the phase, with `items` items processed in it.
+    void end(uint64_t items);
+
+    // Returns the wall-clock time of the phase in seconds.
+    double wall_time() const;
+
+    // Returns the start time of the phase.
+    clock_t::time_point start_time() const { return start_.wall; }
+
+    // Returns the end time of the phase.
+    clock_t::time_point end_time() const { return end_.wall; }
+
+    // Returns the CPU time of the phase in seconds, over all the threads.
+    double cpu_time() const;
+
+    // Returns the peak RSS (in bytes) of the process till the end of the phase.
+    std::size_t peak_rss() const { return end_.peak_rss; }
+
+    // Returns the amount (in bytes) by which the phase raised the peak RSS of the process; it is 0
+    // iff the phase stayed under the peak of the earlier phases.
+    std::size_t peak_rss_rise() const { return end_.peak_rss - start_.peak_rss; }
+
+    // Returns the RSS (in bytes) of the process at the end of the phase.
+    std::size_t curr_rss() const { return curr_rss_; }
+
+    // Returns the number of bytes read by the process during the phase.
+    uint64_t bytes_read() const { return end_.bytes_read - start_.bytes_read; }
+
+    // Returns the number of bytes written by the process during the phase.
+    uint64_t bytes_written() const { return end_.bytes_written - start_.bytes_written; }
+
+    // Returns the number of items processed in the phase.
+    uint64_t items() const { return items_; }
+
+#ifdef CF_CONTENTION_STATS
+    // Returns the contention statistics over the hash table during the phase.
+    const nlohmann::ordered_json& contention() const { return contention_; }
+#endif
+
+#ifdef CF_PERF_COUNTERS
+    // Returns the hardware counts of the phase, in total and per worker thread.
+    const nlohmann::ordered_json& hw_counters() const { return hw_counters_; }
+#endif
+};
+
+
+
+#endif
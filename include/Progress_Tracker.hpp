@@ -4,34 +4,82 @@
 
 
 
-#include "Spin_Lock.hpp"
-
 #include <cstdint>
+#include <cstddef>
 #include <string>
-#include <cmath>
-#include <iostream>
+#include <atomic>
+#include <thread>
+#include <chrono>
 
 
-// A basic class to track and display progress for some work.
+// A class to track and report progress for some work. The worker threads add their completed
+// work to relaxed per-thread counters, and a background reporter periodically displays the
+// throughput, the percentage, and the estimated time remaining for the work; and optionally
+// writes those as JSON lines into a status file or a UNIX socket, for machine monitoring.
 class Progress_Tracker
 {
 private:
 
+    typedef std::chrono::steady_clock clock_t;
+
+    static constexpr std::size_t COUNTER_COUNT = 64;    // Number of the per-thread work counters.
+
+    // A counter of work done, on a cache-line of its own.
+    struct alignas(L1_CACHE_LINE_SIZE) Work_Counter
+    {
+        std::atomic<uint64_t> work{0};
+    };
+
     uint64_t total_work_load;  //   Total amount of work to be done over time.
     uint64_t work_chunk_threshold; // Granularity of the provided work chunk sizes that triggers tracking updates.
-
-    uint64_t total_work_done;   // Amount of work done until now.
-    uint16_t percent_work_done; // Percentage of the completed workload.
     std::string log_message;  // Message to display at the logs.
 
-    Spin_Lock lock;  // Lock to ensure multiple threads can access the tracker safely.
+    Work_Counter work_done[COUNTER_COUNT];  // Amounts of work done until now, by thread slots.
+
+    std::atomic<bool> tracking; // Whether some work is being tracked currently.
+    std::thread reporter;   // The background reporter thread.
+
+    static std::string status_path; // Path to the JSON-lines status file, or to the UNIX socket with a `unix:` prefix.
+    static double report_interval;  // Interval between consecutive reports, in seconds.
+
+    static std::atomic<uint32_t> thread_slot_count; // Number of the thread slots assigned till now.
+    static thread_local const uint32_t thread_slot; // Slot of the executing thread in the work counters.
+
+
+    // Returns the amount of work done until now.
+    uint64_t work_done_sum() const;
+
+    // Periodically reports the progress till the tracking is finished.
+    void report();
+
+    // Opens the status sink, and returns its file descriptor; `-1` if there is none or if it
+    // could not be opened. Sets `is_socket` to whether the sink is a UNIX socket.
+    static int open_status_sink(bool& is_socket);
+
+    // Writes the line `line` into the status sink with file descriptor `fd`.
+    static void write_status(int fd, bool is_socket, const std::string& line);
+
 
 public:
+
+    // Constructs a tracker, yet to be set up for some work.
+    Progress_Tracker();
+
+    // Finishes any ongoing tracking.
+    ~Progress_Tracker();
+
+    Progress_Tracker(const Progress_Tracker&) = delete;
+    Progress_Tracker& operator=(const Progress_Tracker&) = delete;
+
+    // Sets the status sink of the trackers to `path`: a JSON-lines file, or a UNIX socket if
+    // prefixed with `unix:`; and the interval between consecutive reports to `interval` seconds.
+    static void set_status_sink(const std::string& path, double interval);
+
   // Sets up the tracker for some task with total size `total_work_load`;
   // updates to the tracking are to be triggered when some work-chunk of size at
   // least `work_chunk_threshold` is provided to it. The log message to be
-  // displayed over the course of tracking is `log_message`.
-  // 为某些任务设置跟踪器，总大小为`total_work_load`;当向跟踪提供了大小至少为`work_chunk_threshold`的工作块时，将触发对跟踪的更新。在跟踪过程中显示的日志消息是`log_message`。
+  // displayed over the course of tracking is `log_message`. Launches the
+  // background reporter.
   void setup(uint64_t total_work_load, uint64_t work_chunk_threshold,
              const std::string &log_message);
 
@@ -40,42 +88,17 @@ public:
   // returned. All lesser sized chunk update requests are ignored and `false` is
   // returned. So, repeated invocation is suggested.
   bool track_work(uint64_t work_chunk_size);
+
+  // Finishes the tracking, stopping the background reporter after a final report.
+  void finish();
 };
 
 
-/**
- * @brief 跟踪工作进度
- *
- * 根据给定的工作块大小，跟踪并更新工作进度。如果工作块大小达到或超过设定的阈值，则更新总完成工作量，
- * 计算新的工作百分比，并打印进度信息。
- *
- * @param work_chunk_size 工作块大小
- *
- * @return 如果工作块大小达到或超过阈值，则返回 true；否则返回 false
- */
 inline bool Progress_Tracker::track_work(const uint64_t work_chunk_size)
 {
     if(work_chunk_size >= work_chunk_threshold)
     {
-        lock.lock();
-        
-        total_work_done += work_chunk_size;
-        // 计算已完成工作量占总工作量的百分比。首先，将 total_work_done 乘以
-        // 100.0，然后除以 total_work_load（总工作量）。接着，使用 std::round
-        // 对结果进行四舍五入，并将结果转换为 uint16_t 类型。
-        const uint16_t new_percent = static_cast<uint16_t>(std::round((total_work_done * 100.0) / total_work_load));
-        if(percent_work_done < new_percent)
-        {
-          // 如果新的百分比大于 当前的进度百分比 percent_work_done，则更新
-          // percent_work_done
-          // 并打印新的进度信息到标准错误流（通常用于输出错误信息或诊断信息）。
-          percent_work_done = new_percent;
-          std::cerr << "\r[" << log_message << "]\t" << percent_work_done
-                    << "%";
-        }
-
-        lock.unlock();
-
+        work_done[thread_slot].work.fetch_add(work_chunk_size, std::memory_order_relaxed);
         return true;
     }
 
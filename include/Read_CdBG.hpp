@@ -51,6 +51,10 @@ private:
     // Extracts the maximal unitigs from the graph.
     void extract_maximal_unitigs();
 
+    // Constructs the compacted graph out-of-core over minimizer-partitions of its `vertex_count`
+    // vertices, and returns the maximum disk-usage incurred by the partitions' buckets.
+    std::size_t construct_partitioned(uint64_t vertex_count);
+
     // Returns `true` iff the compacted de Bruijn graph to be built from the parameters
     // collection `params` had been constructed in an earlier execution.
     // NB: only the existence of the output meta-info file is checked for this purpose.
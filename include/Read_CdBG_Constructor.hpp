@@ -14,10 +14,12 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
 
 template <uint16_t k> class Kmer_SPMC_Iterator;
 template <uint16_t k> class Thread_Pool;
+template <uint16_t k> class Partitioned_CdBG;
 
 
 // A class to construct compacted read de Bruijn graphs.
@@ -25,6 +27,7 @@ template <uint16_t k>
 class Read_CdBG_Constructor
 {
     friend class Thread_Pool<k>;
+    friend class Partitioned_CdBG<k>;
 
 private:
 
@@ -39,6 +42,29 @@ private:
     
     Progress_Tracker progress_tracker;  // Progress tracker for the DFA states computation task.
 
+    // Scattering data of a worker thread for the owner-computes states computation.
+    struct alignas(L1_CACHE_LINE_SIZE) Scatter_Worker
+    {
+        std::vector<std::vector<uint64_t>> buf; // `buf[o]` collects the encoded endpoint-updates for the slice of the owner `o`.
+        uint64_t edge_count;    // Number of edges processed by the worker.
+        uint64_t progress;  // Number of edges processed by the worker; is reset at reaching 1% of its approximate workload.
+        bool exhausted; // Whether the edges for the worker have been depleted.
+    };
+
+    static constexpr std::size_t EDGE_BATCH_SZ = 32;    // Number of edges whose endpoints are hashed together in a batch.
+
+    static constexpr uint64_t ROUND_EDGE_COUNT = (1 << 18); // Maximum number of edges scattered by a worker per round of the owner-computes states computation.
+
+    // The passes of the states computation tasks for the thread pool. The owner-computes scheme
+    // alternates between its scatter and apply passes on the same pool, with its completion-waits
+    // as the barriers between the two passes of a round.
+    static constexpr uint8_t edges_pass = 0;
+    static constexpr uint8_t scatter_pass = 1;
+    static constexpr uint8_t apply_pass = 2;
+
+    uint64_t slice_size;    // Number of consecutive hash table buckets owned by each thread in the owner-computes states computation.
+    std::vector<Scatter_Worker> scatter_worker; // Scattering data of the worker threads for the owner-computes states computation.
+
 
     // Distributes the DFA-states computation task — disperses the graph edges (i.e. (k + 1)-mers)
     // parsed by the parser `edge_parser` to the worker threads in the thread pool `thread_pool`,
@@ -54,15 +80,31 @@ private:
     // `(u, v)` provided to that thread, in order to construct a CdBG.
     void process_cdbg_edges(Kmer_SPMC_Iterator<k + 1>* edge_parser, uint16_t thread_id);
 
+    // Processes the edges provided to the thread with id `thread_id` from the parser `edge_parser`
+    // similar to `process_cdbg_edges`, but coalesces the runs of consecutive edges that share their
+    // prefix vertex `u` — the effect of a run on `u` is merged locally, and `u` is looked up and
+    // updated only once per run.
+    void process_cdbg_edges_coalesced(Kmer_SPMC_Iterator<k + 1>* edge_parser, uint16_t thread_id);
+
     // Processes the edges provided to the thread with id `thread_id` from the parser `edge_parser`,
     // i.e. makes state-transitions for the DFA of the vertices `u` and `v` for each bidirected edge
     // `(u, v)` provided to that thread, to construct a maximal path cover of the dBG.
     void process_path_cover_edges(Kmer_SPMC_Iterator<k + 1>* edge_parser, uint16_t thread_id);
 
+    // Returns the encoding of a vertex-side with the incident edge-encoding `e_curr` after adding an
+    // incident edge `e` to it: the DFA transition of the side. An `N`-edge `e` discards the
+    // incidence information of the side, as for loops.
+    static cuttlefish::edge_encoding_t transition(cuttlefish::edge_encoding_t e_curr, cuttlefish::edge_encoding_t e);
+
     // Adds the information of an incident edge `e` to the side `s` of some vertex `v`, all wrapped
     // inside the edge-endpoint object `endpoint` — making the appropriate state transitions for the
     // DFA of `v`. Returns `false` iff an attempted state transition failed.
     bool add_incident_edge(const Endpoint<k>& endpoint);
+
+    // Adds the information of incident edges merged into the encoding `e` to the side `s` of the
+    // vertex with hash `h` — making the appropriate state transitions for its DFA. `e` is `N` if
+    // the merged edges are distinct. Returns `false` iff an attempted state transition failed.
+    bool add_incident_edges(uint64_t h, cuttlefish::side_t s, cuttlefish::edge_encoding_t e);
     
     // Adds the information of an incident loop that connects the two different endpoints of some
     // vertex `v`, wrapped inside the edge-endpoint object `endpoint` — making the appropriate state
@@ -82,6 +124,23 @@ private:
     // could not be added as such.
     bool add_path_cover_edge(const Edge<k>& e);
 
+    // Computes the DFA states with the edges from the parser `edge_parser` in rounds on the thread
+    // pool `thread_pool`, where each thread owns a contiguous slice of the hash table. In a round,
+    // the threads first scatter the endpoint-updates of a batch of edges into per-owner buffers,
+    // and then each thread applies the updates for its own slice, without any synchronization.
+    void compute_states_owner_computes(Kmer_SPMC_Iterator<k + 1>& edge_parser, Thread_Pool<k>& thread_pool);
+
+    // Scatters the endpoint-updates of up-to `ROUND_EDGE_COUNT` edges provided to the thread with
+    // id `thread_id` from the parser `edge_parser` into the buffers of their owners.
+    void scatter_updates(Kmer_SPMC_Iterator<k + 1>& edge_parser, uint16_t thread_id);
+
+    // Adds an update of the edge encoding `e` to the side `s` of the vertex with hash `h` into the
+    // buffer of its owner, for the worker thread with id `thread_id`.
+    void add_update(uint16_t thread_id, uint64_t h, cuttlefish::side_t s, cuttlefish::edge_encoding_t e);
+
+    // Applies the endpoint-updates scattered for the slice of the owner thread with id `owner_id`.
+    void apply_updates(uint16_t owner_id);
+
 
 public:
 
@@ -146,6 +205,20 @@ private:
 };
 
 
+template <uint16_t k>
+inline cuttlefish::edge_encoding_t Read_CdBG_Constructor<k>::transition(const cuttlefish::edge_encoding_t e_curr, const cuttlefish::edge_encoding_t e)
+{
+    // If we've already discarded the incidence information for this side, then a self-transition happens;
+    // so does it for the same edge visiting the side again.
+    if(e_curr == cuttlefish::edge_encoding_t::N || e_curr == e)
+        return e_curr;
+
+    // An empty side takes the edge; otherwise the side has been visited earlier, but with a different
+    // edge—discard the incidence information.
+    return e_curr == cuttlefish::edge_encoding_t::E ? e : cuttlefish::edge_encoding_t::N;
+}
+
+
 template <uint16_t k>
 /**
  * @brief 添加邻接边
@@ -168,37 +241,43 @@ inline bool Read_CdBG_Constructor<k>::add_incident_edge(const Endpoint<k>& endpo
     // 这里是根据back和front来获取DNA::Extended_Base
     // extended_base 记录下一个碱基或者 分支状态
     const cuttlefish::edge_encoding_t e_curr = state.edge_at(endpoint.side());
+    const cuttlefish::edge_encoding_t e_new = transition(e_curr, endpoint.edge());
+
+    // We can get away without updating the same value again, because — (1)
+    // even if this DFA's state changes in the hash table by the time this
+    // method completes, making no updates at this point is theoretically
+    // equivalent to returning instantaneously as soon as the hash table value
+    // had been read; and also (2) the ordering of the edges processed does
+    // not matter in the algorithm.
+    // 我们可以不用再次更新相同的值，因为-
+    // (1) 即使这个方法完成时，这个DFA的状态在哈希表中发生了变化，从理论上讲，此时不进行更新等同于一旦读取哈希表的值就立即返回;
+    // (2) 在算法中，所处理边的顺序无关紧要。
+    if(e_new == e_curr)
+        return true;
 
-    // If we've already discarded the incidence information for this side, then a self-transition happens.
-    // 如果我们已经丢弃了这一侧的关联信息，则会发生自转换。
-    if(e_curr == cuttlefish::edge_encoding_t::N)
-        return true;    // The side has already been determined to be branching—nothing to update here anymore.这边已经确定要进行分支，这里不再需要更新任何内容。
-
-    cuttlefish::edge_encoding_t e_new = endpoint.edge();
-    if(e_curr != cuttlefish::edge_encoding_t::E)    // The side is not empty.
-    {
-      // We can get away without updating the same value again, because — (1)
-      // even if this DFA's state changes in the hash table by the time this
-      // method completes, making no updates at this point is theoretically
-      // equivalent to returning instantaneously as soon as the hash table value
-      // had been read; and also (2) the ordering of the edges processed does
-      // not matter in the algorithm.
-      // 我们可以不用再次更新相同的值，因为-
-      // (1) 即使这个方法完成时，这个DFA的状态在哈希表中发生了变化，从理论上讲，此时不进行更新等同于一旦读取哈希表的值就立即返回;
-      // (2) 在算法中，所处理边的顺序无关紧要。
-        if(e_new == e_curr)
-            return true;
-
-        // This side has been visited earlier, but with a different edge—discard the incidence information.
-        // 这一侧之前已经访问过，但具有不同的边——丢弃邻接信息。
-        e_new = cuttlefish::edge_encoding_t::N;
-    }
     // side = front就设置front的编码,反之back的编码。
     state.update_edge_at(endpoint.side(), e_new);
     return hash_table.update(bucket);
 }
 
 
+template <uint16_t k>
+inline bool Read_CdBG_Constructor<k>::add_incident_edges(const uint64_t h, const cuttlefish::side_t s, const cuttlefish::edge_encoding_t e)
+{
+    Kmer_Hash_Entry_API<cuttlefish::BITS_PER_READ_KMER> bucket = hash_table[h];
+    State_Read_Space& state = bucket.get_state();
+    const cuttlefish::edge_encoding_t e_curr = state.edge_at(s);
+    const cuttlefish::edge_encoding_t e_new = transition(e_curr, e);
+
+    // We can get away without updating the same value again: see detailed comment in `add_incident_edge`.
+    if(e_new == e_curr)
+        return true;
+
+    state.update_edge_at(s, e_new);
+    return hash_table.update(bucket);
+}
+
+
 template <uint16_t k>
 /**
  * @brief 添加交叉环
@@ -265,6 +344,14 @@ inline bool Read_CdBG_Constructor<k>::add_one_sided_loop(const Endpoint<k>& endp
 }
 
 
+template <uint16_t k>
+inline void Read_CdBG_Constructor<k>::add_update(const uint16_t thread_id, const uint64_t h, const cuttlefish::side_t s, const cuttlefish::edge_encoding_t e)
+{
+    // Encoding: the bucket ID, followed by one bit for the side, and three bits for the edge.
+    scatter_worker[thread_id].buf[h / slice_size].push_back((h << 4) | (static_cast<uint64_t>(s) << 3) | static_cast<uint64_t>(e));
+}
+
+
 template <uint16_t k>
 bool Read_CdBG_Constructor<k>::add_path_cover_edge(const Edge<k>& e)
 {
@@ -15,11 +15,18 @@
 #include "Output_Sink.hpp"
 #include "Unipaths_Meta_info.hpp"
 #include "Progress_Tracker.hpp"
+#include "Atomic_Bit_Vector.hpp"
+#include "Character_Buffer.hpp"
 
 #include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <algorithm>
 #include <ostream>
 #include <string>
+#include <vector>
+#include <sys/types.h>
 
 
 // Forward declarations.
@@ -45,6 +52,9 @@ private:
 
     // TODO: give these limits more thoughts, especially their exact impact on the memory usage.
     static constexpr std::size_t BUFF_SZ = 100 * 1024ULL;   // 100 KB (soft limit) worth of maximal unitig records (FASTA) can be retained in memory, at most, before flushing.
+    static constexpr std::size_t VERTEX_BATCH_SZ = 64;  // Number of vertices whose hashes are computed together in a batch.
+    static constexpr std::size_t CANDIDATE_BUF_SZ = 4096;   // Number of cycle-candidate vertices retained in memory per thread, at most, before flushing.
+    static constexpr std::size_t STREAM_CHUNK_SZ = 1024 * 1024ULL;  // 1M vertices (~9 MB of scratch) of a walk can be retained in memory, at most, before streaming it out.
 
     mutable uint64_t vertices_scanned = 0;    // Total number of vertices scanned from the database.
     mutable Spin_Lock lock; // Mutual exclusion lock to access various unique resources by threads spawned off this class' methods.
@@ -55,38 +65,120 @@ private:
 
     Progress_Tracker progress_tracker;  // Progress tracker for the maximal unitigs extraction task.
 
+    // Flags for the vertices (indexed by their hashes) that have been outputted. The DFA states
+    // in the hash table are frozen during the extraction, and thus are read without locks.
+    Atomic_Bit_Vector outputted;
 
-    // Distributes the maximal unitigs extraction task — disperses the graph vertices (i.e. k-mers)
-    // parsed by the parser `vertex_parser` to the worker threads in the thread pool `thread_pool`,
-    // for the unitpath-flanking vertices to be identified and the corresponding unipaths to be extracted.
-    void distribute_unipaths_extraction(Kmer_SPMC_Iterator<k>* vertex_parser, Thread_Pool<k>& thread_pool);
+    // The passes of the extraction. The walks start only from the flanking vertices of the maximal
+    // unitigs in the first pass. The detached chordless cycles have no flanking vertex; so the
+    // interior vertices that have smaller hashes than their neighbors — which include the vertex
+    // with the minimum hash of each cycle — are spilled as candidates for the second pass, which
+    // walks from the ones that are left unmarked.
+    static constexpr uint8_t flanks_pass = 0;
+    static constexpr uint8_t cycles_pass = 1;
+
+    // A candidate vertex to walk a detached chordless cycle from, with its hash.
+    struct Cycle_Candidate
+    {
+        Kmer<k> v_hat;
+        uint64_t h;
+    };
+
+    // Very long maximal unitigs are streamed out of the scratch in chunks as they are walked: the
+    // labels and the vertex hashes are spilled into files of the walking thread. Like the walks in
+    // the scratch, a streamed walk claims its maximal unitig only at its end, through the sign
+    // vertex; its spilled vertices are marked then, and a walk that loses the claim just discards
+    // its spill.
+    struct Walk_Spill
+    {
+        std::string label_path; // Path to the spill file for the label of the current walk.
+        std::string hash_path;  // Path to the spill file for the vertex hashes of the current walk.
+        std::string unitigs_path;   // Path to the file for the streamed maximal unitigs, appended to the output at the end.
+        std::FILE* label = nullptr; // Spill file for the label of the current walk.
+        std::FILE* hash = nullptr;  // Spill file for the vertex hashes of the current walk.
+        std::FILE* unitigs = nullptr;   // File for the streamed maximal unitigs.
+        off_t label_len = 0;    // Length of the label of the current walk spilled so far.
+        off_t hash_count = 0;   // Number of vertex hashes of the current walk spilled so far.
+        std::vector<char> buf;  // Buffer to read the spilled label back into.
+        std::vector<uint64_t> hash_buf; // Buffer to read the spilled hashes back into.
+    };
+
+    std::vector<Walk_Spill> walk_spill; // `walk_spill[t]` is the spill of the thread with id `t`.
+
+    std::vector<std::vector<uint64_t>> path_buf;    // `path_buf[t]` is the scratch of the thread with id `t` to collect the vertex hashes of a maximal unitig into, for their marking.
+
+
+    // Distributes the pass `pass` of the maximal unitigs extraction task to the worker threads in
+    // the thread pool `thread_pool`; the vertices are parsed by `vertex_parser` in the first pass.
+    void distribute_unipaths_extraction(Kmer_SPMC_Iterator<k>* vertex_parser, Thread_Pool<k>& thread_pool, uint8_t pass);
 
     // Prcesses the vertices provided to the thread with id `thread_id` from the parser
-    // `vertex_parser`, i.e. for each vertex `v` provided to that thread, attempts to
-    // piece-wise construct its containing maximal unitig.
+    // `vertex_parser`, i.e. for each vertex `v` provided to that thread, constructs its
+    // containing maximal unitig if `v` flanks it, and spills `v` as a cycle-candidate
+    // otherwise if its hash is smaller than its neighbors'.
     void process_vertices(Kmer_SPMC_Iterator<k>* vertex_parser, uint16_t thread_id);
 
+    // Processes the cycle-candidate vertices spilled by the thread with id `thread_id`, i.e. for
+    // each candidate left unmarked, constructs its containing detached chordless cycle.
+    void process_cycle_candidates(uint16_t thread_id);
+
+    // Returns the path to the file of the cycle-candidate vertices of the thread with id `thread_id`.
+    const std::string cycle_candidates_path(uint16_t thread_id) const;
+
+    // Outputs the extracted maximal unitig `maximal_unitig` from the thread with id `thread_id` —
+    // into the caller's sink, if any, or else into `output_buffer`, or into the thread's file of
+    // the streamed unitigs if it has been streamed; and records it into `info`.
+    void output_maximal_unitig(const Maximal_Unitig_Scratch<k>& maximal_unitig, uint16_t thread_id, Character_Buffer<BUFF_SZ, sink_t>& output_buffer, Unipaths_Meta_info<k>& info);
+
     // Extracts the maximal unitig `p` that contains the vertex `v_hat`, and `maximal_unitig` is
     // used as the working scratch for the extraction, i.e. to build and store the two unitigs
     // connecting to the two sides of `v_hat`. Returns `true` iff the extraction is successful,
     // which happens when `p` is attempted for output-marking first by this thread.
     bool extract_maximal_unitig(const Kmer<k>& v_hat, Maximal_Unitig_Scratch<k>& maximal_unitig);
 
+    // Extracts the maximal unitig containing the vertex `v_hat` with hash `h` into `maximal_unitig`,
+    // like the above. The long walks are streamed out of the scratch into `spill`, if provided.
+    bool extract_maximal_unitig(const Kmer<k>& v_hat, uint64_t h, Maximal_Unitig_Scratch<k>& maximal_unitig, Walk_Spill* spill = nullptr);
+
+    // Returns whether the vertex `v_hat` with the state `state` flanks its containing maximal
+    // unitig, i.e. whether the walk from it through some side ends right at it: the side has no
+    // unique incident edge, or the unique neighbor through it branches at its entrance side. The
+    // neighbors are probed as the DFA states do not propagate the branching to them. If not, the
+    // smaller of the hashes of its two neighbors is put in `h_nbr_min`.
+    bool is_flanking_vertex(const Kmer<k>& v_hat, State_Read_Space state, uint64_t& h_nbr_min) const;
+
     // Traverses a unitig starting from the vertex `v_hat`, exiting it through the side `s_v_hat`.
     // The DFA of `v_hat` is supposed to have the state `st_v`. `unitig` is used as the working
     // scratch to build the unitig. Returns `true` iff the unitig could have been traversed
     // maximally up-to its endpoint in the direction of the walk from `v_hat`, which is possible
-    // iff no other thread output-marks it in the meantime.
-    bool walk_unitig(const Kmer<k>& v_hat, State_Read_Space st_v, cuttlefish::side_t s_v_hat, Unitig_Scratch<k>& unitig);
+    // iff no other thread output-marks it in the meantime. The walk is streamed out of the scratch
+    // in chunks into `spill`, if provided.
+    bool walk_unitig(const Kmer<k>& v_hat, State_Read_Space st_v, cuttlefish::side_t s_v_hat, Unitig_Scratch<k>& unitig, Walk_Spill* spill);
+
+    // Streams out the part of the walk `unitig` retained in its scratch into `spill`: its label and
+    // its vertex hashes. The first chunk of a walk overwrites the spill of any earlier walk.
+    void stream_chunk(Unitig_Scratch<k>& unitig, Walk_Spill& spill);
+
+    // Marks the vertices of the streamed walk spilled into `spill` as outputted.
+    void mark_spilled_path(Walk_Spill& spill);
+
+    // Writes the streamed maximal unitig `maximal_unitig`, with its walk spilled into `spill`, into
+    // the file of the streamed unitigs of `spill`, in its canonical form.
+    void write_streamed_unitig(const Maximal_Unitig_Scratch<k>& maximal_unitig, Walk_Spill& spill);
+
+    // Appends the streamed maximal unitigs, if any, to the output file at `output_file_path`, and
+    // removes the spill files.
+    void append_streamed_unitigs(const std::string& output_file_path);
 
     // Marks all the vertices which have their hashes present in `path_hashes` as outputted.
-    void mark_path(const std::vector<uint64_t>& path_hashes);
+    // `path_hashes` is sorted in place.
+    void mark_path(std::vector<uint64_t>& path_hashes);
 
-    // Marks all the vertices in the constituent unitigs of `maximal_unitig` as outputted.
-    void mark_maximal_unitig(const Maximal_Unitig_Scratch<k>& maximal_unitig);
+    // Marks all the vertices in the constituent unitigs of `maximal_unitig` as outputted, collecting
+    // their hashes into the scratch `path_hashes` first.
+    void mark_maximal_unitig(const Maximal_Unitig_Scratch<k>& maximal_unitig, std::vector<uint64_t>& path_hashes);
 
-    // Marks the vertex `v` as outputted. Returns `true` iff `v` has not been marked yet and the hash
-    // table update is successful.
+    // Marks the vertex `v` as outputted. Returns `true` iff `v` has not been marked yet.
     bool mark_vertex(const Directed_Vertex<k>& v);
 
     // Initializes the output sink, corresponding to the file `output_file_path`.
@@ -246,17 +338,7 @@ template <uint16_t k>
  */
 inline bool Read_CdBG_Extractor<k>::mark_vertex(const Directed_Vertex<k>& v)
 {
-    //根据标志顶点的hash值获取Entry_API
-    Kmer_Hash_Entry_API<cuttlefish::BITS_PER_READ_KMER> bucket = hash_table[v.hash()];
-    //这个桶就是用来找对应state的
-    State_Read_Space& state = bucket.get_state();
-    //如果两端已经确定了是非分支,则直接返回false
-    if(state.is_outputted())
-        return false;
-    //标记已输出
-    state.mark_outputted();
-    // 凡是更新 state,都先用拷贝,然后更新
-    return hash_table.update(bucket);
+    return outputted.set(v.hash());
 }
 
 
@@ -268,10 +350,9 @@ template <uint16_t k>
  *
  * @param path_hashes 路径哈希值向量
  */
-inline void Read_CdBG_Extractor<k>::mark_path(const std::vector<uint64_t>& path_hashes)
+inline void Read_CdBG_Extractor<k>::mark_path(std::vector<uint64_t>& path_hashes)
 {   //每个顶点都标记为已输出
-    for(const uint64_t hash: path_hashes)
-        hash_table.update(hash, State_Read_Space::mark_outputted);
+    outputted.set(path_hashes);
 }
 
 
@@ -283,19 +364,22 @@ template <uint16_t k>
  *
  * @param maximal_unitig 最大单元体信息
  */
-inline void Read_CdBG_Extractor<k>::mark_maximal_unitig(const Maximal_Unitig_Scratch<k>& maximal_unitig)
+inline void Read_CdBG_Extractor<k>::mark_maximal_unitig(const Maximal_Unitig_Scratch<k>& maximal_unitig, std::vector<uint64_t>& path_hashes)
 {
     // 如果最大单元体是线性的
     if(maximal_unitig.is_linear())
     {
-        // 标记后向路径
-        mark_path(maximal_unitig.unitig_hash(cuttlefish::side_t::back));
-        // 标记前向路径
-        mark_path(maximal_unitig.unitig_hash(cuttlefish::side_t::front));
+        // 收集后向路径与前向路径
+        const std::vector<uint64_t>& back_hashes = maximal_unitig.unitig_hash(cuttlefish::side_t::back);
+        const std::vector<uint64_t>& front_hashes = maximal_unitig.unitig_hash(cuttlefish::side_t::front);
+        path_hashes.assign(back_hashes.begin(), back_hashes.end());
+        path_hashes.insert(path_hashes.end(), front_hashes.begin(), front_hashes.end());
     }
     else
-        // 如果最大单元体是环形的，则标记循环哈希
-        mark_path(maximal_unitig.cycle_hash());
+        // 如果最大单元体是环形的，则收集循环哈希
+        path_hashes.assign(maximal_unitig.cycle_hash().begin(), maximal_unitig.cycle_hash().end());
+
+    mark_path(path_hashes);
 }
 
 
@@ -314,28 +398,67 @@ template <uint16_t k>
  * @return 提取成功返回true，否则返回false
  */
 inline bool Read_CdBG_Extractor<k>::extract_maximal_unitig(const Kmer<k>& v_hat, Maximal_Unitig_Scratch<k>& maximal_unitig)
+{
+    //返回 v_hat的state_
+    return extract_maximal_unitig(v_hat, hash_table(v_hat), maximal_unitig);
+}
+
+
+template <uint16_t k>
+inline bool Read_CdBG_Extractor<k>::is_flanking_vertex(const Kmer<k>& v_hat, const State_Read_Space state, uint64_t& h_nbr_min) const
+{
+    Kmer<k> v_bar;
+    v_bar.as_reverse_complement(v_hat);
+    h_nbr_min = std::numeric_limits<uint64_t>::max();
+
+    for(const cuttlefish::side_t s: {cuttlefish::side_t::back, cuttlefish::side_t::front})
+    {
+        const cuttlefish::edge_encoding_t e = state.edge_at(s);
+        if(cuttlefish::is_fuzzy_edge(e))
+            return true;
+
+        // Roll to the neighbor `u` through `s`, in the orientation of the walk exiting `v_hat` through `s`.
+        Kmer<k> u(s == cuttlefish::side_t::back ? v_hat : v_bar);
+        Kmer<k> u_bar(s == cuttlefish::side_t::back ? v_bar : v_hat);
+        const cuttlefish::base_t b = (s == cuttlefish::side_t::back ? DNA_Utility::map_base(e) : DNA_Utility::complement(DNA_Utility::map_base(e)));
+        u.roll_to_next_kmer(b, u_bar);
+
+        const Kmer<k>* const u_hat = Kmer<k>::canonical(u, u_bar);
+        const cuttlefish::side_t s_u = (u_hat == &u ? cuttlefish::side_t::front : cuttlefish::side_t::back);  // The entrance side of `u`.
+        const uint64_t h_u = hash_table(*u_hat);
+        if(hash_table.at_exclusive(h_u).state().is_branching_side(s_u))
+            return true;
+
+        h_nbr_min = std::min(h_nbr_min, h_u);
+    }
+
+    return false;
+}
+
+
+template <uint16_t k>
+inline bool Read_CdBG_Extractor<k>::extract_maximal_unitig(const Kmer<k>& v_hat, const uint64_t h, Maximal_Unitig_Scratch<k>& maximal_unitig, Walk_Spill* const spill)
 {
     static constexpr cuttlefish::side_t back = cuttlefish::side_t::back;
     static constexpr cuttlefish::side_t front = cuttlefish::side_t::front;
 
-    //返回 v_hat的state_
-    State_Read_Space state = hash_table[v_hat].state(); // State of the vertex `v_hat`.
+    State_Read_Space state = hash_table.at_exclusive(h).state(); // State of the vertex `v_hat`.
     // 包含maximal unitig的元素已经输出。
     // 就是表示该点的两个side的 state都已经确定了。
-    if(state.is_outputted())    // The containing maximal unitig has already been outputted.
+    if(outputted.test(h))   // The containing maximal unitig has already been outputted.
         return false;
 
     // 让cycle = nullptr
     maximal_unitig.mark_linear();
     // 获取v_hat的状态state,然后从back开始walk,使用 unitig_back作为容器
-    if(!walk_unitig(v_hat, state, back, maximal_unitig.unitig(back)))
+    if(!walk_unitig(v_hat, state, back, maximal_unitig.unitig(back), spill))
         return false;//为false的情况,到达的顶点两端side是否分支已经确定,但是当前到达的side却不是分支
     // unitig() 返回对应side的 Unitig_Scratch<k>
     // 上面都标记了cycle = nullptr,为什么还需要这样判断环?
     if(maximal_unitig.unitig(back).is_cycle())
         maximal_unitig.mark_cycle(back);//是环就把对应side的unitig类赋值给cycle
     else
-        if(!walk_unitig(v_hat, state, front, maximal_unitig.unitig(front)))
+        if(!walk_unitig(v_hat, state, front, maximal_unitig.unitig(front), spill))
             return false;
 
     // sign_vertex() 返回两端端点中更小的顶点
@@ -362,7 +485,7 @@ template <uint16_t k>
  *
  * @return 遍历是否成功
  */
-inline bool Read_CdBG_Extractor<k>::walk_unitig(const Kmer<k>& v_hat, const State_Read_Space st_v, const cuttlefish::side_t s_v_hat, Unitig_Scratch<k>& unitig)
+inline bool Read_CdBG_Extractor<k>::walk_unitig(const Kmer<k>& v_hat, const State_Read_Space st_v, const cuttlefish::side_t s_v_hat, Unitig_Scratch<k>& unitig, Walk_Spill* const spill)
 {
     // Data structures to be reused per each vertex extension of the unitig.
     // 需要被重用的数据结构
@@ -395,13 +518,13 @@ inline bool Read_CdBG_Extractor<k>::walk_unitig(const Kmer<k>& v_hat, const Stat
         v.roll_forward(b_ext, hash_table);  // Walk to the next vertex.
         // std::cout << "v的移动后的标签是" << v.kmer().string_label() << std::endl;
         // 同理 state
-        state = hash_table[v.hash()].state();
+        state = hash_table.at_exclusive(v.hash()).state();
         // 同理 s_v
         // v的kmer是否为 canoical kmer,如果是就是back，如果不是就是front
         s_v = v.entrance_side();
         // 到达的顶点两边side都已经确定是否为非分支
-        if(state.is_outputted())
-            return state.was_branching_side(s_v);   // If `s_v` was a branching side, then the walk just crossed to a different unitig;
+        if(outputted.test(v.hash()))
+            return state.is_branching_side(s_v);   // If `s_v` was a branching side, then the walk just crossed to a different unitig;
                                                     // so this unitig is depleted. Otherwise, `s_v` must belong to this unitig. In that
                                                     // case, the unitig has already been outputted earlier.
         // 到达的side状态为N,return True
@@ -412,6 +535,10 @@ inline bool Read_CdBG_Extractor<k>::walk_unitig(const Kmer<k>& v_hat, const Stat
         // 如果扩展到anchor,也就是起始点就break
         if(!unitig.extend(v, DNA_Utility::map_char(b_ext)))
             break;  // The unitig is a DCC (Detached Chordless Cycle).
+
+        if(spill != nullptr && unitig.hash().size() >= STREAM_CHUNK_SZ)
+            stream_chunk(unitig, *spill);
+
         // 到达顶点的另一端side
         s_v = cuttlefish::opposite_side(s_v);
     }
@@ -0,0 +1,76 @@
+
+#ifndef SCALING_BENCH_HPP
+#define SCALING_BENCH_HPP
+
+
+
+#include "nlohmann/json.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <map>
+
+
+// A driver to benchmark the scalability of the compacted read de Bruijn graph construction,
+// end-to-end, over synthetic genomes and reads. It sweeps the thread counts and the input
+// sizes, and reports strong- and weak-scaling curves with the per-phase metrics and the peak
+// memory (RSS) of each run.
+class Scaling_Bench
+{
+public:
+
+    // Configuration of a benchmark sweep.
+    struct Config
+    {
+        uint16_t k; // The k-mer length.
+        std::vector<uint16_t> thread_counts;    // Thread counts to sweep over.
+        std::vector<uint64_t> genome_lens;  // Genome lengths to sweep over; the first one is the base size for the weak scaling.
+        double repeat_frac; // Fraction of the genomes made of repeats.
+        uint32_t repeat_len;    // Length of the repeat-units.
+        uint32_t repeat_family_count;   // Number of distinct repeat-units.
+        double repeat_divergence;   // Base-substitution rate of the repeat copies from their units.
+        uint32_t read_len;  // Length of the simulated reads.
+        double coverage;    // Coverage of the simulated reads.
+        double error_rate;  // Base-substitution error rate of the simulated reads.
+        uint32_t cutoff;    // Frequency cutoff for the (k + 1)-mers.
+        std::size_t max_memory; // Soft maximum memory limit (in GB) for the runs.
+        uint64_t seed;  // Seed for the data generation.
+        std::string working_dir_path;   // Directory for the generated data and the run outputs.
+    };
+
+
+private:
+
+    const Config config;    // Configuration of the sweep.
+    std::map<uint64_t, std::string> reads_path; // Paths to the simulated reads, keyed by their genome lengths.
+
+
+    // Returns the path to the reads simulated from a genome of length `genome_len`, generating
+    // those if not done earlier.
+    const std::string& reads_for(uint64_t genome_len);
+
+    // Constructs the compacted graph for the reads simulated from a genome of length
+    // `genome_len` with `thread_count` threads, in a separate process, and returns its
+    // wall-clock time, CPU times, peak RSS, and the per-phase metrics.
+    nlohmann::ordered_json run(uint64_t genome_len, uint16_t thread_count);
+
+
+public:
+
+    // Constructs a benchmark driver with the configuration `config`.
+    Scaling_Bench(const Config& config);
+
+    // Removes the generated data.
+    ~Scaling_Bench();
+
+    // Runs the strong-scaling sweep, i.e. each genome length over all the thread counts, and
+    // the weak-scaling sweep, i.e. the base genome length scaled proportionally to the thread
+    // counts, and returns the results.
+    nlohmann::ordered_json execute();
+};
+
+
+
+#endif
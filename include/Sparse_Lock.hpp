@@ -8,6 +8,11 @@
 #include <cstdint>
 #include <vector>
 #include <cmath>
+#ifdef CF_CONTENTION_STATS
+#include "Contention_Stats.hpp"
+#include <atomic>
+#include <memory>
+#endif
 
 // A collection of locks, of type `T_Lock`.
 // Intended to be used when a set of sparsely distributed locks over some index range is required.
@@ -24,17 +29,27 @@ private:
     const size_t per_lock_range;        // Number of contiguous entries (indices) that each lock is assigned to.
     const size_t num_locks;             // Number of locks in the collection.
     std::vector<T_Lock> lock_;          // The collection of locks.
+#ifdef CF_CONTENTION_STATS
+    std::unique_ptr<std::atomic<uint64_t>[]> spins_;    // Number of spin iterations taken to acquire each lock.
+#endif
 
 
     // Returns the ID of the lock that the index `idx` corresponds to.
     std::size_t lock_id(std::size_t idx) const;
 
+    // Acquires the lock with ID `id`.
+    void acquire(std::size_t id);
+
 
 public:
 
     // Constructs a sparse-lock collection consisting of `lock_count` locks, for `range_size` number of entries.
     Sparse_Lock(size_t range_size, size_t lock_count);
 
+#ifdef CF_CONTENTION_STATS
+    ~Sparse_Lock();
+#endif
+
     // Acquires lock for the entry with index `idx`.
     void lock(size_t idx);
 
@@ -48,6 +63,9 @@ public:
     // Releases lock for the entry with index `curr_idx` iff the corresponding lock for the index `prev_idx`
     // is a different lock.
     void unlock_if_different(std::size_t prev_idx, std::size_t curr_idx);
+
+    // Returns whether the entries with indices `idx_1` and `idx_2` are guarded by the same lock.
+    bool same_lock(std::size_t idx_1, std::size_t idx_2) const;
 };
 
 
@@ -67,7 +85,24 @@ inline Sparse_Lock<T_Lock>::Sparse_Lock(const size_t range_size, const size_t lo
     per_lock_range(static_cast<size_t>(1) << lg_per_lock_range),
     num_locks((num_entries + per_lock_range - 1) / per_lock_range),
     lock_(num_locks)
-{}
+{
+#ifdef CF_CONTENTION_STATS
+    spins_.reset(new std::atomic<uint64_t>[num_locks]);
+    for(std::size_t i = 0; i < num_locks; ++i)
+        spins_[i].store(0, std::memory_order_relaxed);
+
+    Contention_Stats::register_stripes(spins_.get(), num_locks);
+#endif
+}
+
+
+#ifdef CF_CONTENTION_STATS
+template <typename T_Lock>
+inline Sparse_Lock<T_Lock>::~Sparse_Lock()
+{
+    Contention_Stats::deregister_stripes(spins_.get());
+}
+#endif
 
 template <typename T_Lock>
 /**
@@ -93,7 +128,24 @@ template <typename T_Lock>
  */
 inline void Sparse_Lock<T_Lock>::lock(const size_t idx)
 {
-    lock_[lock_id(idx)].lock();
+    acquire(lock_id(idx));
+}
+
+
+template <typename T_Lock>
+inline void Sparse_Lock<T_Lock>::acquire(const std::size_t id)
+{
+#ifdef CF_CONTENTION_STATS
+    uint64_t spins = 0;
+    while(!lock_[id].try_lock())
+        spins++;
+
+    Contention_Stats::count_lock(spins);
+    if(spins > 0)
+        spins_[id].fetch_add(spins, std::memory_order_relaxed);
+#else
+    lock_[id].lock();
+#endif
 }
 
 
@@ -108,7 +160,7 @@ template <typename T_Lock>
 inline void Sparse_Lock<T_Lock>::lock_if_different(const std::size_t prev_idx, const std::size_t curr_idx)
 {
     if(lock_id(curr_idx) != lock_id(prev_idx))
-        lock_[lock_id(curr_idx)].lock();
+        acquire(lock_id(curr_idx));
 }
 
 
@@ -121,4 +173,11 @@ inline void Sparse_Lock<T_Lock>::unlock_if_different(const std::size_t prev_idx,
 
 
 
+template <typename T_Lock>
+inline bool Sparse_Lock<T_Lock>::same_lock(const std::size_t idx_1, const std::size_t idx_2) const
+{
+    return lock_id(idx_1) == lock_id(idx_2);
+}
+
+
 #endif
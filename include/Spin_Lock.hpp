@@ -25,6 +25,9 @@ public:
     // Acquires the lock for mutually-exlcusive access to it.
     void lock();
 
+    // Tries to acquire the lock without spinning; returns `true` iff it is acquired.
+    bool try_lock();
+
     // Releases the lock, giving up the exclusive access to it.
     void unlock();
 };
@@ -48,6 +51,12 @@ inline void Spin_Lock::lock()
 }
 
 
+inline bool Spin_Lock::try_lock()
+{
+    return !lock_.test_and_set(std::memory_order_acquire);
+}
+
+
 /**
  * @brief 解锁Spin_Lock
  *
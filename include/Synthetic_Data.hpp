@@ -0,0 +1,61 @@
+
+#ifndef SYNTHETIC_DATA_HPP
+#define SYNTHETIC_DATA_HPP
+
+
+
+#include <cstdint>
+#include <string>
+#include <random>
+
+
+// A generator of synthetic inputs for benchmarking: random genomes with tunable repeat
+// content, and sequencing reads simulated from those genomes.
+class Synthetic_Data
+{
+private:
+
+    static constexpr std::size_t FASTA_LINE_LEN = 80;   // Number of bases per line in the generated FASTA files.
+    static constexpr char QUAL_CORRECT = 'I';   // Quality score for correctly sequenced bases in the simulated reads.
+    static constexpr char QUAL_ERROR = '#'; // Quality score for erroneous bases in the simulated reads.
+
+    std::mt19937_64 rng;    // The pseudo-random number generator.
+
+
+    // Returns a random base.
+    char random_base();
+
+    // Returns a random base different from `base`.
+    char substitute(char base);
+
+    // Returns a random sequence of length `len`.
+    std::string random_seq(uint64_t len);
+
+    // Substitutes the bases of `seq` at the rate `rate`, and returns the number of substitutions.
+    uint64_t mutate(std::string& seq, double rate);
+
+
+public:
+
+    // Constructs a generator seeded with `seed`; the same seed generates the same data.
+    Synthetic_Data(uint64_t seed);
+
+    // Returns a random genome of `len` bases. A `repeat_frac` fraction of the genome consists of
+    // copies of `repeat_family_count` repeat-units of length `repeat_len` each, placed at random
+    // positions; each copy is diverged from its unit by base-substitutions at the rate
+    // `repeat_divergence`. The rest of the genome is uniformly random.
+    std::string genome(uint64_t len, double repeat_frac, uint32_t repeat_len, uint32_t repeat_family_count, double repeat_divergence);
+
+    // Writes `genome` as a single FASTA record with the name `name` into the file at `file_path`.
+    static void write_FASTA(const std::string& genome, const std::string& name, const std::string& file_path);
+
+    // Simulates reads of length `read_len` from uniformly random positions and strands of
+    // `genome`, up-to the coverage `coverage`, with base-substitution errors at the rate
+    // `error_rate`, and writes them into the FASTQ file at `file_path`. Returns the number of
+    // simulated reads.
+    uint64_t write_reads(const std::string& genome, uint32_t read_len, double coverage, double error_rate, const std::string& file_path);
+};
+
+
+
+#endif
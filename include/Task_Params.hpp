@@ -48,6 +48,7 @@ struct Read_dBG_Compaction_Params
 {
     void* parser;
     uint16_t thread_id;
+    uint8_t pass;   // Index of the pass of the task, for the tasks with multiple passes.
 
 
     Read_dBG_Compaction_Params() {}
@@ -60,9 +61,10 @@ struct Read_dBG_Compaction_Params
      * @param parser 解析器指针
      * @param thread_id 线程ID
      */
-    Read_dBG_Compaction_Params(void* const parser, const uint16_t thread_id):
+    Read_dBG_Compaction_Params(void* const parser, const uint16_t thread_id, const uint8_t pass = 0):
         parser(parser),
-        thread_id(thread_id)
+        thread_id(thread_id),
+        pass(pass)
     {}
 };
 
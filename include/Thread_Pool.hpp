@@ -74,6 +74,9 @@ private:
     // more tasks will be provided.
     void task(uint16_t thread_id);
 
+    // Returns the name of the type of task that this thread pool executes.
+    const char* task_name() const;
+
 
 public:
   // Constructs a thread pool with `thread_count` number of threads to operate
@@ -101,8 +104,9 @@ public:
   // Assigns a read-dBG compaction task, either DFA-states computation or
   // maximal unitigs extraction, to the thread number `thread_id`; the edges
   // (i.e. (k + 1)-mers) or vertices (i.e. k-mers), respectively, are parsed
-  // using `parser`.
-  void assign_read_dBG_compaction_task(void *parser, uint16_t thread_id);
+  // using `parser`. `pass` is the index of the pass of the task, for the
+  // maximal unitigs extraction.
+  void assign_read_dBG_compaction_task(void *parser, uint16_t thread_id, uint8_t pass = 0);
 
   // Waits until all the threads in the pool have completed their active tasks.
   void wait_completion() const;
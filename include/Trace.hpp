@@ -0,0 +1,121 @@
+
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <list>
+
+
+class Spin_Lock;
+
+
+// A recorder of a timeline of spans executed by the threads, e.g. tasks, buffer fills and
+// waits, output flushes, and phases, to be written in the Chrome / Perfetto trace-event JSON
+// format. Each thread records into its own fixed-size ring buffer without any locks, retaining
+// its latest spans; the recording is a no-op unless enabled.
+class Trace
+{
+private:
+
+    static constexpr std::size_t RING_CAPACITY = (1 << 15);    // Number of spans retained per thread.
+
+    // A recorded span.
+    struct Span
+    {
+        const char* name;   // Name of the span; must outlive the trace.
+        uint64_t begin; // Begin time, in nanoseconds on the steady clock.
+        uint64_t end;   // End time, in nanoseconds on the steady clock.
+    };
+
+    // Ring buffer of the spans of a thread. Written only by its owner thread; rings of the
+    // exited threads are reused by the new ones.
+    struct Ring
+    {
+        uint32_t id;    // ID of the ring, i.e. the track of its threads in the timeline.
+        std::unique_ptr<Span[]> span;   // The spans.
+        std::atomic<uint64_t> head{0};  // Number of spans recorded into the ring so far.
+    };
+
+    // Holder of the ring of a thread, releasing it for reuse at the thread's exit.
+    struct Ring_Holder
+    {
+        Ring* ring = nullptr;
+
+        ~Ring_Holder();
+    };
+
+    static std::atomic<bool> enabled_;  // Whether the recording is enabled.
+    static thread_local Ring_Holder ring_holder;    // Ring of the executing thread.
+
+    // The rings of all the threads, the rings released by the exited threads, the interned
+    // names, and the lock guarding those; these are touched only once per thread, not per span.
+    static std::vector<std::unique_ptr<Ring>> all_rings;
+    static std::vector<Ring*> free_rings;
+    static std::list<std::string> interned_names;
+    static Spin_Lock registry_lock;
+
+
+    // Returns the ring of the executing thread, acquiring one if it does not have one yet.
+    static Ring& ring();
+
+
+public:
+
+    // Enables the recording of the spans.
+    static void enable();
+
+    // Returns whether the recording is enabled.
+    static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    // Returns the current time, in nanoseconds on the steady clock.
+    static uint64_t now();
+
+    // Records a span named `name` by the executing thread, from time `begin` to `end`. `name`
+    // must outlive the trace.
+    static void record(const char* name, uint64_t begin, uint64_t end);
+
+    // Returns a copy of the name `name` that lives for the trace's lifetime.
+    static const char* intern(const std::string& name);
+
+    // Writes the recorded spans in the trace-event JSON format into the file at `file_path`.
+    // The recording threads should have finished by then.
+    static void dump(const std::string& file_path);
+};
+
+
+// A span of the executing thread, recorded from the construction of the object till its
+// destruction.
+class Trace_Span
+{
+private:
+
+    const char* const name; // Name of the span.
+    const uint64_t begin;   // Begin time of the span; `0` if the recording is disabled.
+
+
+public:
+
+    // Begins a span named `name`, which must outlive the trace.
+    Trace_Span(const char* name):
+        name(name),
+        begin(Trace::enabled() ? Trace::now() : 0)
+    {}
+
+    // Ends the span.
+    ~Trace_Span()
+    {
+        if(begin > 0)
+            Trace::record(name, begin, Trace::now());
+    }
+};
+
+
+
+#endif
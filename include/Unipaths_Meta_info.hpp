@@ -39,6 +39,10 @@ public:
     // Adds information of a maximal unitig with vertex count `size` to the tracker.
     void add_maximal_unitig(std::size_t size);
 
+    // Adds information of a DCC with vertex count `size` to the tracker. Note that
+    // the DCC itself needs to be added as a maximal unitig separately.
+    void add_DCC(std::size_t size);
+
     // Aggregates the information of the tracker `other` to this tracker.
     void aggregate(const Unipaths_Meta_info<k>& other);
 
@@ -120,11 +124,16 @@ inline void Unipaths_Meta_info<k>::add_maximal_unitig(const Maximal_Unitig_Scrat
     add_maximal_unitig(maximal_unitig.size());
 
     if(maximal_unitig.is_cycle())
-    {
-        dcc_count_++;
-        dcc_kmer_count_ += maximal_unitig.size();
-        dcc_sum_len_ += maximal_unitig.size() + (k - 1);
-    }
+        add_DCC(maximal_unitig.size());
+}
+
+
+template <uint16_t k>
+inline void Unipaths_Meta_info<k>::add_DCC(const std::size_t size)
+{
+    dcc_count_++;
+    dcc_kmer_count_ += size;
+    dcc_sum_len_ += size + (k - 1);
 }
 
 
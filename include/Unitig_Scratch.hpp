@@ -37,6 +37,7 @@ private:
     // unitigs连续顶点的hash值
     std::vector<uint64_t> hash_;    // Hashes of the constituent vertices of the unitig.
     bool is_cycle_;                 // Whether the unitig is cyclical or not.
+    std::size_t spilled_;           // Number of vertices of the unitig spilled out of the scratch.
 
 
     // Clears the scratch data.
@@ -58,10 +59,17 @@ public:
     // Reverse complements the unitig.
     void reverse_complement();
 
-    // Returns the literal label of the unitig.
+    // Spills the label and the hashes retained so far out of the scratch, i.e. clears them while
+    // keeping the traversal going. Their streaming is to be handled by the client code.
+    void spill();
+
+    // Returns whether some part of the unitig has been spilled out of the scratch.
+    bool is_spilled() const;
+
+    // Returns the literal label of the unitig, excluding its spilled part.
     const std::vector<char>& label() const;
 
-    // Returns the hash collection of the unitig vertices.
+    // Returns the hash collection of the unitig vertices, excluding the spilled ones.
     const std::vector<uint64_t>& hash() const;
 
     // Returns the current extension-end vertex of the unitig.
@@ -115,6 +123,7 @@ inline void Unitig_Scratch<k>::init(const Directed_Vertex<k>& v)
     hash_.emplace_back(endpoint_.hash());
     //循环标志位设置为false
     is_cycle_ = false;
+    spilled_ = 0;
 }
 
 
@@ -168,6 +177,21 @@ inline void Unitig_Scratch<k>::reverse_complement()
 }
 
 
+template <uint16_t k>
+inline void Unitig_Scratch<k>::spill()
+{
+    spilled_ += hash_.size();
+    clear();
+}
+
+
+template <uint16_t k>
+inline bool Unitig_Scratch<k>::is_spilled() const
+{
+    return spilled_ > 0;
+}
+
+
 template <uint16_t k>
 inline const std::vector<char>& Unitig_Scratch<k>::label() const
 {
@@ -199,7 +223,7 @@ inline const Directed_Vertex<k>& Unitig_Scratch<k>::endpoint() const
 template <uint16_t k>
 inline std::size_t Unitig_Scratch<k>::size() const
 {
-    return hash_.size();
+    return spilled_ + hash_.size();
 }
 
 
@@ -0,0 +1,43 @@
+
+#ifndef UNITIG_SINK_HPP
+#define UNITIG_SINK_HPP
+
+
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <functional>
+
+
+// A read-only view of the label of a maximal unitig, in its canonical form, handed to a unitig
+// sink. The label is not copied out of the scratch space it is built in, where it may lie in two
+// pieces: it is `seg[0]` followed by `seg[1]`. The view is valid only during the sink call.
+struct Unitig_View
+{
+    uint64_t id;    // The unique ID of the maximal unitig.
+    const char* seg[2]; // The two pieces of the label.
+    std::size_t seg_len[2]; // The lengths of the two pieces of the label.
+    bool is_cycle;  // Whether the maximal unitig is a detached chordless cycle.
+
+
+    // Returns the length of the label.
+    std::size_t size() const { return seg_len[0] + seg_len[1]; }
+
+    // Copies the label into `label`.
+    void copy_to(std::string& label) const
+    {
+        label.assign(seg[0], seg_len[0]);
+        label.append(seg[1], seg_len[1]);
+    }
+};
+
+
+// A sink for the maximal unitigs, in place of the output file. It is called concurrently from the
+// worker threads of the extraction, with the view of each maximal unitig and the ID of the calling
+// thread, and thus needs to be thread-safe.
+typedef std::function<void(const Unitig_View& unitig, uint16_t thread_id)> Unitig_Sink;
+
+
+
+#endif
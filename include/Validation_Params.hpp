@@ -106,10 +106,16 @@ public:
 inline bool Validation_Params::is_valid() const
 {
     // Even `k` values are not consistent with the theory.
-    // Also, `k` needs to be in the range `[1, MAX_K]`.
-    if((k_ & 1) == 0 || (k_ > cuttlefish::MAX_K))
+    // Also, `k` needs to be in the range `[1, MAX_K]`, and to be instantiated for.
+    if(!cuttlefish::k_supported(k_))
     {
         std::cout << "The k-mer length (k) needs to be odd and within " << cuttlefish::MAX_K << ".\n";
+#ifdef CF_K_SEQ
+        std::cout << "This build supports only the k-values:";
+        for(const uint16_t k_val: cuttlefish::K_VALUES)
+            std::cout << " " << k_val;
+        std::cout << ".\n";
+#endif
         return false;
     }
 
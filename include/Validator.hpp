@@ -5,6 +5,7 @@
 
 
 #include "globals.hpp"
+#include "Kmer.hpp"
 #include "Kmer_Hasher.hpp"
 #include "Validation_Params.hpp"
 #include "BBHash/BooPHF.h"
@@ -19,7 +20,7 @@
 template <uint16_t k>
 class Validator
 {
-    typedef boomphf::mphf<Kmer<k>, Kmer_Hasher<k>> mphf_t;    // The MPH function type.
+    typedef boomphf::mphf<typename Kmer<k>::width_t, Kmer_Hasher<Kmer<k>::width_t::word_count>> mphf_t;    // The MPH function type.
 
 private:
 
@@ -27,6 +28,10 @@ private:
     mphf_t* mph = NULL; // Minimal perfect hash function over the set of canonical k-mers of the reference.
 
     constexpr static size_t PROGRESS_GRAIN_SIZE = 1000000;  // 1M
+
+    // Magic number starting the saved MPHF files, followed by the k-mer hash scheme and the k-mer
+    // length that the MPHF has been built with.
+    constexpr static uint64_t mph_file_magic = 0x4850'4D5F'5641'0001ULL;
     
     // The gamma factor for the BBHash algorithm. Lowest bits/elem is achieved with gamma = 1,
     // higher values lead to larger mphf but faster construction/query.
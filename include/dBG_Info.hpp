@@ -13,9 +13,11 @@
 // Forward declarations.
 template <uint16_t k> class Read_CdBG_Constructor;
 template <uint16_t k> class Read_CdBG_Extractor;
+template <uint16_t k> class Partitioned_CdBG;
 template <uint16_t k> class CdBG;
 template <uint16_t k> class Unipaths_Meta_info;
 class Build_Params;
+class Phase_Metrics;
 
 
 // A class to wrap the structural information of a de Bruijn graph and some execution
@@ -34,6 +36,8 @@ private:
     static constexpr const char* short_seqs_field = "short seqs";   // Category header for information about sequences shorter than length `k`.
     static constexpr const char* dcc_field = "detached chordless cycles (DCC) info";  // Category header for information about the DCCs.
     static constexpr const char* params_field = "parameters info"; // Category header for the graph build parameters.
+    static constexpr const char* partitions_field = "partitions info";  // Category header for the partitions of the graph in the out-of-core construction.
+    static constexpr const char* phases_field = "phase metrics";    // Category header for the execution metrics of the construction phases.
 
 
     // Loads the JSON file from disk, if the corresponding file exists.
@@ -61,15 +65,25 @@ public:
     // Adds basic graph structural information from `cdbg`.
     void add_basic_info(const CdBG<k>& cdbg);
 
+    // Adds basic graph structural information, and information about the partitions of the
+    // graph, from `cdbg`.
+    void add_basic_info(const Partitioned_CdBG<k>& cdbg);
+
     // Adds information about the extracted maximal unitigs from `cdbg_extractor`.
     void add_unipaths_info(const Read_CdBG_Extractor<k>& cdbg_extractor);
 
     // Adds information about the extracted maximal unitigs from `cdbg`.
     void add_unipaths_info(const CdBG<k>& cdbg);
 
+    // Adds information about the extracted maximal unitigs from `cdbg`.
+    void add_unipaths_info(const Partitioned_CdBG<k>& cdbg);
+
     // Adds information about the references shorter than length k.
     void add_short_seqs_info(const std::vector<std::pair<std::string, std::size_t>>& short_seqs);
 
+    // Adds the execution metrics `metrics` of the construction phase named `phase`.
+    void add_phase_metrics(const std::string& phase, const Phase_Metrics& metrics);
+
     // Writes the JSON object to its corresponding disk-file.
     void dump_info() const;
 };
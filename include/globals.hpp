@@ -5,6 +5,9 @@
 
 
 #include "boost/preprocessor/repetition/repeat.hpp"
+#include "boost/preprocessor/seq/for_each.hpp"
+#include "boost/preprocessor/seq/enum.hpp"
+#include "boost/preprocessor/tuple/elem.hpp"
 
 #include <cstdint>
 
@@ -16,6 +19,14 @@
     #define INSTANCE_COUNT 32
 #endif
 
+// Alternatively, the k-values to instantiate the algorithm for can be restricted to some odd values
+// `k_1, k_2, ..., k_n` with the macro `CF_K_SEQ` set to the sequence `(k_1)(k_2)...(k_n)`; e.g. for
+// builds supporting a few long k-values, up to 255, where instantiating all the odd values up to the
+// maximum blows up the build time and the binary size. `INSTANCE_COUNT` is ignored then.
+// Note that the k-mer kernels, the hashers, and the MPHFs are specialized per width class of the k-mers
+// (see `Kmer_W`), with k at runtime; but the rest of the algorithm is instantiated per k-value. So such a
+// build serves only the listed k-values, not every k within the width classes of those.
+
 
 // Forward declarations of the DNA code types.
 namespace DNA
@@ -28,7 +39,40 @@ namespace DNA
 
 namespace cuttlefish
 {
+#ifdef CF_K_SEQ
+    constexpr uint16_t K_VALUES[] = { BOOST_PP_SEQ_ENUM(CF_K_SEQ) };   // The instantiated k-values.
+
+    // Returns the maximum instantiated k-value.
+    constexpr uint16_t max_k()
+    {
+        uint16_t max = 0;
+        for(const uint16_t k: K_VALUES)
+            max = (k > max ? k : max);
+
+        return max;
+    }
+
+    constexpr uint16_t MAX_K = max_k();
+#else
     constexpr uint16_t MAX_K = (2 * INSTANCE_COUNT - 1);
+#endif
+
+    // Returns whether the algorithm is instantiated for the k-value `k`.
+    constexpr bool k_supported(const uint16_t k)
+    {
+        if((k & 1) == 0 || k > MAX_K)
+            return false;
+
+#ifdef CF_K_SEQ
+        for(const uint16_t k_val: K_VALUES)
+            if(k_val == k)
+                return true;
+
+        return false;
+#else
+        return true;
+#endif
+    }
 
 
     typedef bool dir_t;
@@ -71,7 +115,14 @@ namespace cuttlefish
 
 // Enumerates all the explicit instantiations of the template class `class_name` using `instantiator`, for all
 // `x` in `[0, count)`. The `x`-value is used as appropriate by `instantiator`.
-#define ENUMERATE(count, instantiator, class_name) BOOST_PP_REPEAT(count, instantiator, class_name)
+// If the k-values are restricted with `CF_K_SEQ`, `count` is ignored and the `x`-values are `(k - 1) / 2`
+// for the k-values `k` in the sequence.
+#ifdef CF_K_SEQ
+    #define INSTANTIATE_SEQ_ELEM(r, data, k) BOOST_PP_TUPLE_ELEM(2, 0, data)(r, ((k - 1) / 2), BOOST_PP_TUPLE_ELEM(2, 1, data))
+    #define ENUMERATE(count, instantiator, class_name) BOOST_PP_SEQ_FOR_EACH(INSTANTIATE_SEQ_ELEM, (instantiator, class_name), CF_K_SEQ)
+#else
+    #define ENUMERATE(count, instantiator, class_name) BOOST_PP_REPEAT(count, instantiator, class_name)
+#endif
 
 // Given some `x`, explicitly instantiates two instances of the class `class_name`, with the template parameters
 // `k` = `2x + 1`, and `BITS_PER_KEY` with `BITS_PER_REF_KMER` and `BITS_PER_READ_KMER` for alternate instances;
@@ -5,6 +5,7 @@
 
 
 #include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -26,6 +27,10 @@ bool file_exists(const std::string& file_path);
 // path `dir_path`.
 bool dir_exists(const std::string& dir_path);
 
+// Creates the directory at path `dir_path`, with its missing parents. Returns
+// `true` iff the directory exists afterwards.
+bool create_dir(const std::string& dir_path);
+
 // Returns the file size is bytes of the file at path `file_path`. Returns
 // `0` in case the file does not exist.
 std::size_t file_size(const std::string& file_path);
@@ -61,6 +66,15 @@ void move_file(const std::string& from_path, const std::string& to_path);
 // process in bytes. Returns `0` in case of errors encountered.
 std::size_t process_peak_memory();
 
+// Returns the memory currently resident ("RSS") for the running process in
+// bytes. Returns `0` in case of errors encountered.
+std::size_t process_curr_memory();
+
+// Sets `bytes_read` and `bytes_written` to the amounts of bytes read and written
+// by the running process till now, through any read- and write-like system
+// calls. Sets those to `0` in case of errors encountered.
+void process_io_bytes(uint64_t& bytes_read, uint64_t& bytes_written);
+
 
 
 #endif
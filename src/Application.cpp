@@ -1,109 +1,100 @@
-
 #include "Application.hpp"
 #include "globals.hpp"
 #include "CdBG.hpp"
 #include "Read_CdBG.hpp"
+#include "Build_Params.hpp"
+#include "Validation_Params.hpp"
 
-
-template <uint16_t k, template <uint16_t> typename T_App>
-Application<k, T_App>::Application(const Build_Params& params):
-    app_next_level(new Application<k - 2, T_App>(params)),
-    app(params.k() == k ? new T_App<k>(params) : nullptr),
-    validator(nullptr)
-{}
+#include <iostream>
+#include <cstdlib>
 
 
-template <uint16_t k, template <uint16_t> typename T_App>
-Application<k, T_App>::Application(const Validation_Params& params):
-    app_next_level(new Application<k - 2, T_App>(params)),
-    app(nullptr),
-    validator(params.k() == k ? new Validator<k>(params): nullptr)
-{}
+template <template<uint16_t> typename T_App>
+template <uint16_t k>
+class Application<T_App>::Instance_k: public Application<T_App>::Instance
+{
+private:
 
+    const std::unique_ptr<T_App<k>> app;    // Driver object that operates with the k-value `k`.
+    const std::unique_ptr<Validator<k>> validator;  // `Validator` object that operates with the k-value `k`.
 
-template <uint16_t k, template <uint16_t> typename T_App>
-Application<k, T_App>::~Application()
-{
-    delete app_next_level;
 
-    if(app != nullptr)
-        delete app;
+public:
 
-    if(validator != nullptr)
-        delete validator;
-}
+    Instance_k(const Build_Params& params):
+        app(new T_App<k>(params))
+    {}
 
+    Instance_k(const Validation_Params& params):
+        validator(new Validator<k>(params))
+    {}
 
-template <uint16_t k, template <uint16_t> typename T_App>
-void Application<k, T_App>::execute() const
-{
-    if(app != nullptr)
+    void execute() override
+    {
         app->construct();
-    else
-        app_next_level->execute();
-}
+    }
+
+    bool validate() override
+    {
+        return validator->validate();
+    }
+};
 
 
-template <uint16_t k, template <uint16_t> typename T_App>
-bool Application<k, T_App>::validate() const
+// Case of the dispatch for the k-value `2x + 1`.
+#define DISPATCH_CASE(z, x, T_Params_) case 2 * x + 1: return new Instance_k<2 * x + 1>(params);
+
+template <template<uint16_t> typename T_App>
+template <typename T_Params_>
+typename Application<T_App>::Instance* Application<T_App>::instantiate(const T_Params_& params)
 {
-    if(validator != nullptr)
-        return validator->validate();
+    // A flat dispatch over the instantiated k-values, rather than a recursive hierarchy of
+    // instances, one per k-value.
+    switch(params.k())
+    {
+    ENUMERATE(INSTANCE_COUNT, DISPATCH_CASE, T_Params_)
 
-    return app_next_level->validate();
+    default:
+        std::cerr << "The provided k is not valid. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
 }
 
+#undef DISPATCH_CASE
+
 
 template <template<uint16_t> typename T_App>
-Application<1, T_App>::Application(const Build_Params& params):
-    app(params.k() == 1 ? new T_App<1>(params) : nullptr),
-    validator(nullptr)
+Application<T_App>::Application(const Build_Params& params):
+    instance(instantiate(params))
 {}
 
 
 template <template<uint16_t> typename T_App>
-Application<1, T_App>::Application(const Validation_Params& params):
-    app(nullptr),
-    validator(params.k() == 1 ? new Validator<1>(params) : nullptr)
+Application<T_App>::Application(const Validation_Params& params):
+    instance(instantiate(params))
 {}
 
 
 template <template<uint16_t> typename T_App>
-Application<1, T_App>::~Application()
-{
-    if(app != nullptr)
-        delete app;
-
-    if(validator != nullptr)
-        delete validator;
-}
+Application<T_App>::~Application()
+{}
 
 
 template <template<uint16_t> typename T_App>
-void Application<1, T_App>::execute() const
+void Application<T_App>::execute() const
 {
-    if(app != nullptr)
-        app->construct();
-    else
-    {
-        std::cerr << "The provided k is not valid. Aborting.\n";
-        std::exit(EXIT_FAILURE);
-    }
+    instance->execute();
 }
 
 
 template <template<uint16_t> typename T_App>
-bool Application<1, T_App>::validate() const
+bool Application<T_App>::validate() const
 {
-    if(validator != nullptr)
-        return validator->validate();
-
-    std::cerr << "The provided k is not valid. Aborting.\n";
-    std::exit(EXIT_FAILURE);
+    return instance->validate();
 }
 
 
 
 // Template instantiations for the required instances.
-template class Application<cuttlefish::MAX_K, CdBG>;
-template class Application<cuttlefish::MAX_K, Read_CdBG>;
+template class Application<CdBG>;
+template class Application<Read_CdBG>;
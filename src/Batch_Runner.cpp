@@ -0,0 +1,222 @@
+
+#include "Batch_Runner.hpp"
+#include "Build_Params.hpp"
+#include "Seq_Input.hpp"
+#include "Read_CdBG.hpp"
+#include "Application.hpp"
+#include "Memory_Budget.hpp"
+#include "Kmer_DB_Cache.hpp"
+#include "Input_Defaults.hpp"
+#include "File_Extensions.hpp"
+#include "Phase_Metrics.hpp"
+#include "utility.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <thread>
+#include <set>
+#include <memory>
+
+
+Batch_Runner::Batch_Runner(const Config& config):
+    config(config),
+    next_job(0),
+    started_jobs(0),
+    free_threads(config.thread_count)
+{}
+
+
+void Batch_Runner::read_manifest()
+{
+    std::ifstream input(config.manifest_path);
+    if(input.fail())
+    {
+        std::cerr << "Error opening the batch manifest " << config.manifest_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    // Each line of the manifest is a job, of the form:
+    // `<read | ref> <k> <output prefix> <input>[,<input>...] [<cutoff>]`,
+    // where an input is a sequence file or a directory of those. Empty lines and the lines
+    // starting with `#` are skipped.
+    std::string line;
+    uint64_t line_num = 0;
+    std::set<std::string> output_names;
+    while(std::getline(input, line))
+    {
+        line_num++;
+        if(line.empty() || line.front() == '#' || line.find_first_not_of(" \t\r") == std::string::npos)
+            continue;
+
+        std::istringstream fields(line);
+        std::string type, inputs;
+        Job job;
+        uint32_t cutoff;
+        if(!(fields >> type >> job.k >> job.output_file_path >> inputs) || (type != "read" && type != "ref"))
+        {
+            std::cerr << "Malformed job at line " << line_num << " of the batch manifest. Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        job.is_read_graph = (type == "read");
+        if(fields >> cutoff)
+            job.cutoff = cutoff;
+
+        std::istringstream input_paths(inputs);
+        std::string path;
+        while(std::getline(input_paths, path, ','))
+            if(!path.empty())
+                (dir_exists(path) ? job.dirs : job.seqs).push_back(path);
+
+        // The temporary files of the jobs are named after their outputs, in the shared working directory.
+        if(!output_names.insert(filename(job.output_file_path)).second)
+        {
+            std::cerr << "Multiple jobs in the batch manifest have the output name " << filename(job.output_file_path) << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        job.input_size = 0;
+        for(const std::string& seq: Seq_Input(job.seqs, std::vector<std::string>(), job.dirs).seqs())
+            job.input_size += file_size(seq);
+
+        jobs.push_back(job);
+    }
+
+    input.close();
+
+
+    // The large jobs are run alone, with all the threads; the small ones share the threads evenly
+    // among at most `job_count` concurrent jobs. The jobs are scheduled from the largest to the
+    // smallest, so that the long jobs do not trail the batch.
+    const uint16_t small_job_threads = std::max(config.thread_count / std::max<uint16_t>(config.job_count, 1), 1);
+    for(Job& job: jobs)
+        job.thread_count = (job.input_size >= config.large_input ? config.thread_count : small_job_threads);
+
+    std::stable_sort(jobs.begin(), jobs.end(), [](const Job& lhs, const Job& rhs){ return lhs.input_size > rhs.input_size; });
+}
+
+
+std::string Batch_Runner::working_dir_path(const Job& job) const
+{
+    const std::string& work_dir = config.working_dir_path;
+    return (work_dir.empty() || work_dir.back() == '/' ? work_dir : work_dir + "/") + filename(job.output_file_path) + cuttlefish::file_ext::job_dir_ext;
+}
+
+
+Build_Params Batch_Runner::params(const Job& job, const uint16_t thread_count) const
+{
+    return Build_Params(job.is_read_graph, !job.is_read_graph,
+                        job.seqs, std::nullopt, job.dirs,
+                        job.k, job.cutoff, cuttlefish::_default::EMPTY, cuttlefish::_default::EMPTY,
+                        thread_count, config.max_memory, config.strict_memory,
+                        job.output_file_path, std::nullopt, false, false, working_dir_path(job),
+                        false, false, false, false, false,
+                        false, false, false
+#ifdef CF_DEVELOP_MODE
+                        , cuttlefish::_default::GAMMA
+#endif
+                    );
+}
+
+
+void Batch_Runner::run(const Job& job)
+{
+    // The BBHash level files, among others, are kept apart from the ones of the concurrent jobs only
+    // through the working subdirectory of the job, created at the validation of the batch.
+    const std::string work_dir = working_dir_path(job);
+    const Build_Params job_params = params(job, job.thread_count);
+    if(file_exists(job_params.json_file_path()))
+    {
+        std::cout << "The graph at " << job.output_file_path << " has been constructed earlier. Skipping it.\n";
+        remove_file(work_dir);
+        return;
+    }
+
+    const auto t_start = std::chrono::high_resolution_clock::now();
+
+    Application<Read_CdBG>(job_params).execute();
+
+    remove_file(work_dir);  // Only if the job has left no temporary files behind.
+
+    const auto t_end = std::chrono::high_resolution_clock::now();
+    const double elapsed_seconds = std::chrono::duration_cast<std::chrono::duration<double>>(t_end - t_start).count();
+
+    std::cout << "Constructed the graph at " << job.output_file_path << " with " << job.thread_count << " thread(s) in " << elapsed_seconds << " seconds.\n";
+}
+
+
+void Batch_Runner::work()
+{
+    std::unique_lock<std::mutex> guard(lock);
+    while(next_job < jobs.size())
+    {
+        const std::size_t job_idx = next_job++;
+        const Job& job = jobs[job_idx];
+
+        // The jobs start in order, so that a large job waiting for all the threads is not overtaken
+        // by the smaller ones after it.
+        schedule_changed.wait(guard, [this, job_idx, &job](){ return started_jobs == job_idx && free_threads >= job.thread_count; });
+        started_jobs++;
+        free_threads -= job.thread_count;
+        guard.unlock();
+        schedule_changed.notify_all();
+
+        run(job);
+
+        guard.lock();
+        free_threads += job.thread_count;
+        schedule_changed.notify_all();
+    }
+}
+
+
+void Batch_Runner::execute()
+{
+    read_manifest();
+    if(jobs.empty())
+    {
+        std::cout << "No jobs found in the batch manifest " << config.manifest_path << ".\n";
+        return;
+    }
+
+    // The working subdirectories of the jobs are created in the working directory of the batch.
+    if(!dir_exists(config.working_dir_path))
+    {
+        std::cerr << "Working directory " << config.working_dir_path << " does not exist. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    for(const Job& job: jobs)
+        if(!create_dir(working_dir_path(job)) || !params(job, job.thread_count).is_valid())
+        {
+            std::cerr << "Invalid configuration for the job with output " << job.output_file_path << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+    std::cout << "Running " << jobs.size() << " job(s) with " << config.thread_count << " threads.\n";
+
+    // The jobs share the process, and so its memory budget: it is set up once, for all the
+    // threads. The k-mer database cache and the process-wide resource measurements of the phases
+    // would mix the concurrent jobs together, and so are not used with those.
+    Memory_Budget::setup(params(jobs.front(), config.thread_count));
+    Memory_Budget::hold();
+    if(config.job_count > 1)
+    {
+        Kmer_DB_Cache::disable();
+        Phase_Metrics::share_process();
+    }
+
+
+    const uint16_t worker_count = std::max<uint16_t>(config.job_count, 1);
+    std::vector<std::unique_ptr<std::thread>> T(worker_count);
+    for(uint16_t worker_id = 0; worker_id < worker_count; ++worker_id)
+        T[worker_id].reset(new std::thread(&Batch_Runner::work, this));
+
+    for(uint16_t worker_id = 0; worker_id < worker_count; ++worker_id)
+        T[worker_id]->join();
+
+    std::cout << "Completed the batch of " << jobs.size() << " job(s).\n";
+}
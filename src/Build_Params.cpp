@@ -23,6 +23,10 @@ Build_Params::Build_Params( const bool is_read_graph,
                             const bool poly_n_stretch,
                             const std::string& working_dir_path,
                             const bool path_cover,
+                            const bool partitioned,
+                            const bool minimizer_layout,
+                            const bool owner_computes,
+                            const bool coalesce_edges,
                             const bool save_mph,
                             const bool save_buckets,
                             const bool save_vertices
@@ -46,6 +50,10 @@ Build_Params::Build_Params( const bool is_read_graph,
         poly_n_stretch_(poly_n_stretch),
         working_dir_path_(working_dir_path.back() == '/' ? working_dir_path : working_dir_path + "/"),
         path_cover_(path_cover),
+        partitioned_(partitioned),
+        minimizer_layout_(minimizer_layout),
+        owner_computes_(owner_computes),
+        coalesce_edges_(coalesce_edges),
         save_mph_(save_mph),
         save_buckets_(save_buckets),
         save_vertices_(save_vertices)
@@ -76,10 +84,16 @@ bool Build_Params::is_valid() const
 
     
     // Even `k` values are not consistent with the theory.
-    // Also, `k` needs to be in the range `[1, MAX_K]`.
-    if((k_ & static_cast<uint16_t>(1)) == 0 || (k_ > cuttlefish::MAX_K))
+    // Also, `k` needs to be in the range `[1, MAX_K]`, and to be instantiated for.
+    if(!cuttlefish::k_supported(k_))
     {
         std::cout << "The k-mer length (k) needs to be odd and within " << cuttlefish::MAX_K << ".\n";
+#ifdef CF_K_SEQ
+        std::cout << "This build supports only the k-values:";
+        for(const uint16_t k_val: cuttlefish::K_VALUES)
+            std::cout << " " << k_val;
+        std::cout << ".\n";
+#endif
         valid = false;
     }
 
@@ -139,6 +153,38 @@ bool Build_Params::is_valid() const
             std::cout << "WARNING: cutoff frequency specified not to be 1 on reference sequences.\n";
 
         
+        // The out-of-core construction extracts maximal unitigs only.
+        if(partitioned_ && path_cover_)
+        {
+            std::cout << "Path cover extraction is not supported with the partitioned construction.\n";
+            valid = false;
+        }
+
+        // The out-of-core construction is always bounded by the (soft) memory limit.
+        if(partitioned_ && !strict_memory_)
+            std::cout << "The partitioned construction is bounded by the memory limit; the option for unrestricted memory usage is ignored for it.\n";
+
+        // The partitions are minimizer-grouped already.
+        if(partitioned_ && minimizer_layout_)
+            std::cout << "The partitions of the partitioned construction are grouped by minimizers already; the minimizer layout option is ignored for it.\n";
+
+        // The path cover edges need to be added to both their endpoints in a tied manner.
+        if(path_cover_ && owner_computes_)
+            std::cout << "The owner-computes states computation is not supported with path cover extraction; the option is ignored for it.\n";
+
+        // The path cover edges are added in a tied manner, one at a time.
+        if(path_cover_ && coalesce_edges_)
+            std::cout << "Coalescing the edges is not supported with path cover extraction; the option is ignored for it.\n";
+
+        // The owner-computes scheme applies the updates of the edges by their owner threads, not by
+        // runs of the edge parser.
+        if(owner_computes_ && coalesce_edges_ && !path_cover_)
+        {
+            std::cout << "The owner-computes states computation and coalescing the edges are mutually exclusive. Please select only one.\n";
+            valid = false;
+        }
+
+
         // Cuttlefish 1 specific arguments can not be specified.
         if(output_format_)
         {
@@ -157,7 +203,7 @@ bool Build_Params::is_valid() const
 
 
         // Cuttlefish 2 specific arguments can not be specified.
-        if(cutoff_ || path_cover_)
+        if(cutoff_ || path_cover_ || partitioned_ || minimizer_layout_ || owner_computes_ || coalesce_edges_)
         {
             std::cout << "Cuttelfish 2 specific arguments specified while using Cuttlefish 1.\n";
             valid = false;
@@ -4,6 +4,8 @@
 #include "kmer_Enumerator.hpp"
 #include "Kmer_Container.hpp"
 #include "kmer_Enumeration_Stats.hpp"
+#include "Phase_Metrics.hpp"
+#include "Memory_Budget.hpp"
 
 
 template <uint16_t k> 
@@ -12,7 +14,9 @@ CdBG<k>::CdBG(const Build_Params& params):
     logistics(this->params),
     hash_table(nullptr),
     dbg_info(params.json_file_path())
-{}
+{
+    Memory_Budget::setup(params);
+}
 
 
 template <uint16_t k>
@@ -36,22 +40,21 @@ void CdBG<k>::construct()
 
     dbg_info.add_build_params(params);
 
-    std::chrono::high_resolution_clock::time_point t_start = std::chrono::high_resolution_clock::now();
-
-
     std::cout << "\nEnumerating the vertices of the de Bruijn graph.\n";
+    Phase_Metrics vertex_metrics;
     kmer_Enumeration_Stats<k> vertex_stats = enumerate_vertices();
     vertex_stats.log_stats();
 
-    std::chrono::high_resolution_clock::time_point t_vertex = std::chrono::high_resolution_clock::now();
-    std::cout << "Enumerated the vertex set of the graph. Time taken = " << std::chrono::duration_cast<std::chrono::duration<double>>(t_vertex - t_start).count() << " seconds.\n";
-
-
     const uint64_t vertex_count = vertex_stats.counted_kmer_count();
+    vertex_metrics.end(vertex_count);
+    dbg_info.add_phase_metrics("vertex enumeration", vertex_metrics);
+    std::cout << "Enumerated the vertex set of the graph. Time taken = " << vertex_metrics.wall_time() << " seconds.\n";
+
     std::cout << "Number of vertices: " << vertex_count << ".\n";
 
 
     std::cout << "\nConstructing the minimal perfect hash function (MPHF) over the vertex set.\n";
+    Phase_Metrics mphf_metrics;
     construct_hash_table(vertex_count);
 
 #ifdef CF_DEVELOP_MODE
@@ -60,24 +63,29 @@ void CdBG<k>::construct()
     if(!params.save_vertices())
         Kmer_Container<k>::remove(logistics.vertex_db_path());
 
-    std::chrono::high_resolution_clock::time_point t_mphf = std::chrono::high_resolution_clock::now();
-    std::cout << "Constructed the minimal perfect hash function for the vertices. Time taken = " << std::chrono::duration_cast<std::chrono::duration<double>>(t_mphf - t_vertex).count() << " seconds.\n";
+    mphf_metrics.end(vertex_count);
+    dbg_info.add_phase_metrics("MPHF construction", mphf_metrics);
+    std::cout << "Constructed the minimal perfect hash function for the vertices. Time taken = " << mphf_metrics.wall_time() << " seconds.\n";
     
 
     std::cout << "\nComputing the DFA states.\n";
+    Phase_Metrics dfa_metrics;
     classify_vertices();
     if(params.track_short_seqs())
         dbg_info.add_short_seqs_info(short_seqs);
 
-    std::chrono::high_resolution_clock::time_point t_dfa = std::chrono::high_resolution_clock::now();
-    std::cout << "Computed the states of the automata. Time taken = " << std::chrono::duration_cast<std::chrono::duration<double>>(t_dfa - t_mphf).count() << " seconds.\n";
+    dfa_metrics.end(vertex_count);
+    dbg_info.add_phase_metrics("DFA states computation", dfa_metrics);
+    std::cout << "Computed the states of the automata. Time taken = " << dfa_metrics.wall_time() << " seconds.\n";
 
 
     std::cout << "\nExtracting the maximal unitigs.\n";
+    Phase_Metrics output_metrics;
     output_maximal_unitigs();
 
-    std::chrono::high_resolution_clock::time_point t_extract = std::chrono::high_resolution_clock::now();
-    std::cout << "Extracted the maximal unitigs. Time taken = " << std::chrono::duration_cast<std::chrono::duration<double>>(t_extract - t_dfa).count() << " seconds.\n";
+    output_metrics.end(vertex_count);
+    dbg_info.add_phase_metrics("output", output_metrics);
+    std::cout << "Extracted the maximal unitigs. Time taken = " << output_metrics.wall_time() << " seconds.\n";
 
 
     const double max_disk = static_cast<double>(max_disk_usage(vertex_stats)) / (1024.0 * 1024.0 * 1024.0);
@@ -107,13 +115,7 @@ template <uint16_t k>
  */
 void CdBG<k>::construct_hash_table(const uint64_t vertex_count)
 {
-  // process_peak_memory()： proc/self/status 文件中记录的读取文件的进程
-  // 峰值内存(文件的单位是KB) * 1024 -> 字节
-  // 与输入参数中的 max_memory  * 1024^3 
-  // 为什么要这样预估最大内存?
-  std::size_t max_memory = std::max(
-      process_peak_memory(), params.max_memory() * 1024U * 1024U * 1024U);
-  max_memory = (max_memory > parser_memory ? max_memory - parser_memory : 0);
+  const std::size_t max_memory = Memory_Budget::available(parser_memory);
   // std::make_unique 离开作用域就立刻释放内存
   hash_table = (params.strict_memory()
                     ? std::make_unique<
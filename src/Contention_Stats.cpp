@@ -0,0 +1,112 @@
+
+#include "Contention_Stats.hpp"
+
+#include <algorithm>
+#include <utility>
+#include <string>
+
+
+void Contention_Stats::Counters::merge(const Counters& rhs)
+{
+    lookups += rhs.lookups;
+    updates += rhs.updates;
+    failed_updates += rhs.failed_updates;
+    lock_acquisitions += rhs.lock_acquisitions;
+    contended_acquisitions += rhs.contended_acquisitions;
+    spins += rhs.spins;
+}
+
+
+Contention_Stats::Thread_Counters::~Thread_Counters()
+{
+    lock.lock();
+    total.merge(*this);
+    lock.unlock();
+}
+
+
+void Contention_Stats::register_stripes(std::atomic<uint64_t>* const spins, const std::size_t stripe_count)
+{
+    lock.lock();
+    stripe_spins.push_back({spins, stripe_count});
+    lock.unlock();
+}
+
+
+void Contention_Stats::deregister_stripes(const std::atomic<uint64_t>* const spins)
+{
+    lock.lock();
+    stripe_spins.erase(std::remove_if(stripe_spins.begin(), stripe_spins.end(),
+                                        [spins](const Stripe_Spins& s){ return s.spins == spins; }),
+                        stripe_spins.end());
+    lock.unlock();
+}
+
+
+nlohmann::ordered_json Contention_Stats::collect()
+{
+    lock.lock();
+
+    total.merge(local);
+    static_cast<Counters&>(local) = Counters();
+    const Counters c = total;
+    total = Counters();
+
+    nlohmann::ordered_json stats;
+    stats["lookups"] = c.lookups;
+    stats["updates"] = c.updates;
+    stats["failed updates"] = c.failed_updates;
+    stats["lock acquisitions"] = c.lock_acquisitions;
+    stats["contended acquisitions"] = c.contended_acquisitions;
+    stats["spin iterations"] = c.spins;
+
+    nlohmann::ordered_json stripes = nlohmann::ordered_json::array();
+    for(const Stripe_Spins& s: stripe_spins)
+    {
+        // Bucket `b` of the histogram counts the stripes with spins in [2^(b - 1), 2^b).
+        std::vector<uint64_t> histogram(65, 0);
+        std::vector<std::pair<uint64_t, std::size_t>> hot;  // (spins, stripe) of the hottest stripes.
+        for(std::size_t i = 0; i < s.stripe_count; ++i)
+        {
+            const uint64_t spins = s.spins[i].exchange(0, std::memory_order_relaxed);
+            histogram[spins == 0 ? 0 : 64 - __builtin_clzll(spins)]++;
+
+            if(spins > 0)
+            {
+                hot.emplace_back(spins, i);
+                if(hot.size() > 2 * HOT_STRIPE_COUNT)   // Amortized pruning to the hottest ones.
+                {
+                    std::nth_element(hot.begin(), hot.begin() + HOT_STRIPE_COUNT, hot.end(), std::greater<>());
+                    hot.resize(HOT_STRIPE_COUNT);
+                }
+            }
+        }
+
+        std::sort(hot.begin(), hot.end(), std::greater<>());
+        if(hot.size() > HOT_STRIPE_COUNT)
+            hot.resize(HOT_STRIPE_COUNT);
+
+        nlohmann::ordered_json stripe_info;
+        stripe_info["stripe count"] = s.stripe_count;
+
+        nlohmann::ordered_json hist;
+        while(histogram.size() > 1 && histogram.back() == 0)
+            histogram.pop_back();
+        for(std::size_t b = 0; b < histogram.size(); ++b)
+            hist[b == 0 ? std::string("0") : "[" + std::to_string(1ULL << (b - 1)) + ", " + std::to_string(b < 64 ? (1ULL << b) : ~0ULL) + ")"] = histogram[b];
+        stripe_info["spins histogram"] = hist;
+
+        nlohmann::ordered_json hottest = nlohmann::ordered_json::array();
+        for(const auto& h: hot)
+            hottest.push_back({{"stripe", h.second}, {"spins", h.first}});
+        stripe_info["hottest stripes"] = hottest;
+
+        stripes.push_back(stripe_info);
+    }
+
+    stats["lock-stripes"] = stripes;
+
+    lock.unlock();
+
+    return stats;
+}
@@ -0,0 +1,39 @@
+
+#include "Cuttlefish_API.hpp"
+#include "Build_Params.hpp"
+#include "Read_CdBG.hpp"
+#include "Application.hpp"
+
+#include <iostream>
+
+
+namespace cuttlefish
+{
+
+bool build(const Build_Config& config, const Unitig_Sink& sink)
+{
+    Build_Params params(!config.is_ref_graph, config.is_ref_graph,
+                        config.seqs, config.lists, config.dirs,
+                        config.k, config.cutoff, _default::EMPTY, _default::EMPTY,
+                        config.thread_count, config.max_memory, config.strict_memory,
+                        config.output_prefix, std::nullopt, false, false, config.working_dir_path,
+                        config.path_cover, config.partitioned, config.minimizer_layout, config.owner_computes, config.coalesce_edges,
+                        false, false, false
+#ifdef CF_DEVELOP_MODE
+                        , _default::GAMMA
+#endif
+                    );
+    if(!params.is_valid())
+    {
+        std::cerr << "Invalid configuration for the compacted de Bruijn graph construction.\n";
+        return false;
+    }
+
+    params.set_unitig_sink(sink);
+
+    Application<Read_CdBG>(params).execute();
+
+    return true;
+}
+
+}
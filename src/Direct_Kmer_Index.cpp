@@ -0,0 +1,103 @@
+
+#include "Direct_Kmer_Index.hpp"
+#include "Kmer_Container.hpp"
+#include "Kmer_SPMC_Iterator.hpp"
+#include "globals.hpp"
+
+#include <thread>
+#include <memory>
+#include <functional>
+#include <iostream>
+
+
+template <uint16_t k>
+uint64_t Direct_Kmer_Index<k>::slot_count(const uint64_t kmer_count)
+{
+    return kmer_count + kmer_count / 2 + 1;
+}
+
+
+template <uint16_t k>
+std::size_t Direct_Kmer_Index<k>::memory(const uint64_t kmer_count)
+{
+    const uint64_t slots = slot_count(kmer_count);
+    return slots * sizeof(key_t) + ((slots + 63) / 64) * sizeof(Block);
+}
+
+
+template <uint16_t k>
+void Direct_Kmer_Index<k>::construct(const std::string& kmc_db_path, const uint64_t kmer_count, const uint16_t thread_count)
+{
+    kmer_count_ = kmer_count;
+    const uint64_t slots = slot_count(kmer_count);
+    key.assign(slots, key_t());
+    block.assign((slots + 63) / 64, Block());
+    inserted = 0;
+
+    const Kmer_Container<k> kmer_container(kmc_db_path);
+    Kmer_SPMC_Iterator<k> kmer_parser(&kmer_container, thread_count);
+    kmer_parser.launch_production();
+
+    std::vector<std::unique_ptr<std::thread>> T(thread_count);
+    for(uint16_t thread_id = 0; thread_id < thread_count; ++thread_id)
+        T[thread_id].reset(
+            new std::thread(&Direct_Kmer_Index::insert_kmers, this, std::ref(kmer_parser), thread_id)
+        );
+
+    kmer_parser.seize_production();
+
+    for(uint16_t thread_id = 0; thread_id < thread_count; ++thread_id)
+        T[thread_id]->join();
+
+    // Sample the ranks of the occupied slots, which are the IDs of their k-mers.
+    uint64_t rank = 0;
+    for(Block& b : block)
+    {
+        b.rank = rank;
+        rank += __builtin_popcountll(b.occupied);
+    }
+
+    if(rank != kmer_count)
+    {
+        std::cerr << "Expected " << kmer_count << " k-mers in the database, but indexed " << rank << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+
+template <uint16_t k>
+void Direct_Kmer_Index<k>::insert_kmers(Kmer_SPMC_Iterator<k>& kmer_parser, const uint16_t thread_id)
+{
+    Kmer<k> kmer;
+
+    // The k-mers of the database are distinct, so an insertion only needs to claim an unoccupied
+    // slot. The slots are claimed through their occupancy bits; their keys are read only after the
+    // construction.
+    while(kmer_parser.tasks_expected(thread_id))
+        if(kmer_parser.value_at(thread_id, kmer))
+        {
+            if(__sync_fetch_and_add(&inserted, 1) >= kmer_count_)
+            {
+                std::cerr << "Found more k-mers in the database than its expected count " << kmer_count_ << ". Aborting.\n";
+                std::exit(EXIT_FAILURE);
+            }
+
+            uint64_t s = home(kmer);
+            while(__sync_fetch_and_or(&block[s >> 6].occupied, 1ULL << (s & 63)) & (1ULL << (s & 63)))
+                s = next(s);
+
+            key[s] = kmer;
+        }
+}
+
+
+template <uint16_t k>
+uint64_t Direct_Kmer_Index<k>::totalBitSize() const
+{
+    return (key.size() * sizeof(key_t) + block.size() * sizeof(Block)) * 8;
+}
+
+
+
+// Template instantiations for the required instances.
+ENUMERATE(INSTANCE_COUNT, INSTANTIATE, Direct_Kmer_Index)
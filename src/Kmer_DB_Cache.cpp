@@ -0,0 +1,87 @@
+
+#include "Kmer_DB_Cache.hpp"
+#include "utility.hpp"
+
+#include <cstring>
+#include <iostream>
+
+
+std::string Kmer_DB_Cache::db_path_;
+std::size_t Kmer_DB_Cache::capacity_ = 0;
+std::size_t Kmer_DB_Cache::planned_ = 0;
+std::size_t Kmer_DB_Cache::size_ = 0;
+bool Kmer_DB_Cache::complete_ = false;
+std::vector<Kmer_DB_Cache::Block> Kmer_DB_Cache::blocks_;
+bool Kmer_DB_Cache::disabled_ = false;
+
+
+bool Kmer_DB_Cache::plan(const std::string& db_path, const std::size_t capacity)
+{
+    if(disabled_)
+        return false;
+
+    clear();
+
+    const std::size_t suff_size = file_size(db_path + ".kmc_suf");
+    if(suff_size == 0 || suff_size > capacity)
+        return false;
+
+    db_path_ = db_path;
+    capacity_ = capacity;
+    planned_ = suff_size;
+
+    std::cout << "Caching the k-mer database " << db_path << " in memory: " << suff_size / (1024 * 1024) << " MB.\n";
+    return true;
+}
+
+
+bool Kmer_DB_Cache::cached(const std::string& db_path)
+{
+    return complete_ && db_path == db_path_;
+}
+
+
+bool Kmer_DB_Cache::filling(const std::string& db_path)
+{
+    return !complete_ && !db_path_.empty() && db_path == db_path_;
+}
+
+
+void Kmer_DB_Cache::add(const uint8_t* const suff, const std::size_t suff_bytes, const std::vector<std::pair<uint64_t, uint64_t>>& pref, const uint64_t kmer_count)
+{
+    if(db_path_.empty())    // The cache has been abandoned.
+        return;
+
+    const std::size_t block_size = suff_bytes + pref.size() * sizeof(pref[0]);
+    if(size_ + block_size > capacity_)
+    {
+        std::cerr << "\nThe k-mer database " << db_path_ << " outgrew its cache. It will be read from disk.\n";
+        clear();
+        return;
+    }
+
+    blocks_.emplace_back();
+    Block& block = blocks_.back();
+    block.suff.resize(suff_bytes);
+    std::memcpy(block.suff.data(), suff, suff_bytes);
+    block.pref = pref;
+    block.kmer_count = kmer_count;
+
+    size_ += block_size;
+}
+
+
+void Kmer_DB_Cache::complete()
+{
+    if(!db_path_.empty())
+        complete_ = true;
+}
+
+
+void Kmer_DB_Cache::clear()
+{
+    db_path_.clear();
+    capacity_ = planned_ = size_ = 0;
+    complete_ = false;
+    std::vector<Block>().swap(blocks_);
+}
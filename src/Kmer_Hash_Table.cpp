@@ -1,6 +1,7 @@
 
 #include "Kmer_Hash_Table.hpp"
 #include "Kmer_SPMC_Iterator.hpp"
+#include "Kmer_Bucket_Iterator.hpp"
 #include "Build_Params.hpp"
 #include "utility.hpp"
 
@@ -8,6 +9,7 @@
 #include <algorithm>
 #include <chrono>
 #include <cstdio>
+#include <utility>
 
 
 
@@ -44,11 +46,12 @@ template <uint16_t k, uint8_t BITS_PER_KEY>
 Kmer_Hash_Table<k, BITS_PER_KEY>::Kmer_Hash_Table(
     const std::string &kmc_db_path, const uint64_t kmer_count)
     : gamma(gamma_min), kmc_db_path(kmc_db_path), kmer_count(kmer_count),
-      hash_table(kmer_count), sparse_lock(kmer_count, lock_count) {}
+      sparse_lock(kmer_count, lock_count) {}
 
 template <uint16_t k, uint8_t BITS_PER_KEY>
 Kmer_Hash_Table<k, BITS_PER_KEY>::Kmer_Hash_Table(const std::string& kmc_db_path, const uint64_t kmer_count, const std::size_t max_memory): Kmer_Hash_Table(kmc_db_path, kmer_count)
 {
+    memory_budget = max_memory;
     set_gamma(max_memory);
 }
 
@@ -57,6 +60,7 @@ template <uint16_t k, uint8_t BITS_PER_KEY>
 Kmer_Hash_Table<k, BITS_PER_KEY>::Kmer_Hash_Table(const std::string& kmc_db_path, const uint64_t kmer_count, const std::size_t max_memory, const double gamma):
     Kmer_Hash_Table(kmc_db_path, kmer_count)
 {
+    memory_budget = max_memory;
     if(gamma > 0)
         this->gamma = std::min(std::max(gamma, gamma_min), gamma_max);
     else
@@ -78,6 +82,23 @@ void Kmer_Hash_Table<k, BITS_PER_KEY>::set_gamma(const std::size_t max_memory)
 }
 
 
+template <uint16_t k, uint8_t BITS_PER_KEY>
+std::size_t Kmer_Hash_Table<k, BITS_PER_KEY>::min_memory(const uint64_t kmer_count)
+{
+    return static_cast<std::size_t>(kmer_count * (min_bits_per_hash_key + BITS_PER_KEY) / 8U);
+}
+
+
+template <uint16_t k, uint8_t BITS_PER_KEY>
+void Kmer_Hash_Table<k, BITS_PER_KEY>::allocate_buckets()
+{
+    bitvector_t buckets(kmer_count);
+    std::swap(hash_table, buckets);
+
+    hash_table.clear_mem();
+}
+
+
 template <uint16_t k, uint8_t BITS_PER_KEY>
 /**
  * @brief 构建最小完美哈希函数
@@ -88,7 +109,7 @@ template <uint16_t k, uint8_t BITS_PER_KEY>
  * @param working_dir_path 工作目录路径
  * @param mph_file_path 最小完美哈希函数文件路径
  */
-void Kmer_Hash_Table<k, BITS_PER_KEY>::build_mph_function(const uint16_t thread_count, const std::string& working_dir_path, const std::string& mph_file_path)
+void Kmer_Hash_Table<k, BITS_PER_KEY>::build_mph_function(const uint16_t thread_count, const std::string& working_dir_path, const std::string& mph_file_path, const bool minimizer_layout)
 {
     // The serialized BBHash file (saved from some earlier execution) exists.
     // 如果存在BBHash文件，则直接加载
@@ -97,10 +118,20 @@ void Kmer_Hash_Table<k, BITS_PER_KEY>::build_mph_function(const uint16_t thread_
         std::cout << "Found the MPHF at file " << mph_file_path << ".\n";
         std::cout << "Loading the MPHF.\n";
 
-        load_mph_function(mph_file_path);
+        load_mph_function(mph_file_path, minimizer_layout);
 
         std::cout << "Loaded the MPHF into memory.\n";
     }
+    else if(minimizer_layout)
+    {
+        std::cout << "Building the minimizer-grouped MPHF from the k-mer database " << kmc_db_path << ".\n";
+        std::cout << "Using gamma = " << gamma << ".\n";
+
+        minimizer_mph = new Minimizer_MPHF<k>();
+        minimizer_mph->construct(kmc_db_path, kmer_count, thread_count, working_dir_path, gamma);
+
+        std::cout << "Built the MPHF in memory.\n";
+    }
     else    // No BBHash file name provided, or does not exist. Build one now.
     {
         // Open a container over the k-mer database.
@@ -124,7 +155,19 @@ void Kmer_Hash_Table<k, BITS_PER_KEY>::build_mph_function(const uint16_t thread_
 
 
 template <uint16_t k, uint8_t BITS_PER_KEY>
-void Kmer_Hash_Table<k, BITS_PER_KEY>::load_mph_function(const std::string& file_path)
+bool Kmer_Hash_Table<k, BITS_PER_KEY>::use_direct_index(const std::string& mph_file_path, const bool save_mph, const bool minimizer_layout) const
+{
+    if(minimizer_layout || save_mph || (!mph_file_path.empty() && file_exists(mph_file_path)))
+        return false;
+
+    const std::size_t buckets_memory = (kmer_count * BITS_PER_KEY + 7) / 8;
+    return kmer_count <= Direct_Kmer_Index<k>::MAX_KMER_COUNT &&
+            Direct_Kmer_Index<k>::memory(kmer_count) + buckets_memory <= memory_budget;
+}
+
+
+template <uint16_t k, uint8_t BITS_PER_KEY>
+void Kmer_Hash_Table<k, BITS_PER_KEY>::load_mph_function(const std::string& file_path, const bool minimizer_layout)
 {
     std::ifstream input(file_path.c_str(), std::ifstream::in);
     if(input.fail())
@@ -133,8 +176,47 @@ void Kmer_Hash_Table<k, BITS_PER_KEY>::load_mph_function(const std::string& file
         std::exit(EXIT_FAILURE);
     }
 
-    mph = new mphf_t();
-    mph->load(input);
+    uint64_t magic = 0;
+    uint32_t hash_scheme = 0;
+    uint16_t kmer_len = 0;
+    uint8_t layout = 0;
+    input.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    input.read(reinterpret_cast<char*>(&hash_scheme), sizeof(hash_scheme));
+    input.read(reinterpret_cast<char*>(&kmer_len), sizeof(kmer_len));
+    input.read(reinterpret_cast<char*>(&layout), sizeof(layout));
+    if(!input || magic != mph_file_magic || hash_scheme != Kmer_Hasher<Kmer<k>::width_t::word_count>::scheme)
+    {
+        std::cerr << "The MPHF at file " << file_path << " was built over a different k-mer hash scheme. Remove it to have it rebuilt. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    if(kmer_len != k)
+    {
+        std::cerr << "The MPHF at file " << file_path << " was built for k = " << kmer_len << ", not for k = " << k << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    if(static_cast<bool>(layout) != minimizer_layout)
+    {
+        std::cerr << "The MPHF at file " << file_path << " was built " << (layout ? "with" : "without") << " the minimizer layout; "
+                        "use it " << (layout ? "with" : "without") << " `--minimizer-layout`. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    if(minimizer_layout)
+    {
+        minimizer_mph = new Minimizer_MPHF<k>();
+        minimizer_mph->load(input);
+    }
+    else
+    {
+        mph = new mphf_t();
+        if(!mph->load(input))
+        {
+            std::cerr << "The MPHF at file " << file_path << " was saved in a newer, unsupported format. Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+    }
 
     input.close();
 }
@@ -150,7 +232,18 @@ void Kmer_Hash_Table<k, BITS_PER_KEY>::save_mph_function(const std::string& file
         std::exit(EXIT_FAILURE);
     }
 
-    mph->save(output);
+    const uint32_t hash_scheme = Kmer_Hasher<Kmer<k>::width_t::word_count>::scheme;
+    const uint16_t kmer_len = k;
+    const uint8_t layout = (minimizer_mph != NULL);
+    output.write(reinterpret_cast<const char*>(&mph_file_magic), sizeof(mph_file_magic));
+    output.write(reinterpret_cast<const char*>(&hash_scheme), sizeof(hash_scheme));
+    output.write(reinterpret_cast<const char*>(&kmer_len), sizeof(kmer_len));
+    output.write(reinterpret_cast<const char*>(&layout), sizeof(layout));
+
+    if(minimizer_mph != NULL)
+        minimizer_mph->save(output);
+    else
+        mph->save(output);
     
     output.close();
 }
@@ -200,7 +293,7 @@ void Kmer_Hash_Table<k, BITS_PER_KEY>::save(const Build_Params& params) const
 template <uint16_t k, uint8_t BITS_PER_KEY>
 void Kmer_Hash_Table<k, BITS_PER_KEY>::load(const Build_Params& params)
 {
-    load_mph_function(params.mph_file_path());
+    load_mph_function(params.mph_file_path(), params.minimizer_layout());
     load_hash_buckets(params.buckets_file_path());
 }
 
@@ -234,15 +327,25 @@ template <uint16_t k, uint8_t BITS_PER_KEY>
  */
 void Kmer_Hash_Table<k, BITS_PER_KEY>::construct(
     const uint16_t thread_count, const std::string &working_dir_path,
-    const std::string &mph_file_path, const bool save_mph) {
+    const std::string &mph_file_path, const bool save_mph, const bool minimizer_layout) {
   // std::chrono::high_resolution_clock::time_point t_start =
   // std::chrono::high_resolution_clock::now();
 
   std::cout << "Total number of k-mers in the set (KMC database): "
             << kmer_count << ".\n";
 
-  // Build the minimal perfect hash function.
-  build_mph_function(thread_count, working_dir_path, mph_file_path);
+  // Small sets of k-mers are indexed directly, skipping the MPHF construction.
+  if (use_direct_index(mph_file_path, save_mph, minimizer_layout))
+  {
+    std::cout << "Building a direct index over the k-mer database " << kmc_db_path << ".\n";
+
+    direct_index = new Direct_Kmer_Index<k>();
+    direct_index->construct(kmc_db_path, kmer_count, thread_count);
+
+    std::cout << "Built the index in memory.\n";
+  }
+  else // Build the minimal perfect hash function.
+    build_mph_function(thread_count, working_dir_path, mph_file_path, minimizer_layout);
 
   if (save_mph) // false
   {
@@ -250,14 +353,15 @@ void Kmer_Hash_Table<k, BITS_PER_KEY>::construct(
     std::cout << "Saved the hash function at " << mph_file_path << "\n";
   }
 
-  const uint64_t total_bits = mph->totalBitSize();
-  std::cout << "\nTotal MPHF size: " << total_bits / (8 * 1024 * 1024)
+  const uint64_t total_bits = (direct_index != NULL ? direct_index->totalBitSize() :
+                                minimizer_mph != NULL ? minimizer_mph->totalBitSize() : mph->totalBitSize());
+  std::cout << (direct_index != NULL ? "\nTotal direct index size: " : "\nTotal MPHF size: ") << total_bits / (8 * 1024 * 1024)
             << " MB."
                " Bits per k-mer: "
             << static_cast<double>(total_bits) / kmer_count << ".\n";
 
   // Allocate the hash table buckets.
-  hash_table.clear_mem();
+  allocate_buckets();
   std::cout << "Allocated hash table buckets for the k-mers. Total size: "
             << hash_table.bytes() / (1024 * 1024) << " MB.\n";
 
@@ -275,6 +379,20 @@ void Kmer_Hash_Table<k, BITS_PER_KEY>::construct(
   // = " << elapsed_seconds << " seconds.\n";
 }
 
+template <uint16_t k, uint8_t BITS_PER_KEY>
+void Kmer_Hash_Table<k, BITS_PER_KEY>::construct_over_bucket(const uint16_t thread_count, const std::string& working_dir_path)
+{
+    const Kmer_Bucket_Iterator<k> bucket_begin(kmc_db_path, kmer_count, thread_count);
+    const Kmer_Bucket_Iterator<k> bucket_end(kmc_db_path, kmer_count, thread_count, false, true);
+    const auto data_iterator = boomphf::range(bucket_begin, bucket_end);
+
+    // The per-bucket progress bars of BBHash are suppressed, as there may be lots of buckets.
+    mph = new mphf_t(kmer_count, data_iterator, working_dir_path, thread_count, gamma, true, false);
+
+    allocate_buckets();
+}
+
+
 template <uint16_t k, uint8_t BITS_PER_KEY>
 void Kmer_Hash_Table<k, BITS_PER_KEY>::clear()
 {
@@ -283,6 +401,16 @@ void Kmer_Hash_Table<k, BITS_PER_KEY>::clear()
 
     mph = NULL;
 
+    if(minimizer_mph != NULL)
+        delete minimizer_mph;
+
+    minimizer_mph = NULL;
+
+    if(direct_index != NULL)
+        delete direct_index;
+
+    direct_index = NULL;
+
     
     // hash_table.clear();
     hash_table.resize(0);
@@ -0,0 +1,87 @@
+
+#include "Memory_Budget.hpp"
+#include "Build_Params.hpp"
+#include "Input_Defaults.hpp"
+#include "utility.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <malloc.h>
+
+
+// `jemalloc`'s control interface; weakly linked, so that the budget works with other allocators too.
+extern "C" int mallctl(const char* name, void* oldp, std::size_t* oldlenp, void* newp, std::size_t newlen) __attribute__((weak));
+
+
+std::size_t Memory_Budget::limit_ = cuttlefish::_default::MAX_MEMORY * 1024U * 1024U * 1024U;
+bool Memory_Budget::bounded_ = false;
+std::size_t Memory_Budget::parser_buf_sz = Memory_Budget::MAX_PARSER_BUF_SZ;
+bool Memory_Budget::held_ = false;
+
+
+void Memory_Budget::setup(const Build_Params& params)
+{
+    if(held_)
+        return;
+
+    limit_ = params.max_memory() * 1024U * 1024U * 1024U;
+    bounded_ = (params.strict_memory() && params.max_memory_specified());
+
+    // The parser buffers are shrunk, in powers of two, till all the consumers' ones fit into
+    // their share of the limit.
+    const std::size_t parser_budget = limit_ / PARSER_SHARE;
+    const std::size_t consumer_count = params.thread_count();
+    parser_buf_sz = MAX_PARSER_BUF_SZ;
+    while(parser_buf_sz > MIN_PARSER_BUF_SZ && parser_buf_sz * consumer_count > parser_budget)
+        parser_buf_sz /= 2;
+
+    if(bounded_)
+        std::cout << "Memory budget: " << limit_ / (1024 * 1024) << " MB."
+                     " Parser buffers: " << parser_buf_sz / 1024 << " KB per thread.\n";
+}
+
+
+std::size_t Memory_Budget::available(const std::size_t reserved)
+{
+    // In the soft mode, the memory already used by the process, e.g. by the k-mer enumeration,
+    // is considered to be available too.
+    const std::size_t resident = (bounded_ ? process_curr_memory() : 0);
+    const std::size_t budget = (bounded_ ? limit_ : std::max(process_peak_memory(), limit_));
+    const std::size_t used = resident + reserved;
+
+    return budget > used ? budget - used : 0;
+}
+
+
+void Memory_Budget::release()
+{
+    if(mallctl != nullptr)
+    {
+        // Purges the unused dirty pages of all the arenas, i.e. `MALLCTL_ARENAS_ALL`.
+        mallctl("arena.4096.purge", nullptr, nullptr, nullptr, 0);
+        return;
+    }
+
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+}
+
+
+int64_t Memory_Budget::headroom(const std::size_t peak_rss)
+{
+    return static_cast<int64_t>(limit_) - static_cast<int64_t>(peak_rss);
+}
+
+
+void Memory_Budget::report(const std::string& phase, const std::size_t peak_rss)
+{
+    if(!bounded_)
+        return;
+
+    const int64_t room = headroom(peak_rss);
+    if(room >= 0)
+        std::cout << "Peak memory at " << phase << ": " << peak_rss / (1024 * 1024) << " MB; headroom: " << room / (1024 * 1024) << " MB.\n";
+    else
+        std::cout << "Peak memory at " << phase << ": " << peak_rss / (1024 * 1024) << " MB, exceeding the budget by " << -room / (1024 * 1024) << " MB.\n";
+}
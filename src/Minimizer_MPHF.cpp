@@ -0,0 +1,329 @@
+
+#include "Minimizer_MPHF.hpp"
+#include "Kmer_Container.hpp"
+#include "Kmer_SPMC_Iterator.hpp"
+#include "Kmer_Bucket_Iterator.hpp"
+#include "File_Extensions.hpp"
+#include "utility.hpp"
+#include "globals.hpp"
+
+#include <cmath>
+#include <thread>
+#include <algorithm>
+#include <functional>
+
+
+template <uint16_t k>
+Minimizer_MPHF<k>::Minimizer_MPHF():
+    offset(2, 0),
+    group_mph(1),
+    bucket_lock(MAX_BUCKET_COUNT)
+{}
+
+
+template <uint16_t k>
+void Minimizer_MPHF<k>::construct(const std::string& kmc_db_path, const uint64_t kmer_count, const uint16_t thread_count, const std::string& working_dir_path, const double gamma)
+{
+    group_count_ = static_cast<uint32_t>(std::min<uint64_t>(std::max<uint64_t>((kmer_count + GROUP_SIZE - 1) / GROUP_SIZE, 1), MAX_GROUP_COUNT));
+    groups_per_bucket = (group_count_ + MAX_BUCKET_COUNT - 1) / MAX_BUCKET_COUNT;
+    bucket_count = static_cast<uint16_t>((group_count_ + groups_per_bucket - 1) / groups_per_bucket);
+    std::cout << "Grouping the k-mers into " << group_count_ << " groups by their minimizers.\n";
+
+
+    // Distribute the k-mers into the buckets of their groups.
+    bucket.resize(bucket_count);
+    for(uint16_t b = 0; b < bucket_count; ++b)
+    {
+        bucket[b] = std::fopen(bucket_path(kmc_db_path, working_dir_path, b).c_str(), "wb");
+        if(bucket[b] == nullptr)
+        {
+            std::cerr << "Error opening the bucket " << bucket_path(kmc_db_path, working_dir_path, b) << " for writing. Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+    offset.assign(group_count_ + 1, 0);
+
+    const Kmer_Container<k> kmer_container(kmc_db_path);
+    Kmer_SPMC_Iterator<k> kmer_parser(&kmer_container, thread_count);
+    kmer_parser.launch_production();
+
+    std::vector<std::unique_ptr<std::thread>> T(thread_count);
+    for(uint16_t thread_id = 0; thread_id < thread_count; ++thread_id)
+        T[thread_id].reset(
+            new std::thread(&Minimizer_MPHF::scatter_kmers, this, std::ref(kmer_parser), thread_id)
+        );
+
+    kmer_parser.seize_production();
+
+    for(uint16_t thread_id = 0; thread_id < thread_count; ++thread_id)
+        T[thread_id]->join();
+
+    for(std::FILE* const b: bucket)
+        if(std::fclose(b) != 0)
+        {
+            std::cerr << "Error closing a bucket of the k-mer groups. Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+    bucket.clear();
+
+
+    // Lay the groups out contiguously. `offset` contains the group sizes till this point.
+    uint64_t group_offset = 0;
+    for(uint32_t g = 0; g < group_count_; ++g)
+    {
+        const uint64_t group_size = offset[g];
+        offset[g] = group_offset;
+        group_offset += group_size;
+    }
+
+    offset[group_count_] = group_offset;
+    if(group_offset != kmer_count)
+    {
+        std::cerr << "Expected " << kmer_count << " k-mers in the database, but grouped " << group_offset << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+
+    // Build the BBHash for each group, one bucket at a time.
+    group_mph.clear();
+    group_mph.resize(group_count_);
+    for(uint16_t b = 0; b < bucket_count; ++b)
+        build_bucket(b, kmc_db_path, thread_count, working_dir_path, gamma);
+}
+
+
+template <uint16_t k>
+void Minimizer_MPHF<k>::build_bucket(const uint16_t b, const std::string& kmc_db_path, const uint16_t thread_count, const std::string& working_dir_path, const double gamma)
+{
+    const std::string path = bucket_path(kmc_db_path, working_dir_path, b);
+    const uint32_t g_begin = b * groups_per_bucket;
+    const uint32_t g_end = std::min(g_begin + groups_per_bucket, group_count_);
+
+    if(offset[g_end] > offset[g_begin])
+    {
+        sort_bucket(path, g_begin, thread_count);
+
+        // The groups are small, so each is built by a single thread; the spawning of the BBHash
+        // threads per level would otherwise dominate their construction.
+        uint32_t next_group = g_begin;  // ID of the next group to build.
+        std::vector<std::unique_ptr<std::thread>> T(thread_count);
+        for(uint16_t thread_id = 0; thread_id < thread_count; ++thread_id)
+            T[thread_id].reset(
+                new std::thread([this, &path, &next_group, g_begin, g_end, &working_dir_path, gamma]()
+                {
+                    for(uint32_t g; (g = __sync_fetch_and_add(&next_group, 1)) < g_end; )
+                    {
+                        const uint64_t group_size = offset[g + 1] - offset[g];
+                        if(group_size == 0)
+                            continue;
+
+                        const uint64_t start = offset[g] - offset[g_begin];
+                        const Kmer_Bucket_Iterator<k> bucket_begin(path, group_size, 1, true, false, start);
+                        const Kmer_Bucket_Iterator<k> bucket_end(path, group_size, 1, false, true, start);
+                        const auto data_iterator = boomphf::range(bucket_begin, bucket_end);
+
+                        // The per-group progress bars of BBHash are suppressed, as there may be lots of groups.
+                        group_mph[g].reset(new mphf_t(group_size, data_iterator, working_dir_path, 1, gamma, true, false));
+                    }
+                })
+            );
+
+        for(uint16_t thread_id = 0; thread_id < thread_count; ++thread_id)
+            T[thread_id]->join();
+    }
+
+    remove_file(path);
+}
+
+
+template <uint16_t k>
+void Minimizer_MPHF<k>::sort_bucket(const std::string& path, const uint32_t g_begin, const uint16_t thread_count) const
+{
+    const uint32_t g_end = std::min(g_begin + groups_per_bucket, group_count_);
+    const uint64_t bucket_size = offset[g_end] - offset[g_begin];
+    std::vector<Kmer<k>> kmer(bucket_size);
+
+    std::FILE* input = std::fopen(path.c_str(), "rb");
+    if(input == nullptr || std::fread(kmer.data(), sizeof(Kmer<k>), bucket_size, input) != bucket_size || std::fclose(input) != 0)
+    {
+        std::cerr << "Error reading the bucket " << path << " of the k-mer groups. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+
+    // Compute the groups of the k-mers, concurrently over slices of the bucket.
+    std::vector<uint32_t> group_id(bucket_size);
+    const uint64_t slice_size = (bucket_size + thread_count - 1) / thread_count;
+    std::vector<std::unique_ptr<std::thread>> T(thread_count);
+    for(uint16_t thread_id = 0; thread_id < thread_count; ++thread_id)
+        T[thread_id].reset(
+            new std::thread([this, &kmer, &group_id, slice_size, bucket_size, thread_id]()
+            {
+                const uint64_t slice_end = std::min(bucket_size, (thread_id + 1) * slice_size);
+                for(uint64_t i = thread_id * slice_size; i < slice_end; ++i)
+                    group_id[i] = group(kmer[i]);
+            })
+        );
+
+    for(uint16_t thread_id = 0; thread_id < thread_count; ++thread_id)
+        T[thread_id]->join();
+
+
+    // Counting-sort the k-mers by their groups, and write them back.
+    std::vector<uint64_t> pos(offset.begin() + g_begin, offset.begin() + g_end);
+    for(uint64_t& p: pos)
+        p -= offset[g_begin];
+
+    std::vector<Kmer<k>> sorted_kmer(bucket_size);
+    for(uint64_t i = 0; i < bucket_size; ++i)
+        sorted_kmer[pos[group_id[i] - g_begin]++] = kmer[i];
+
+    std::FILE* output = std::fopen(path.c_str(), "wb");
+    if(output == nullptr || std::fwrite(sorted_kmer.data(), sizeof(Kmer<k>), bucket_size, output) != bucket_size || std::fclose(output) != 0)
+    {
+        std::cerr << "Error writing the bucket " << path << " of the k-mer groups. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+
+template <uint16_t k>
+const std::string Minimizer_MPHF<k>::bucket_path(const std::string& kmc_db_path, const std::string& working_dir_path, const uint16_t b)
+{
+    return working_dir_path + "/" + filename(kmc_db_path) + cuttlefish::file_ext::group_bucket_ext + "." + std::to_string(b);
+}
+
+
+template <uint16_t k>
+void Minimizer_MPHF<k>::scatter_kmers(Kmer_SPMC_Iterator<k>& kmer_parser, const uint16_t thread_id)
+{
+    static constexpr std::size_t buf_kmer_count = BUCKET_BUF_SZ / sizeof(Kmer<k>);
+
+    std::vector<std::vector<Kmer<k>>> buf(bucket_count);    // Thread-local write-buffers for the buckets.
+    std::vector<uint64_t> count(group_count_);  // Number of k-mers distributed into each group by this thread.
+    Kmer<k> kmer;
+
+    for(auto& b: buf)
+        b.reserve(buf_kmer_count);
+
+    while(kmer_parser.tasks_expected(thread_id))
+        if(kmer_parser.value_at(thread_id, kmer))
+        {
+            const uint32_t g = group(kmer);
+            const uint16_t b = static_cast<uint16_t>(g / groups_per_bucket);
+            buf[b].push_back(kmer);
+            count[g]++;
+
+            if(buf[b].size() == buf_kmer_count)
+                flush_to_bucket(b, buf[b]);
+        }
+
+    for(uint16_t b = 0; b < bucket_count; ++b)
+        flush_to_bucket(b, buf[b]);
+
+
+    lock.lock();
+    std::transform(count.begin(), count.end(), offset.begin(), offset.begin(), std::plus<uint64_t>());
+    lock.unlock();
+}
+
+
+template <uint16_t k>
+void Minimizer_MPHF<k>::flush_to_bucket(const uint16_t b, std::vector<Kmer<k>>& buf)
+{
+    if(buf.empty())
+        return;
+
+    bucket_lock[b].lock();
+    const std::size_t written = std::fwrite(buf.data(), sizeof(Kmer<k>), buf.size(), bucket[b]);
+    bucket_lock[b].unlock();
+
+    if(written != buf.size())
+    {
+        std::cerr << "Error writing to a bucket of the k-mer groups. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    buf.clear();
+}
+
+
+template <uint16_t k>
+uint32_t Minimizer_MPHF<k>::group_count() const
+{
+    return group_count_;
+}
+
+
+template <uint16_t k>
+uint64_t Minimizer_MPHF<k>::totalBitSize() const
+{
+    uint64_t total_bits = offset.size() * 64;
+    for(const auto& mph: group_mph)
+        if(mph)
+            total_bits += mph->totalBitSize();
+
+    return total_bits;
+}
+
+
+template <uint16_t k>
+void Minimizer_MPHF<k>::save(std::ostream& output) const
+{
+    // The group count used to be saved in 16 bits; a zero there, never a valid count, marks its
+    // 32-bit form following.
+    const uint16_t wide_count_mark = 0;
+    output.write(reinterpret_cast<const char*>(&wide_count_mark), sizeof(wide_count_mark));
+    output.write(reinterpret_cast<const char*>(&group_count_), sizeof(group_count_));
+    output.write(reinterpret_cast<const char*>(offset.data()), offset.size() * sizeof(uint64_t));
+
+    for(uint32_t g = 0; g < group_count_; ++g)
+        if(group_mph[g])
+            group_mph[g]->save(output);
+
+    if(output.fail())
+    {
+        std::cerr << "Error writing the minimizer-grouped MPHF. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+
+template <uint16_t k>
+void Minimizer_MPHF<k>::load(std::istream& input)
+{
+    uint16_t narrow_count = 0;
+    input.read(reinterpret_cast<char*>(&narrow_count), sizeof(narrow_count));
+    group_count_ = narrow_count;
+    if(narrow_count == 0)
+        input.read(reinterpret_cast<char*>(&group_count_), sizeof(group_count_));
+
+    offset.resize(group_count_ + 1);
+    input.read(reinterpret_cast<char*>(offset.data()), offset.size() * sizeof(uint64_t));
+
+    group_mph.clear();
+    group_mph.resize(group_count_);
+    for(uint32_t g = 0; g < group_count_; ++g)
+        if(offset[g + 1] > offset[g])   // Empty groups have no BBHash saved.
+        {
+            group_mph[g].reset(new mphf_t());
+            if(!group_mph[g]->load(input))
+            {
+                std::cerr << "The minimizer-grouped MPHF was saved in a newer, unsupported format. Aborting.\n";
+                std::exit(EXIT_FAILURE);
+            }
+        }
+
+    if(input.fail())
+    {
+        std::cerr << "Error reading the minimizer-grouped MPHF. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+
+
+// Template instantiations for the required instances.
+ENUMERATE(INSTANCE_COUNT, INSTANTIATE, Minimizer_MPHF)
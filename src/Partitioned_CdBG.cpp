@@ -0,0 +1,899 @@
+
+#include "Partitioned_CdBG.hpp"
+#include "Read_CdBG_Constructor.hpp"
+#include "Kmer_Container.hpp"
+#include "Kmer_SPMC_Iterator.hpp"
+#include "Kmer_Bucket_Iterator.hpp"
+#include "Character_Buffer.hpp"
+#include "FASTA_Record.hpp"
+#include "File_Extensions.hpp"
+#include "dBG_Utilities.hpp"
+#include "utility.hpp"
+#include "Memory_Budget.hpp"
+#ifdef CF_PERF_COUNTERS
+#include "Perf_Counters.hpp"
+#endif
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <thread>
+#include <functional>
+#include <algorithm>
+
+
+template <uint16_t k>
+Partitioned_CdBG<k>::Partitioned_CdBG(const Build_Params& params):
+    params(params),
+    bucket_lock(MAX_PARTITION_COUNT)
+{}
+
+
+template <uint16_t k>
+void Partitioned_CdBG<k>::construct(const std::string& edge_db_path, const std::string& vertex_db_path, const uint64_t vertex_count, const std::string& output_file_path)
+{
+    Phase_Metrics partitioning_metrics;
+
+    vertex_count_ = vertex_count;
+    set_partition_count();
+    std::cout << "Number of partitions: " << partition_count_ << ".\n";
+
+
+    partition_vertices(vertex_db_path);
+    partition_edges(edge_db_path);
+
+    partitioning_metrics.end(vertex_count_ + edge_count_);
+    std::cout << "Partitioned the graph. Time taken = " << partitioning_metrics.wall_time() << " seconds.\n";
+    std::cout << "Number of vertices in the largest partition: " << max_partition_size() << ".\n";
+    phase_metrics_.emplace_back("partitioning", std::move(partitioning_metrics));
+
+
+    Phase_Metrics processing_metrics;
+
+    // Clear the output files and initialize the output sinks; the maximal unitigs go to the caller's
+    // sink instead of the output file, if provided.
+    if(!params.unitig_sink())
+    {
+        clear_file(output_file_path);
+        output_sink.init_sink(output_file_path);
+    }
+
+    fragment_sink.init_sink(fragments_path());
+
+    for(uint16_t p = 0; p < partition_count_; ++p)
+    {
+        Phase_Metrics partition_metrics;
+        process_partition(p);
+        partition_metrics.end(vertex_bucket_size[p]);
+        phase_metrics_.emplace_back("partition " + std::to_string(p), std::move(partition_metrics));
+    }
+
+    fragment_sink.close_sink();
+
+    processing_metrics.end(vertex_count_);
+    std::cout << "Processed the partitions. Time taken = " << processing_metrics.wall_time() << " seconds.\n";
+    std::cout << "Number of unitig fragments crossing the partitions: " << fragment_count << ".\n";
+    phase_metrics_.emplace_back("partition processing", std::move(processing_metrics));
+
+
+    Phase_Metrics join_metrics;
+
+    join_fragments();
+    remove_file(fragments_path());
+
+    if(!params.unitig_sink())
+        output_sink.close_sink();
+
+    unipaths_meta_info_.print();
+
+    join_metrics.end(fragment_count);
+    std::cout << "Joined the unitig fragments. Time taken = " << join_metrics.wall_time() << " seconds.\n";
+    phase_metrics_.emplace_back("fragment join", std::move(join_metrics));
+}
+
+
+template <uint16_t k>
+void Partitioned_CdBG<k>::set_partition_count()
+{
+    const uint16_t thread_count = params.thread_count();
+    // The partitions are bounded by the limit itself, even if it is a soft one.
+    const std::size_t max_memory = (Memory_Budget::bounded() ? Memory_Budget::available(0) : Memory_Budget::limit());
+    const std::size_t parser_memory = std::max(Kmer_SPMC_Iterator<k + 1>::memory(thread_count), Kmer_Bucket_Iterator<k + 1>::memory(thread_count));
+    const double graph_memory = (vertex_count_ * bits_per_vertex / 8.0) * skew_factor;
+
+    // Use the fewest partitions fitting into the limit, with the write-buffers of the buckets sized
+    // by the partition count itself.
+    for(uint16_t p = 1; p <= MAX_PARTITION_COUNT; ++p)
+    {
+        const std::size_t scatter_memory = static_cast<std::size_t>(thread_count) * p * BUCKET_BUF_SZ;
+        if(graph_memory / p + parser_memory + scatter_memory <= max_memory)
+        {
+            partition_count_ = p;
+            return;
+        }
+    }
+
+    partition_count_ = MAX_PARTITION_COUNT;
+    if(Memory_Budget::bounded())
+    {
+        std::cerr << "The graph can not be partitioned to fit into the memory limit of " << max_memory / (1024 * 1024) << " MB"
+                        " with up-to " << MAX_PARTITION_COUNT << " partitions. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    std::cerr << "Warning: the graph can not be partitioned to fit into the memory limit of " << max_memory / (1024 * 1024) << " MB"
+                    " with up-to " << MAX_PARTITION_COUNT << " partitions; using " << MAX_PARTITION_COUNT << ", which may exceed it.\n";
+}
+
+
+template <uint16_t k>
+const std::string Partitioned_CdBG<k>::bucket_path(const char* const ext, const uint16_t p) const
+{
+    return params.working_dir_path() + filename(params.output_prefix()) + ext + "." + std::to_string(p);
+}
+
+
+template <uint16_t k>
+void Partitioned_CdBG<k>::open_buckets(const char* const ext)
+{
+    bucket.resize(partition_count_);
+    for(uint16_t p = 0; p < partition_count_; ++p)
+    {
+        bucket[p] = std::fopen(bucket_path(ext, p).c_str(), "wb");
+        if(bucket[p] == nullptr)
+        {
+            std::cerr << "Error opening the bucket " << bucket_path(ext, p) << " for writing. Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+    }
+}
+
+
+template <uint16_t k>
+void Partitioned_CdBG<k>::close_buckets()
+{
+    for(std::FILE* const b: bucket)
+        if(std::fclose(b) != 0)
+        {
+            std::cerr << "Error closing a bucket of the graph partitions. Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+    bucket.clear();
+}
+
+
+template <uint16_t k>
+template <uint16_t K>
+void Partitioned_CdBG<k>::flush_to_bucket(const uint16_t p, std::vector<Kmer<K>>& buf)
+{
+    if(buf.empty())
+        return;
+
+    bucket_lock[p].lock();
+    const std::size_t written = std::fwrite(buf.data(), sizeof(Kmer<K>), buf.size(), bucket[p]);
+    bucket_lock[p].unlock();
+
+    if(written != buf.size())
+    {
+        std::cerr << "Error writing to a bucket of the graph partitions. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    buf.clear();
+}
+
+
+template <uint16_t k>
+void Partitioned_CdBG<k>::partition_vertices(const std::string& vertex_db_path)
+{
+    const uint16_t thread_count = params.thread_count();
+    const Kmer_Container<k> vertex_container(vertex_db_path);
+    Kmer_SPMC_Iterator<k> vertex_parser(&vertex_container, thread_count);
+
+    vertex_bucket_size.assign(partition_count_, 0);
+    open_buckets(cuttlefish::file_ext::vertex_bucket_ext);
+
+    vertex_parser.launch_production();
+
+    std::vector<std::unique_ptr<std::thread>> T(thread_count);
+    for(uint16_t thread_id = 0; thread_id < thread_count; ++thread_id)
+        T[thread_id].reset(
+            new std::thread(&Partitioned_CdBG::scatter_vertices, this, std::ref(vertex_parser), thread_id)
+        );
+
+    vertex_parser.seize_production();
+
+    for(uint16_t thread_id = 0; thread_id < thread_count; ++thread_id)
+        T[thread_id]->join();
+
+    close_buckets();
+}
+
+
+template <uint16_t k>
+void Partitioned_CdBG<k>::scatter_vertices(Kmer_SPMC_Iterator<k>& vertex_parser, const uint16_t thread_id)
+{
+    static constexpr std::size_t buf_kmer_count = BUCKET_BUF_SZ / sizeof(Kmer<k>);
+
+    std::vector<std::vector<Kmer<k>>> buf(partition_count_);    // Thread-local write-buffers for the buckets.
+    std::vector<uint64_t> count(partition_count_);  // Number of vertices distributed into each bucket by this thread.
+    Kmer<k> v_hat;
+
+    for(auto& b: buf)
+        b.reserve(buf_kmer_count);
+
+    while(vertex_parser.tasks_expected(thread_id))
+        if(vertex_parser.value_at(thread_id, v_hat))
+        {
+            const uint16_t p = partition(v_hat);
+            buf[p].push_back(v_hat);
+            count[p]++;
+
+            if(buf[p].size() == buf_kmer_count)
+                flush_to_bucket(p, buf[p]);
+        }
+
+    for(uint16_t p = 0; p < partition_count_; ++p)
+        flush_to_bucket(p, buf[p]);
+
+
+    lock.lock();
+    std::transform(vertex_bucket_size.begin(), vertex_bucket_size.end(), count.begin(), vertex_bucket_size.begin(), std::plus<uint64_t>());
+    lock.unlock();
+}
+
+
+template <uint16_t k>
+void Partitioned_CdBG<k>::partition_edges(const std::string& edge_db_path)
+{
+    const uint16_t thread_count = params.thread_count();
+    const Kmer_Container<k + 1> edge_container(edge_db_path);
+    Kmer_SPMC_Iterator<k + 1> edge_parser(&edge_container, thread_count);
+
+    edge_bucket_size.assign(partition_count_, 0);
+    open_buckets(cuttlefish::file_ext::edge_bucket_ext);
+
+    edge_parser.launch_production();
+
+    std::vector<std::unique_ptr<std::thread>> T(thread_count);
+    for(uint16_t thread_id = 0; thread_id < thread_count; ++thread_id)
+        T[thread_id].reset(
+            new std::thread(&Partitioned_CdBG::scatter_edges, this, std::ref(edge_parser), thread_id)
+        );
+
+    edge_parser.seize_production();
+
+    for(uint16_t thread_id = 0; thread_id < thread_count; ++thread_id)
+        T[thread_id]->join();
+
+    close_buckets();
+}
+
+
+template <uint16_t k>
+void Partitioned_CdBG<k>::scatter_edges(Kmer_SPMC_Iterator<k + 1>& edge_parser, const uint16_t thread_id)
+{
+    static constexpr std::size_t buf_kmer_count = BUCKET_BUF_SZ / sizeof(Kmer<k + 1>);
+
+    std::vector<std::vector<Kmer<k + 1>>> buf(partition_count_);    // Thread-local write-buffers for the buckets.
+    std::vector<uint64_t> count(partition_count_);  // Number of edges distributed into each bucket by this thread.
+    uint64_t edge_count = 0;    // Number of edges scanned by this thread.
+    Kmer<k + 1> e;
+    Kmer<k> u, v;   // The endpoints of the edge `e`.
+
+    for(auto& b: buf)
+        b.reserve(buf_kmer_count);
+
+    // An edge is needed by the partition(s) of its endpoints only, to compute their states.
+    const auto add_to_bucket =
+        [&](const uint16_t p)
+        {
+            buf[p].push_back(e);
+            count[p]++;
+
+            if(buf[p].size() == buf_kmer_count)
+                flush_to_bucket(p, buf[p]);
+        };
+
+    while(edge_parser.tasks_expected(thread_id))
+        if(edge_parser.value_at(thread_id, e))
+        {
+            u.from_prefix(e), v.from_suffix(e);
+
+            const uint16_t p_u = partition(u);
+            const uint16_t p_v = partition(v);
+
+            add_to_bucket(p_u);
+            if(p_v != p_u)
+                add_to_bucket(p_v);
+
+            edge_count++;
+        }
+
+    for(uint16_t p = 0; p < partition_count_; ++p)
+        flush_to_bucket(p, buf[p]);
+
+
+    lock.lock();
+    edge_count_ += edge_count;
+    std::transform(edge_bucket_size.begin(), edge_bucket_size.end(), count.begin(), edge_bucket_size.begin(), std::plus<uint64_t>());
+    lock.unlock();
+}
+
+
+template <uint16_t k>
+void Partitioned_CdBG<k>::process_partition(const uint16_t p)
+{
+    curr_partition = p;
+
+    const std::string vertex_bucket_path = bucket_path(cuttlefish::file_ext::vertex_bucket_ext, p);
+    if(vertex_bucket_size[p] > 0)
+    {
+        const std::size_t parser_memory = Kmer_Bucket_Iterator<k>::memory(params.thread_count());
+        const std::size_t budget = (Memory_Budget::bounded() ? Memory_Budget::available(0) : Memory_Budget::limit());
+        const std::size_t max_memory = (budget > parser_memory ? budget - parser_memory : 0);
+
+        hash_table = std::make_unique<Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>>(vertex_bucket_path, vertex_bucket_size[p], max_memory);
+        hash_table->construct_over_bucket(params.thread_count(), params.working_dir_path());
+
+        compute_DFA_states();
+        extract_fragments();
+
+        hash_table.reset();
+    }
+
+    remove_file(bucket_path(cuttlefish::file_ext::edge_bucket_ext, p));
+    remove_file(vertex_bucket_path);
+
+    curr_id_offset += vertex_bucket_size[p];
+}
+
+
+template <uint16_t k>
+void Partitioned_CdBG<k>::compute_DFA_states()
+{
+    const uint16_t thread_count = params.thread_count();
+    Read_CdBG_Constructor<k> cdbg_constructor(params, *hash_table);
+    Kmer_Bucket_Iterator<k + 1> edge_parser(bucket_path(cuttlefish::file_ext::edge_bucket_ext, curr_partition), edge_bucket_size[curr_partition], thread_count);
+
+    edge_parser.launch_production();
+
+    std::vector<std::unique_ptr<std::thread>> T(thread_count);
+    for(uint16_t thread_id = 0; thread_id < thread_count; ++thread_id)
+        T[thread_id].reset(
+            new std::thread(&Partitioned_CdBG::process_edges, this, std::ref(edge_parser), std::ref(cdbg_constructor), thread_id)
+        );
+
+    for(uint16_t thread_id = 0; thread_id < thread_count; ++thread_id)
+        T[thread_id]->join();
+}
+
+
+template <uint16_t k>
+void Partitioned_CdBG<k>::process_edges(Kmer_Bucket_Iterator<k + 1>& edge_parser, Read_CdBG_Constructor<k>& cdbg_constructor, const uint16_t thread_id)
+{
+#ifdef CF_PERF_COUNTERS
+    const Perf_Thread_Scope perf_scope("edge thread " + std::to_string(thread_id));
+#endif
+
+    Edge<k> e;  // For the edges to be processed one-by-one.
+
+    while(edge_parser.tasks_expected(thread_id))
+        if(edge_parser.value_at(thread_id, e.e()))
+        {
+            // Only the endpoints inside the current partition are hashed; the MPHF of the partition
+            // is undefined over the others, which are never looked up.
+            e.configure();
+            const bool u_in = (partition(e.u().canonical()) == curr_partition);
+            const bool v_in = (e.is_loop() ? u_in : partition(e.v().canonical()) == curr_partition);
+            const uint64_t h_u = (u_in ? hash_table->bucket_id(e.u().canonical()) : 0);
+            e.set_hashes(h_u, v_in ? (e.is_loop() ? h_u : hash_table->bucket_id(e.v().canonical())) : 0);
+
+            if(e.is_loop())
+            {
+                if(e.u().side() != e.v().side())    // It is a crossing loop.
+                    while(!cdbg_constructor.add_crossing_loop(e.u()));
+                else    // A one-sided loop.
+                    while(!cdbg_constructor.add_one_sided_loop(e.u()));
+            }
+            else
+            {
+                if(u_in)
+                    while(!cdbg_constructor.add_incident_edge(e.u()));
+
+                if(v_in)
+                    while(!cdbg_constructor.add_incident_edge(e.v()));
+            }
+        }
+}
+
+
+template <uint16_t k>
+void Partitioned_CdBG<k>::extract_fragments()
+{
+    const uint16_t thread_count = params.thread_count();
+    Kmer_Bucket_Iterator<k> vertex_parser(bucket_path(cuttlefish::file_ext::vertex_bucket_ext, curr_partition), vertex_bucket_size[curr_partition], thread_count);
+    outputted.resize(vertex_bucket_size[curr_partition]);
+
+    vertex_parser.launch_production();
+
+    std::vector<std::unique_ptr<std::thread>> T(thread_count);
+    for(uint16_t thread_id = 0; thread_id < thread_count; ++thread_id)
+        T[thread_id].reset(
+            new std::thread(&Partitioned_CdBG::process_vertices, this, std::ref(vertex_parser), thread_id)
+        );
+
+    for(uint16_t thread_id = 0; thread_id < thread_count; ++thread_id)
+        T[thread_id]->join();
+
+    outputted.resize(0);
+}
+
+
+template <uint16_t k>
+void Partitioned_CdBG<k>::process_vertices(Kmer_Bucket_Iterator<k>& vertex_parser, const uint16_t thread_id)
+{
+#ifdef CF_PERF_COUNTERS
+    const Perf_Thread_Scope perf_scope("vertex thread " + std::to_string(thread_id));
+#endif
+
+    Kmer<k> v_hat;  // The vertex copy to be scanned one-by-one.
+    Maximal_Unitig_Scratch<k> fragment; // The scratch space to be used to construct the containing fragment of `v_hat`.
+    char ext_back, ext_front;   // The bases extending the fragment out of the partition.
+    std::string record; // Scratch space for the textual record of a crossing fragment.
+    std::vector<uint64_t> path_hashes;  // Scratch space for the hashes of the fragment vertices to be marked.
+    uint64_t fragment_count = 0;    // Number of crossing fragments extracted by this thread.
+    Unipaths_Meta_info<k> extracted_unipaths_info;  // Meta-information over the maximal unitigs extracted by this thread.
+
+    Character_Buffer<BUFF_SZ, sink_t> output_buffer(output_sink.sink());   // The output buffer for maximal unitigs.
+    const Unitig_Sink& unitig_sink = params.unitig_sink();  // The caller's sink for the maximal unitigs, if any, in place of the output buffer.
+    Character_Buffer<BUFF_SZ, std::ofstream> fragment_buffer(fragment_sink.sink()); // The output buffer for crossing fragments.
+
+
+    while(vertex_parser.tasks_expected(thread_id))
+        if(vertex_parser.value_at(thread_id, v_hat))
+            if(extract_fragment(v_hat, fragment, ext_back, ext_front))
+            {
+                mark_fragment(fragment, path_hashes);
+
+                if(fragment.is_cycle() || (ext_back == 'N' && ext_front == 'N'))  // The fragment is a complete maximal unitig.
+                {
+                    fragment.finalize(curr_id_offset);
+                    extracted_unipaths_info.add_maximal_unitig(fragment);
+                    if(unitig_sink)
+                        unitig_sink(fragment.view(), thread_id);
+                    else
+                        fragment.add_fasta_rec_to_buffer(output_buffer);
+                }
+                else
+                {
+                    record.clear();
+                    append_fragment_record(fragment, curr_id_offset + fragment.sign_vertex().hash(), ext_back, ext_front, record);
+                    fragment_buffer += record;
+                    fragment_count++;
+                }
+            }
+
+
+    lock.lock();
+    this->fragment_count += fragment_count;
+    unipaths_meta_info_.aggregate(extracted_unipaths_info);
+    lock.unlock();
+}
+
+
+template <uint16_t k>
+void Partitioned_CdBG<k>::append_fragment_record(Maximal_Unitig_Scratch<k>& fragment, const uint64_t id, const char ext_back, const char ext_front, std::string& record)
+{
+    // The label of the fragment is the reverse complement of its front-walk followed by its back-walk.
+    const std::vector<char>& label_front = fragment.unitig(cuttlefish::side_t::front).label();
+    const std::vector<char>& label_back = fragment.unitig(cuttlefish::side_t::back).label();
+
+    record += std::to_string(id);
+    record += ' ';
+    record += (ext_front == 'N' ? 'N' : DNA_Utility::complement(ext_front));
+    record += ' ';
+    record += ext_back;
+    record += ' ';
+
+    for(auto it = label_front.rbegin(); it != label_front.rend(); ++it)
+        record += DNA_Utility::complement(*it);
+    record.append(label_back.begin() + k, label_back.end());
+    record += '\n';
+}
+
+
+template <uint16_t k>
+const std::string Partitioned_CdBG<k>::fragments_path() const
+{
+    return params.working_dir_path() + filename(params.output_prefix()) + cuttlefish::file_ext::fragments_ext;
+}
+
+
+template <uint16_t k>
+const std::string Partitioned_CdBG<k>::fragment_ends_path(const std::size_t r) const
+{
+    return params.working_dir_path() + filename(params.output_prefix()) + cuttlefish::file_ext::fragment_ends_ext + "." + std::to_string(r);
+}
+
+
+template <uint16_t k>
+void Partitioned_CdBG<k>::scan_fragments(std::vector<Fragment>& fragment, std::size_t& run_count) const
+{
+    static constexpr cuttlefish::side_t back = cuttlefish::side_t::back;
+    static constexpr cuttlefish::side_t front = cuttlefish::side_t::front;
+    static constexpr std::size_t run_end_count = END_RUN_SZ / sizeof(Fragment_End);
+
+    std::ifstream input(fragments_path());
+    fragment.clear();
+    fragment.reserve(fragment_count);
+    run_count = 0;
+
+    std::vector<Fragment_End> frag_end;   // The current run of the fragment ends.
+    frag_end.reserve(std::min(run_end_count, 2 * fragment_count));
+
+    // Sorts the current run of the fragment ends and writes it to disk.
+    const auto flush_run =
+        [&]()
+        {
+            std::sort(frag_end.begin(), frag_end.end());
+
+            const std::string run_path = fragment_ends_path(run_count++);
+            std::FILE* const run = std::fopen(run_path.c_str(), "wb");
+            if(run == nullptr || std::fwrite(frag_end.data(), sizeof(Fragment_End), frag_end.size(), run) != frag_end.size() || std::fclose(run) != 0)
+            {
+                std::cerr << "Error writing the fragment ends to " << run_path << ". Aborting.\n";
+                std::exit(EXIT_FAILURE);
+            }
+
+            frag_end.clear();
+        };
+
+
+    Fragment frag;
+    std::string label;  // Label of the fragment being scanned; only one is held at a time.
+    std::string e_label;
+    while(input >> frag.id >> frag.l >> frag.r)
+    {
+        input.get();    // The separator before the label.
+        frag.offset = static_cast<uint64_t>(input.tellg());
+        if(!std::getline(input, label) || label.size() < k)
+            break;
+
+        frag.len = label.size();
+        const uint64_t i = fragment.size();
+        fragment.push_back(frag);
+
+        // Collect the open ends of the fragment, keyed by their crossing edges.
+        if(frag.l != 'N')
+        {
+            e_label.assign(1, frag.l);
+            e_label.append(label, 0, k);
+            frag_end.push_back({Kmer<k + 1>(e_label).canonical(), i, front});
+        }
+
+        if(frag.r != 'N')
+        {
+            e_label.assign(label, label.size() - k, k);
+            e_label += frag.r;
+            frag_end.push_back({Kmer<k + 1>(e_label).canonical(), i, back});
+        }
+
+        if(frag_end.size() + 2 > run_end_count)
+            flush_run();
+    }
+
+    if(input.bad() || fragment.size() != fragment_count)
+    {
+        std::cerr << "Error reading the unitig fragments from " << fragments_path() << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    if(!frag_end.empty())
+        flush_run();
+}
+
+
+template <uint16_t k>
+void Partitioned_CdBG<k>::pair_fragment_ends(const std::size_t run_count, std::vector<uint64_t>& partner) const
+{
+    static constexpr uint64_t no_partner = std::numeric_limits<uint64_t>::max();
+    static constexpr std::size_t buf_end_count = END_READ_BUF_SZ / sizeof(Fragment_End);
+
+    // A sorted run of the fragment ends, read piece-wise.
+    struct Run
+    {
+        std::FILE* file;
+        std::vector<Fragment_End> buf;
+        std::size_t pos;
+    };
+
+    std::vector<Run> run(run_count);
+    for(std::size_t r = 0; r < run_count; ++r)
+    {
+        run[r].file = std::fopen(fragment_ends_path(r).c_str(), "rb");
+        if(run[r].file == nullptr)
+        {
+            std::cerr << "Error opening the fragment ends at " << fragment_ends_path(r) << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        run[r].buf.resize(buf_end_count);
+        run[r].pos = buf_end_count;
+    }
+
+    // Moves the run `r` to its next end; returns `false` iff the run is exhausted.
+    const auto advance =
+        [&](Run& r)
+        {
+            if(++r.pos < r.buf.size())
+                return true;
+
+            r.buf.resize(buf_end_count);
+            r.buf.resize(std::fread(r.buf.data(), sizeof(Fragment_End), buf_end_count, r.file));
+            r.pos = 0;
+            return !r.buf.empty();
+        };
+
+    // Min-heap of the runs over their current ends.
+    const auto greater = [&](const std::size_t a, const std::size_t b){ return run[b].buf[run[b].pos] < run[a].buf[run[a].pos]; };
+    std::vector<std::size_t> heap;
+    for(std::size_t r = 0; r < run_count; ++r)
+    {
+        run[r].pos = buf_end_count - 1;
+        if(advance(run[r]))
+            heap.push_back(r);
+    }
+
+    std::make_heap(heap.begin(), heap.end(), greater);
+
+
+    // An end is partnered with the next one in the merged order iff they share their crossing edge.
+    const auto end_idx = [](const Fragment_End& end) { return 2 * end.frag_idx + (end.s == cuttlefish::side_t::back); };
+    partner.assign(2 * fragment_count, no_partner);
+    bool pending = false;   // Whether the last merged end is waiting for its partner.
+    Fragment_End last;
+    while(!heap.empty())
+    {
+        std::pop_heap(heap.begin(), heap.end(), greater);
+        Run& r = run[heap.back()];
+        const Fragment_End end = r.buf[r.pos];
+
+        if(pending && last.e == end.e)
+        {
+            partner[end_idx(last)] = end_idx(end);
+            partner[end_idx(end)] = end_idx(last);
+            pending = false;
+        }
+        else
+            last = end, pending = true;
+
+        if(advance(r))
+            std::push_heap(heap.begin(), heap.end(), greater);
+        else
+            heap.pop_back();
+    }
+
+    for(std::size_t r = 0; r < run_count; ++r)
+    {
+        if(std::ferror(run[r].file))
+        {
+            std::cerr << "Error reading the fragment ends at " << fragment_ends_path(r) << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        std::fclose(run[r].file);
+        remove_file(fragment_ends_path(r));
+    }
+}
+
+
+template <uint16_t k>
+void Partitioned_CdBG<k>::read_fragment_label(std::FILE* const input, const Fragment& frag, std::string& label) const
+{
+    label.resize(frag.len);
+    if(fseeko(input, static_cast<off_t>(frag.offset), SEEK_SET) != 0 || std::fread(label.data(), 1, frag.len, input) != frag.len)
+    {
+        std::cerr << "Error reading the unitig fragments from " << fragments_path() << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+
+template <uint16_t k>
+void Partitioned_CdBG<k>::append_fragment(const std::string& label, const bool fwd, std::string& unitig)
+{
+    const std::size_t skip = (unitig.empty() ? 0 : k - 1);
+
+    if(fwd)
+        unitig.append(label.begin() + skip, label.end());
+    else
+        for(auto it = label.rbegin() + skip; it != label.rend(); ++it)
+            unitig += DNA_Utility::complement(*it);
+}
+
+
+template <uint16_t k>
+std::size_t Partitioned_CdBG<k>::canonicalize_cycle(std::string& cycle)
+{
+    const std::size_t vertex_count = cycle.size() - (k - 1);
+
+    Kmer<k> kmer(cycle, 0);
+    Kmer<k> kmer_bar(kmer.reverse_complement());
+    Kmer<k> min_vertex = kmer.canonical();
+    std::size_t min_idx = 0;
+    bool min_fwd = (kmer < kmer_bar);   // Whether the minimum vertex is in its canonical form in `cycle`.
+    for(std::size_t idx = 1; idx < vertex_count; ++idx)
+    {
+        kmer.roll_to_next_kmer(cycle[idx + k - 1], kmer_bar);
+        const bool fwd = (kmer < kmer_bar);
+        const Kmer<k>& canonical = (fwd ? kmer : kmer_bar);
+        if(canonical < min_vertex)
+            min_vertex = canonical, min_idx = idx, min_fwd = fwd;
+    }
+
+    if(min_fwd)
+        return min_idx;
+
+    cuttlefish::reverse_complement(cycle);
+    return vertex_count - 1 - min_idx;
+}
+
+
+template <uint16_t k>
+void Partitioned_CdBG<k>::join_fragments()
+{
+    static constexpr uint64_t no_partner = std::numeric_limits<uint64_t>::max();
+
+    // Only fixed-size information per fragment is kept in memory: the labels stay on disk.
+    std::vector<Fragment> fragment;
+    std::size_t run_count;
+    scan_fragments(fragment, run_count);
+    const uint64_t n = fragment.size();
+
+    std::vector<uint64_t> partner;
+    pair_fragment_ends(run_count, partner);
+
+
+    std::FILE* const input = std::fopen(fragments_path().c_str(), "rb");
+    if(input == nullptr)
+    {
+        std::cerr << "Error opening the unitig fragments at " << fragments_path() << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    Character_Buffer<BUFF_SZ, sink_t> output_buffer(output_sink.sink());
+    const Unitig_Sink& unitig_sink = params.unitig_sink();
+    std::vector<bool> visited(n);
+    std::string label;  // Label of the fragment being joined.
+    std::string unitig;
+
+    // Walks the chain of fragments starting at fragment `i` in orientation `fwd`, into `unitig`.
+    const auto walk_chain =
+        [&](uint64_t i, bool fwd)
+        {
+            const uint64_t start = i;
+            unitig.clear();
+
+            while(true)
+            {
+                visited[i] = true;
+                read_fragment_label(input, fragment[i], label);
+                append_fragment(label, fwd, unitig);
+
+                const uint64_t next = partner[2 * i + fwd]; // Exit through the right end if in forward orientation.
+                if(next == no_partner || next / 2 == start)
+                    break;
+
+                i = next / 2;
+                fwd = (next % 2 == 0);  // Enter through the left end iff the next one is in forward orientation.
+            }
+        };
+
+
+    // Linear chains start at fragments having an open end without any partner.
+    for(uint64_t i = 0; i < n; ++i)
+        if(!visited[i] && (partner[2 * i] == no_partner || partner[2 * i + 1] == no_partner))
+        {
+            walk_chain(i, partner[2 * i] == no_partner);
+
+            // Put the maximal unitig in its canonical form.
+            const Kmer<k> first(unitig, 0);
+            const Kmer<k> last(unitig, unitig.size() - k);
+            if(!(first < last.reverse_complement()))
+                cuttlefish::reverse_complement(unitig);
+
+            unipaths_meta_info_.add_maximal_unitig(unitig.size() - (k - 1));
+            if(unitig_sink)
+                unitig_sink(Unitig_View{fragment[i].id, {unitig.data(), unitig.data()}, {unitig.size(), 0}, false}, 0);
+            else
+                output_buffer += FASTA_Record<std::string>(fragment[i].id, unitig);
+        }
+
+    // The remaining fragments form DCCs spanning multiple partitions.
+    for(uint64_t i = 0; i < n; ++i)
+        if(!visited[i])
+        {
+            walk_chain(i, true);
+
+            // The edge from the last vertex back to the first one is implicit, as with the DCCs
+            // inside a partition; and the cycle is rotated to its minimum vertex, as with those.
+            const std::size_t pivot = canonicalize_cycle(unitig);
+            const std::size_t vertex_count = unitig.size() - (k - 1);
+            unipaths_meta_info_.add_maximal_unitig(vertex_count);
+            unipaths_meta_info_.add_DCC(vertex_count);
+            if(unitig_sink)
+                unitig_sink(Unitig_View{fragment[i].id, {unitig.data() + pivot, unitig.data() + k - 1}, {unitig.size() - pivot, pivot}, true}, 0);
+            else
+                output_buffer.template rotate_append_cycle<k>(FASTA_Record<std::string>(fragment[i].id, unitig), pivot);
+        }
+
+    std::fclose(input);
+}
+
+
+template <uint16_t k>
+uint64_t Partitioned_CdBG<k>::vertex_count() const
+{
+    return vertex_count_;
+}
+
+
+template <uint16_t k>
+uint64_t Partitioned_CdBG<k>::edge_count() const
+{
+    return edge_count_;
+}
+
+
+template <uint16_t k>
+uint16_t Partitioned_CdBG<k>::partition_count() const
+{
+    return partition_count_;
+}
+
+
+template <uint16_t k>
+uint64_t Partitioned_CdBG<k>::max_partition_size() const
+{
+    return vertex_bucket_size.empty() ? 0 : *std::max_element(vertex_bucket_size.begin(), vertex_bucket_size.end());
+}
+
+
+template <uint16_t k>
+uint64_t Partitioned_CdBG<k>::crossing_fragment_count() const
+{
+    return fragment_count;
+}
+
+
+template <uint16_t k>
+std::size_t Partitioned_CdBG<k>::bucket_disk_usage() const
+{
+    uint64_t bucket_entries = 0;
+    for(uint16_t p = 0; p < partition_count_; ++p)
+        bucket_entries += edge_bucket_size[p];
+
+    return vertex_count_ * sizeof(Kmer<k>) + bucket_entries * sizeof(Kmer<k + 1>);
+}
+
+
+template <uint16_t k>
+const Unipaths_Meta_info<k>& Partitioned_CdBG<k>::unipaths_meta_info() const
+{
+    return unipaths_meta_info_;
+}
+
+
+template <uint16_t k>
+const std::vector<std::pair<std::string, Phase_Metrics>>& Partitioned_CdBG<k>::phase_metrics() const
+{
+    return phase_metrics_;
+}
+
+
+
+// Template instantiations for the required instances.
+ENUMERATE(INSTANCE_COUNT, INSTANTIATE, Partitioned_CdBG)
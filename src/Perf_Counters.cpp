@@ -0,0 +1,148 @@
+
+#ifdef CF_PERF_COUNTERS
+
+#include "Perf_Counters.hpp"
+#include "Spin_Lock.hpp"
+
+#include <cstring>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+
+const char* const Perf_Counters::event_name[EVENT_COUNT] =
+    {"cycles", "instructions", "LLC misses", "dTLB misses", "stalled cycles (front-end)", "stalled cycles (back-end)"};
+
+
+// Returns the `perf_event_open` type and configuration of the event with index `e`.
+static std::pair<uint32_t, uint64_t> event_config(const std::size_t e)
+{
+    constexpr uint64_t read_miss = (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+
+    switch(e)
+    {
+    case 0: return {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES};
+    case 1: return {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS};
+    case 2: return {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | read_miss};
+    case 3: return {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | read_miss};
+    case 4: return {PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_FRONTEND};
+    default: return {PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_BACKEND};
+    }
+}
+
+
+Perf_Counters::Perf_Counters(const bool inherit)
+{
+    for(std::size_t e = 0; e < EVENT_COUNT; ++e)
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = event_config(e).first;
+        attr.config = event_config(e).second;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.inherit = inherit;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        // The calling thread on any CPU. The events are opened separately, not as a group, as
+        // inherited groups can not be read on older kernels.
+        fd[e] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+}
+
+
+Perf_Counters::~Perf_Counters()
+{
+    for(const int f: fd)
+        if(f >= 0)
+            close(f);
+}
+
+
+Perf_Counters::counts_t Perf_Counters::read() const
+{
+    counts_t counts;
+    for(std::size_t e = 0; e < EVENT_COUNT; ++e)
+    {
+        uint64_t value[3];  // The count, the time enabled, and the time running.
+        if(fd[e] < 0 || ::read(fd[e], value, sizeof(value)) != sizeof(value))
+            counts[e] = -1;
+        else
+            counts[e] = (value[2] > 0 ? static_cast<double>(value[0]) * value[1] / value[2] : 0);
+    }
+
+    return counts;
+}
+
+
+nlohmann::ordered_json Perf_Counters::to_json(const counts_t& counts)
+{
+    nlohmann::ordered_json counters;
+    for(std::size_t e = 0; e < EVENT_COUNT; ++e)
+        counters[event_name[e]] = (counts[e] >= 0 ? nlohmann::ordered_json(static_cast<uint64_t>(counts[e])) : nlohmann::ordered_json());
+
+    const double cycles = counts[0], instructions = counts[1], llc_misses = counts[2];
+    if(cycles > 0 && instructions >= 0)
+        counters["instructions per cycle"] = instructions / cycles;
+    if(instructions > 0 && llc_misses >= 0)
+        counters["LLC misses per kilo-instruction"] = llc_misses * 1000 / instructions;
+
+    return counters;
+}
+
+
+// Counts of the threads recorded since the last collection, and the lock guarding those.
+static std::vector<std::pair<std::string, Perf_Counters::counts_t>> thread_counts;
+static Spin_Lock thread_counts_lock;
+
+
+Perf_Thread_Scope::Perf_Thread_Scope(const std::string& name):
+    name(name),
+    counters(false)
+{}
+
+
+Perf_Thread_Scope::~Perf_Thread_Scope()
+{
+    const Perf_Counters::counts_t counts = counters.read();
+
+    thread_counts_lock.lock();
+    thread_counts.emplace_back(name, counts);
+    thread_counts_lock.unlock();
+}
+
+
+nlohmann::ordered_json Perf_Thread_Scope::collect()
+{
+    // Threads with the same name, e.g. from repeated rounds of a phase, are summed up.
+    std::vector<std::pair<std::string, Perf_Counters::counts_t>> sum;
+
+    thread_counts_lock.lock();
+    for(const auto& t: thread_counts)
+    {
+        auto it = sum.begin();
+        while(it != sum.end() && it->first != t.first)
+            ++it;
+
+        if(it == sum.end())
+            sum.push_back(t);
+        else
+            for(std::size_t e = 0; e < Perf_Counters::EVENT_COUNT; ++e)
+                it->second[e] = (it->second[e] >= 0 && t.second[e] >= 0 ? it->second[e] + t.second[e] : -1);
+    }
+
+    thread_counts.clear();
+    thread_counts_lock.unlock();
+
+    nlohmann::ordered_json threads;
+    for(const auto& t: sum)
+        threads[t.first] = Perf_Counters::to_json(t.second);
+
+    return threads;
+}
+
+#endif
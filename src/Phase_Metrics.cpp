@@ -0,0 +1,76 @@
+
+#include "Phase_Metrics.hpp"
+#include "utility.hpp"
+#include "Memory_Budget.hpp"
+#ifdef CF_CONTENTION_STATS
+#include "Contention_Stats.hpp"
+#endif
+
+#include <sys/resource.h>
+
+
+bool Phase_Metrics::process_shared_ = false;
+
+
+Phase_Metrics::Phase_Metrics():
+    curr_rss_(0),
+    items_(0)
+{
+    // The memory freed in the earlier phases is returned to the OS first, so that the rise of the
+    // peak in this phase is due to its own memory only.
+    if(!process_shared_)
+        Memory_Budget::release();
+#ifdef CF_CONTENTION_STATS
+    Contention_Stats::collect();    // Discards the counts from before the phase.
+#endif
+#ifdef CF_PERF_COUNTERS
+    Perf_Thread_Scope::collect();   // Discards the counts from before the phase.
+    perf_counters.reset(new Perf_Counters(true));   // Counts the worker threads of the phase as well.
+#endif
+    start_ = end_ = sample();
+}
+
+
+Phase_Metrics::Sample Phase_Metrics::sample()
+{
+    Sample s;
+    s.wall = clock_t::now();
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    s.cpu = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+
+    process_io_bytes(s.bytes_read, s.bytes_written);
+    s.peak_rss = process_peak_memory();
+
+    return s;
+}
+
+
+void Phase_Metrics::end(const uint64_t items)
+{
+    end_ = sample();
+    curr_rss_ = process_curr_memory();
+    items_ = items;
+#ifdef CF_CONTENTION_STATS
+    contention_ = Contention_Stats::collect();
+#endif
+#ifdef CF_PERF_COUNTERS
+    // The workers of the phase have been joined by now, so their counts are all accumulated.
+    hw_counters_["total"] = Perf_Counters::to_json(perf_counters->read());
+    hw_counters_["threads"] = Perf_Thread_Scope::collect();
+    perf_counters.reset();
+#endif
+}
+
+
+double Phase_Metrics::wall_time() const
+{
+    return std::chrono::duration_cast<std::chrono::duration<double>>(end_.wall - start_.wall).count();
+}
+
+
+double Phase_Metrics::cpu_time() const
+{
+    return end_.cpu - start_.cpu;
+}
@@ -1,16 +1,215 @@
 
 #include "Progress_Tracker.hpp"
+#include "utility.hpp"
+#include "nlohmann/json.hpp"
+
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+
+std::string Progress_Tracker::status_path;
+double Progress_Tracker::report_interval = 1.0;
+std::atomic<uint32_t> Progress_Tracker::thread_slot_count{0};
+thread_local const uint32_t Progress_Tracker::thread_slot = thread_slot_count.fetch_add(1, std::memory_order_relaxed) % COUNTER_COUNT;
+
+
+Progress_Tracker::Progress_Tracker():
+    total_work_load(0),
+    work_chunk_threshold(0),
+    tracking(false)
+{}
+
+
+Progress_Tracker::~Progress_Tracker()
+{
+    finish();
+}
+
+
+void Progress_Tracker::set_status_sink(const std::string& path, const double interval)
+{
+    status_path = path;
+    report_interval = interval;
+}
 
 
 void Progress_Tracker::setup(uint64_t total_work_load, uint64_t work_chunk_threshold, const std::string& log_message)
 {
+    finish();
+
     this->total_work_load = total_work_load;
     this->work_chunk_threshold = work_chunk_threshold;
 
-    total_work_done = 0;
-    percent_work_done = 0;
+    for(std::size_t i = 0; i < COUNTER_COUNT; ++i)
+        work_done[i].work.store(0, std::memory_order_relaxed);
 
     this->log_message = log_message;
 
     std::cerr << "\n";
+
+    tracking = true;
+    reporter = std::thread(&Progress_Tracker::report, this);
+}
+
+
+void Progress_Tracker::finish()
+{
+    if(!tracking)
+        return;
+
+    tracking = false;
+    reporter.join();
+}
+
+
+uint64_t Progress_Tracker::work_done_sum() const
+{
+    uint64_t sum = 0;
+    for(std::size_t i = 0; i < COUNTER_COUNT; ++i)
+        sum += work_done[i].work.load(std::memory_order_relaxed);
+
+    return sum;
+}
+
+
+void Progress_Tracker::report()
+{
+    bool is_socket;
+    const int status_fd = open_status_sink(is_socket);
+
+    const clock_t::time_point t_start = clock_t::now();
+    clock_t::time_point t_last = t_start;
+    uint64_t work_last = 0;
+    uint64_t bytes_start, bytes_last, bytes_written;
+    process_io_bytes(bytes_start, bytes_written);
+    bytes_last = bytes_start;
+
+    constexpr auto poll_interval = std::chrono::milliseconds(50);   // Granularity of checking for the tracking's finish.
+    bool finished = false;
+    while(!finished)
+    {
+        // Sleep till the next report is due, or the tracking finishes.
+        const clock_t::time_point t_due = t_last + std::chrono::duration_cast<clock_t::duration>(std::chrono::duration<double>(report_interval));
+        while(tracking && clock_t::now() < t_due)
+            std::this_thread::sleep_for(poll_interval);
+
+        finished = !tracking;
+
+        const clock_t::time_point t_now = clock_t::now();
+        const uint64_t work = work_done_sum();
+        uint64_t bytes;
+        process_io_bytes(bytes, bytes_written);
+
+        const double interval = std::chrono::duration<double>(t_now - t_last).count();
+        const double elapsed = std::chrono::duration<double>(t_now - t_start).count();
+        const double work_rate = (interval > 0 ? (work - work_last) / interval : 0);
+        const double byte_rate = (interval > 0 ? (bytes - bytes_last) / interval : 0);
+        const double percent = (total_work_load > 0 ? std::min(100.0, (work * 100.0) / total_work_load) : 100.0);
+
+        // The remaining time is estimated from the average rate over the whole task, as the rate
+        // over the last interval fluctuates.
+        const double avg_rate = (elapsed > 0 ? work / elapsed : 0);
+        const double eta = (finished ? 0 :
+                            avg_rate > 0 ? (total_work_load > work ? total_work_load - work : 0) / avg_rate : -1);
+
+        std::ostringstream eta_str;
+        if(eta >= 0)
+        {
+            const uint64_t eta_s = static_cast<uint64_t>(std::round(eta));
+            eta_str << eta_s / 3600 << ":" << std::setfill('0') << std::setw(2) << (eta_s / 60) % 60 << ":" << std::setw(2) << eta_s % 60;
+        }
+        else
+            eta_str << "?";
+
+        std::cerr << std::fixed << std::setprecision(1)
+                    << "\r[" << log_message << "]\t" << percent << "%"
+                    << "\t" << work_rate / 1e6 << "M items/s"
+                    << "\t" << byte_rate / (1024 * 1024) << " MB/s"
+                    << "\tETA " << eta_str.str() << "      ";
+        std::cerr.unsetf(std::ios_base::floatfield);
+
+        if(status_fd >= 0)
+        {
+            nlohmann::ordered_json status;
+            status["time"] = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+            status["phase"] = log_message;
+            status["finished"] = finished;
+            status["work done"] = work;
+            status["total work"] = total_work_load;
+            status["percent"] = percent;
+            status["elapsed (s)"] = elapsed;
+            status["items/s"] = work_rate;
+            status["bytes/s"] = byte_rate;
+            status["ETA (s)"] = (eta >= 0 ? nlohmann::ordered_json(eta) : nlohmann::ordered_json());
+
+            write_status(status_fd, is_socket, status.dump() + "\n");
+        }
+
+        t_last = t_now, work_last = work, bytes_last = bytes;
+    }
+
+    if(status_fd >= 0)
+        close(status_fd);
+}
+
+
+int Progress_Tracker::open_status_sink(bool& is_socket)
+{
+    constexpr const char* socket_prefix = "unix:";
+    const std::size_t prefix_len = std::strlen(socket_prefix);
+
+    is_socket = false;
+    if(status_path.empty())
+        return -1;
+
+    int fd;
+    if(status_path.compare(0, prefix_len, socket_prefix) == 0)
+    {
+        is_socket = true;
+        const std::string socket_path = status_path.substr(prefix_len);
+
+        sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if(socket_path.length() >= sizeof(addr.sun_path))
+            fd = -1;
+        else if((fd = socket(AF_UNIX, SOCK_STREAM, 0)) >= 0)
+        {
+            std::strcpy(addr.sun_path, socket_path.c_str());
+            if(connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0)
+                close(fd), fd = -1;
+        }
+    }
+    else
+        fd = open(status_path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+
+    // The monitoring is auxiliary to the construction, so a failure to reach the sink is not fatal.
+    if(fd < 0)
+        std::cerr << "\nCould not open the status sink " << status_path << ". The progress will not be reported there.\n";
+
+    return fd;
+}
+
+
+void Progress_Tracker::write_status(const int fd, const bool is_socket, const std::string& line)
+{
+    std::size_t written = 0;
+    while(written < line.length())
+    {
+        // Writes to a socket closed by the monitor must not raise `SIGPIPE`.
+        const ssize_t count = (is_socket ?  send(fd, line.data() + written, line.length() - written, MSG_NOSIGNAL) :
+                                            write(fd, line.data() + written, line.length() - written));
+        if(count <= 0)
+            return;
+
+        written += count;
+    }
 }
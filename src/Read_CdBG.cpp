@@ -5,6 +5,10 @@
 #include "kmer_Enumeration_Stats.hpp"
 #include "Read_CdBG_Constructor.hpp"
 #include "Read_CdBG_Extractor.hpp"
+#include "Partitioned_CdBG.hpp"
+#include "Phase_Metrics.hpp"
+#include "Memory_Budget.hpp"
+#include "Kmer_DB_Cache.hpp"
 #include "kmc_runner.h"
 
 #include <limits>
@@ -16,7 +20,9 @@ Read_CdBG<k>::Read_CdBG(const Build_Params& params):
     logistics(this->params),
     hash_table(nullptr),
     dbg_info(params.json_file_path())
-{}
+{
+    Memory_Budget::setup(params);
+}
 
 
 template <uint16_t k>
@@ -37,7 +43,8 @@ template <uint16_t k>
  */
 void Read_CdBG<k>::construct()
 {
-    if(is_constructed())
+    // A build into a unitig sink always runs, as the sink has to be fed.
+    if(!params.unitig_sink() && is_constructed())
     {
         std::cout << "\nThe compacted de Bruijn graph has been constructed earlier. Check " << dbg_info.file_path() << " for results.\n";
         return;
@@ -46,7 +53,7 @@ void Read_CdBG<k>::construct()
 
     dbg_info.add_build_params(params);
 
-    std::chrono::high_resolution_clock::time_point t_start = std::chrono::high_resolution_clock::now();
+    Phase_Metrics edge_metrics; // Covers the vertex enumeration too in the develop mode.
 
 #ifdef CF_DEVELOP_MODE
 
@@ -72,24 +79,28 @@ void Read_CdBG<k>::construct()
         std::exit(EXIT_FAILURE);
     }
 
-    std::chrono::high_resolution_clock::time_point t_vertices = std::chrono::high_resolution_clock::now();
-    std::cout << "Enumerated the edge and the vertex set of the graph. Time taken = " << std::chrono::duration_cast<std::chrono::duration<double>>(t_vertices - t_start).count() << " seconds.\n";
+    edge_metrics.end(edge_count + vertex_count);
+    dbg_info.add_phase_metrics("edge and vertex enumeration", edge_metrics);
+    std::cout << "Enumerated the edge and the vertex set of the graph. Time taken = " << edge_metrics.wall_time() << " seconds.\n";
 #else
 
     std::cout << "\nEnumerating the edges of the de Bruijn graph.\n";
     kmer_Enumeration_Stats<k + 1> edge_stats = enumerate_edges();
     edge_stats.log_stats();
 
-    std::chrono::high_resolution_clock::time_point t_edges = std::chrono::high_resolution_clock::now();
-    std::cout << "Enumerated the edge set of the graph. Time taken = " << std::chrono::duration_cast<std::chrono::duration<double>>(t_edges - t_start).count() << " seconds.\n";
+    edge_metrics.end(edge_stats.counted_kmer_count());
+    dbg_info.add_phase_metrics("edge enumeration", edge_metrics);
+    std::cout << "Enumerated the edge set of the graph. Time taken = " << edge_metrics.wall_time() << " seconds.\n";
 
 
     std::cout << "\nEnumerating the vertices of the de Bruijn graph.\n";
+    Phase_Metrics vertex_metrics;
 //同函数,计算点集合
     kmer_Enumeration_Stats<k> vertex_stats = enumerate_vertices(edge_stats.max_memory());
 
-    std::chrono::high_resolution_clock::time_point t_vertices = std::chrono::high_resolution_clock::now();
-    std::cout << "Enumerated the vertex set of the graph. Time taken = " << std::chrono::duration_cast<std::chrono::duration<double>>(t_vertices - t_edges).count() << " seconds.\n";
+    vertex_metrics.end(vertex_stats.counted_kmer_count());
+    dbg_info.add_phase_metrics("vertex enumeration", vertex_metrics);
+    std::cout << "Enumerated the vertex set of the graph. Time taken = " << vertex_metrics.wall_time() << " seconds.\n";
 
     const uint64_t edge_count = edge_stats.counted_kmer_count();
     const uint64_t vertex_count = vertex_stats.counted_kmer_count();
@@ -98,15 +109,50 @@ void Read_CdBG<k>::construct()
     std::cout << "Number of vertices: " << vertex_count << ".\n";
 
 
+    if(params.partitioned())
+    {
+        std::cout << "\nConstructing the compacted graph over minimizer-partitions of the graph.\n";
+        Phase_Metrics partitioned_metrics;
+        [[maybe_unused]] const std::size_t bucket_disk = construct_partitioned(vertex_count);
+
+#ifdef CF_DEVELOP_MODE
+        if(params.edge_db_path().empty())
+#endif
+        Kmer_Container<k + 1>::remove(logistics.edge_db_path());
+
+#ifdef CF_DEVELOP_MODE
+        if(params.vertex_db_path().empty())
+#endif
+        if(!params.save_vertices())
+            Kmer_Container<k>::remove(logistics.vertex_db_path());
+
+        partitioned_metrics.end(vertex_count);
+        dbg_info.add_phase_metrics("partitioned construction", partitioned_metrics);
+        std::cout << "Constructed the compacted graph. Time taken = " << partitioned_metrics.wall_time() << " seconds.\n";
+
+#ifndef CF_DEVELOP_MODE
+        // The buckets co-exist with the edge and the vertex databases.
+        const std::size_t partitioned_disk = edge_stats.db_size() + vertex_stats.db_size() + bucket_disk;
+        const double max_disk = static_cast<double>(std::max(max_disk_usage(edge_stats, vertex_stats), partitioned_disk)) / (1024.0 * 1024.0 * 1024.0);
+        std::cout << "\nMaximum temporary disk-usage: " << max_disk << "GB.\n";
+#endif
+
+        return;
+    }
+
+
     std::cout << "\nConstructing the minimal perfect hash function (MPHF) over the vertex set.\n";
+    Phase_Metrics mphf_metrics;
     //猜测是构建MPHF的时候已经存储了数据,因为后续进行lookup的时候没有存储数据
     construct_hash_table(vertex_count);
 
-    std::chrono::high_resolution_clock::time_point t_mphf = std::chrono::high_resolution_clock::now();
-    std::cout << "Constructed the minimal perfect hash function for the vertices. Time taken = " << std::chrono::duration_cast<std::chrono::duration<double>>(t_mphf - t_vertices).count() << " seconds.\n";
+    mphf_metrics.end(vertex_count);
+    dbg_info.add_phase_metrics("MPHF construction", mphf_metrics);
+    std::cout << "Constructed the minimal perfect hash function for the vertices. Time taken = " << mphf_metrics.wall_time() << " seconds.\n";
 
 
     std::cout << "\nComputing the DFA states.\n";
+    Phase_Metrics dfa_metrics;
     compute_DFA_states();
 
 #ifdef CF_DEVELOP_MODE
@@ -115,11 +161,13 @@ void Read_CdBG<k>::construct()
     //这里是删除边的文件
     Kmer_Container<k + 1>::remove(logistics.edge_db_path());//删除边的pre和suf两个文件
     
-    std::chrono::high_resolution_clock::time_point t_dfa = std::chrono::high_resolution_clock::now();
-    std::cout << "Computed the states of the automata. Time taken = " << std::chrono::duration_cast<std::chrono::duration<double>>(t_dfa - t_mphf).count() << " seconds.\n";
+    dfa_metrics.end(edge_count);
+    dbg_info.add_phase_metrics("DFA states computation", dfa_metrics);
+    std::cout << "Computed the states of the automata. Time taken = " << dfa_metrics.wall_time() << " seconds.\n";
 
 
     std::cout << "\nExtracting " << (params.path_cover() ? "a maximal path cover" :  "the maximal unitigs") << ".\n";
+    Phase_Metrics extract_metrics;  // The extraction and the output are interleaved.
     extract_maximal_unitigs();
 
 #ifdef CF_DEVELOP_MODE
@@ -128,8 +176,9 @@ void Read_CdBG<k>::construct()
     if(!params.save_vertices())//删除顶点文件
         Kmer_Container<k>::remove(logistics.vertex_db_path());
 
-    std::chrono::high_resolution_clock::time_point t_extract = std::chrono::high_resolution_clock::now();
-    std::cout << "Extracted the paths. Time taken = " << std::chrono::duration_cast<std::chrono::duration<double>>(t_extract - t_dfa).count() << " seconds.\n";
+    extract_metrics.end(vertex_count);
+    dbg_info.add_phase_metrics("path extraction and output", extract_metrics);
+    std::cout << "Extracted the paths. Time taken = " << extract_metrics.wall_time() << " seconds.\n";
 
 #ifndef CF_DEVELOP_MODE
     const double max_disk = static_cast<double>(max_disk_usage(edge_stats, vertex_stats)) / (1024.0 * 1024.0 * 1024.0);
@@ -184,9 +233,15 @@ void Read_CdBG<k>::construct_hash_table(const uint64_t vertex_count, const bool
     }
     else
     {
-        std::size_t max_memory = std::max(process_peak_memory(), params.max_memory() * 1024U * 1024U * 1024U);
         const std::size_t parser_memory = Kmer_SPMC_Iterator<k>::memory(params.thread_count());
-        max_memory = (max_memory > parser_memory ? max_memory - parser_memory : 0);
+
+        // The vertex set is cached in memory for the passes over it by the MPHF construction and the
+        // extraction, if it fits alongside the smallest hash table. An MPHF to be loaded needs no pass.
+        const std::size_t table_min_memory = Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>::min_memory(vertex_count);
+        if(params.mph_file_path().empty() || !file_exists(params.mph_file_path()))
+            Kmer_DB_Cache::plan(logistics.vertex_db_path(), Memory_Budget::available(parser_memory + table_min_memory));
+
+        const std::size_t max_memory = Memory_Budget::available(parser_memory + Kmer_DB_Cache::planned_memory());
         // 得到哈希表智能指针
         hash_table =
 #ifdef CF_DEVELOP_MODE
@@ -197,7 +252,7 @@ void Read_CdBG<k>::construct_hash_table(const uint64_t vertex_count, const bool
                             std::make_unique<Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>>(logistics.vertex_db_path(), vertex_count, max_memory, std::numeric_limits<double>::max()));
 #endif
         // 构建哈希表
-        hash_table->construct(params.thread_count(), logistics.working_dir_path(), params.mph_file_path(), params.save_mph());
+        hash_table->construct(params.thread_count(), logistics.working_dir_path(), params.mph_file_path(), params.save_mph(), params.minimizer_layout());
     }
 }
 
@@ -236,6 +291,23 @@ void Read_CdBG<k>::extract_maximal_unitigs() {
   cdBg_extractor.extract_maximal_unitigs(logistics.vertex_db_path(),
                                          logistics.output_file_path());
   dbg_info.add_unipaths_info(cdBg_extractor);
+
+  Kmer_DB_Cache::clear(); // The extraction is the last pass over the vertex set.
+}
+
+
+template <uint16_t k>
+std::size_t Read_CdBG<k>::construct_partitioned(const uint64_t vertex_count)
+{
+    Partitioned_CdBG<k> cdbg(params);
+
+    cdbg.construct(logistics.edge_db_path(), logistics.vertex_db_path(), vertex_count, logistics.output_file_path());
+    dbg_info.add_basic_info(cdbg);
+    dbg_info.add_unipaths_info(cdbg);
+    for(const auto& phase: cdbg.phase_metrics())
+        dbg_info.add_phase_metrics("partitioned construction: " + phase.first, phase.second);
+
+    return cdbg.bucket_disk_usage();
 }
 
 template <uint16_t k>
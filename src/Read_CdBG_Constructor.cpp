@@ -5,7 +5,6 @@
 #include "Thread_Pool.hpp"
 
 
-
 template <uint16_t k>
 Read_CdBG_Constructor<k>::Read_CdBG_Constructor(const Build_Params& params, Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>& hash_table):
     params(params),
@@ -34,7 +33,8 @@ void Read_CdBG_Constructor<k>::compute_DFA_states(const std::string& edge_db_pat
     // 输入的桶文件路径是 data/output/ceil.cf_hb
     const std::string &buckets_file_path = params.buckets_file_path();
     std::cout << "输入的桶文件路径是 " << params.buckets_file_path() << ".\n";
-    if(!buckets_file_path.empty() && file_exists(buckets_file_path))    // The serialized hash table buckets, saved from some earlier execution, exists.
+    const bool buckets_saved = (!buckets_file_path.empty() && file_exists(buckets_file_path));
+    if(buckets_saved)   // The serialized hash table buckets, saved from some earlier execution, exists.
     {//检查有没有已经存储好的桶文件，如果存在，则直接加载
         std::cout <<    "Found the hash table buckets at file " << buckets_file_path << ".\n"
                         "Loading the buckets.\n";
@@ -59,7 +59,10 @@ void Read_CdBG_Constructor<k>::compute_DFA_states(const std::string& edge_db_pat
         // 计算每个线程应该处理的 edge_count_ 的百分数
         const uint64_t thread_load_percentile = static_cast<uint64_t>(std::round((edge_count_ / 100.0) / params.thread_count()));
         progress_tracker.setup(edge_count_, thread_load_percentile, "Computing DFA states");
-        distribute_states_computation(&edge_parser, thread_pool);
+        if(params.owner_computes() && !params.path_cover())
+            compute_states_owner_computes(edge_parser, thread_pool);
+        else
+            distribute_states_computation(&edge_parser, thread_pool);
 
         // Wait for the edges to be depleted from the database.
         // 等待数据库中的边缘耗尽。
@@ -67,7 +70,11 @@ void Read_CdBG_Constructor<k>::compute_DFA_states(const std::string& edge_db_pat
 
         // Wait for the consumer threads to finish parsing and processing the edges.
         thread_pool.close();
+        progress_tracker.finish();
+    }
 
+    if(!buckets_saved)
+    {
         std::cout << "\nNumber of processed edges: " << edges_processed << "\n";
 
 
@@ -128,6 +135,8 @@ void Read_CdBG_Constructor<k>::process_edges(Kmer_SPMC_Iterator<k + 1>* const ed
 {
     if(params.path_cover())
         process_path_cover_edges(edge_parser, thread_id);
+    else if(params.coalesce_edges())
+        process_cdbg_edges_coalesced(edge_parser, thread_id);
     else
         process_cdbg_edges(edge_parser, thread_id);
 }
@@ -146,7 +155,10 @@ void Read_CdBG_Constructor<k>::process_cdbg_edges(Kmer_SPMC_Iterator<k + 1>* con
 {
     // Data locations to be reused per each edge processed.
     // 每个处理的边都要重用的数据位置。
-    Edge<k> e;  // For the edges to be processed one-by-one.
+    // The edges are parsed and their endpoints hashed in batches, so that the MPHF lookups overlap.
+    std::vector<Edge<k>> batch(EDGE_BATCH_SZ);  // The batch of edges to be processed.
+    Kmer<k> endpoint[2 * EDGE_BATCH_SZ];    // Canonical k-mers of the endpoints of the edges in the batch.
+    uint64_t h[2 * EDGE_BATCH_SZ];  // Hashes of the endpoints of the edges in the batch.
 /*
     cuttlefish::edge_encoding_t e_front, e_back;    // Edges incident to the front and to the back of a vertex with a crossing loop.
     cuttlefish::edge_encoding_t e_u_old, e_u_new;   // Edges incident to some particular side of a vertex `u`, before and after the addition of a new edge.
@@ -157,12 +169,28 @@ void Read_CdBG_Constructor<k>::process_cdbg_edges(Kmer_SPMC_Iterator<k + 1>* con
     uint64_t progress = 0;  // Number of edges processed by the thread; is reset at reaching 1% of its approximate workload. 线程处理的边数;重置为其近似工作量的1%。
 
     //存在线程不是在 no_more
-    while (edge_parser->tasks_expected(thread_id))
-      //每次只读1个 kmer,如果当前线程读过的kmer = 所能读的最大kmer则 else
-        if(edge_parser->value_at(thread_id, e.e()))
+    while(edge_parser->tasks_expected(thread_id))
+    {
+        //每次只读1个 kmer,如果当前线程读过的kmer = 所能读的最大kmer则 else
+        std::size_t batch_size = 0;
+        while(batch_size < EDGE_BATCH_SZ && edge_parser->value_at(thread_id, batch[batch_size].e()))
         {
-            //这里基本是根据 边获取 prefix 和 suffix,获取prefix和suffix的canonical形式,然后存储在哈希表中
-            e.configure(hash_table);    // A new edge (k + 1)-mer has been parsed; set information for its two endpoints.
+            // A new edge (k + 1)-mer has been parsed; set information for its two endpoints, except for their hashes.
+            Edge<k>& e = batch[batch_size];
+            e.configure();
+            endpoint[2 * batch_size] = e.u().canonical(), endpoint[2 * batch_size + 1] = e.v().canonical();
+            batch_size++;
+        }
+
+        if(batch_size == 0)
+            continue;
+
+        hash_table.bucket_ids(endpoint, 2 * batch_size, h);
+
+        for(std::size_t i = 0; i < batch_size; ++i)
+        {
+            Edge<k>& e = batch[i];
+            e.set_hashes(h[2 * i], h[2 * i + 1]);
 
             if(e.is_loop())
                 if(e.u().side() != e.v().side())    // It is a crossing loop.
@@ -205,6 +233,7 @@ void Read_CdBG_Constructor<k>::process_cdbg_edges(Kmer_SPMC_Iterator<k + 1>* con
             if(progress_tracker.track_work(++progress))
                 progress = 0;
         }
+    }
 
     
     lock.lock();
@@ -213,6 +242,72 @@ void Read_CdBG_Constructor<k>::process_cdbg_edges(Kmer_SPMC_Iterator<k + 1>* con
 }
 
 
+template <uint16_t k>
+void Read_CdBG_Constructor<k>::process_cdbg_edges_coalesced(Kmer_SPMC_Iterator<k + 1>* const edge_parser, const uint16_t thread_id)
+{
+    Edge<k> e;  // For the edges to be processed one-by-one.
+
+    // The edge (k + 1)-mers are in sorted order in the database, so up-to four consecutive edges
+    // `xA`, `xC`, `xG`, and `xT` share their prefix vertex `x` — and also its side, as they are
+    // incident to the same k-mer form of it.
+    bool run_open = false;  // Whether a run of edges sharing their prefix vertex is pending.
+    uint64_t run_h = 0; // Hash of the prefix vertex of the pending run.
+    cuttlefish::side_t run_s = cuttlefish::side_t::front;   // Side of the prefix vertex incident to the pending run.
+    cuttlefish::edge_encoding_t run_e = cuttlefish::edge_encoding_t::E; // Merged encoding of the edges of the pending run.
+
+    uint64_t edge_count = 0;    // Number of edges processed by this thread.
+    uint64_t progress = 0;  // Number of edges processed by the thread; is reset at reaching 1% of its approximate workload.
+
+    while(edge_parser->tasks_expected(thread_id))
+        if(edge_parser->value_at(thread_id, e.e()))
+        {
+            bool same_prefix = false;
+            if(edge_count == 0)
+                e.configure(hash_table);
+            else
+                same_prefix = e.configure_reusing_prefix(hash_table);
+
+            if(run_open && !same_prefix)
+            {
+                while(!add_incident_edges(run_h, run_s, run_e));
+                run_open = false;
+            }
+
+            if(e.is_loop())
+                if(e.u().side() != e.v().side())    // It is a crossing loop.
+                    while(!add_crossing_loop(e.u()));
+                else    // A one-sided loop.
+                    while(!add_one_sided_loop(e.u()));
+            else    // It connects two endpoints `u` and `v` of two distinct vertex.
+            {
+                if(run_open)    // Once the run branches, the merged result is final.
+                    run_e = (run_e == e.u().edge() ? run_e : cuttlefish::edge_encoding_t::N);
+                else
+                {
+                    run_open = true;
+                    run_h = e.u().hash();
+                    run_s = e.u().side();
+                    run_e = e.u().edge();
+                }
+
+                while(!add_incident_edge(e.v()));
+            }
+
+            edge_count++;
+            if(progress_tracker.track_work(++progress))
+                progress = 0;
+        }
+
+    if(run_open)
+        while(!add_incident_edges(run_h, run_s, run_e));
+
+
+    lock.lock();
+    edges_processed += edge_count;
+    lock.unlock();
+}
+
+
 template <uint16_t k>
 void Read_CdBG_Constructor<k>::process_path_cover_edges(Kmer_SPMC_Iterator<k + 1>* const edge_parser, const uint16_t thread_id)
 {
@@ -244,6 +339,129 @@ void Read_CdBG_Constructor<k>::process_path_cover_edges(Kmer_SPMC_Iterator<k + 1
 }
 
 
+template <uint16_t k>
+void Read_CdBG_Constructor<k>::compute_states_owner_computes(Kmer_SPMC_Iterator<k + 1>& edge_parser, Thread_Pool<k>& thread_pool)
+{
+    const uint16_t thread_count = params.thread_count();
+
+    // The slices are aligned to 64 buckets, so that no two owners share a word of the state table.
+    slice_size = ((hash_table.size() + thread_count - 1) / thread_count + 63) / 64 * 64;
+    if(slice_size == 0)
+        slice_size = 64;
+
+    scatter_worker.clear();
+    scatter_worker.resize(thread_count);
+    for(auto& worker: scatter_worker)
+    {
+        worker.buf.resize(thread_count);
+        worker.edge_count = worker.progress = 0;
+        worker.exhausted = false;
+    }
+
+
+    bool edges_remaining = true;
+    while(edges_remaining)
+    {
+        // Waiting for the completion of a pass acts as the barrier between the two passes of a round.
+        for(uint16_t t_id = 0; t_id < thread_count; ++t_id)
+            thread_pool.assign_read_dBG_compaction_task(&edge_parser, t_id, scatter_pass);
+
+        thread_pool.wait_completion();
+
+        for(uint16_t t_id = 0; t_id < thread_count; ++t_id)
+            thread_pool.assign_read_dBG_compaction_task(&edge_parser, t_id, apply_pass);
+
+        thread_pool.wait_completion();
+
+        edges_remaining = false;
+        for(uint16_t t_id = 0; t_id < thread_count; ++t_id)
+            edges_remaining |= !scatter_worker[t_id].exhausted;
+    }
+
+
+    for(const auto& worker: scatter_worker)
+        edges_processed += worker.edge_count;
+
+    scatter_worker.clear();
+    scatter_worker.shrink_to_fit();
+}
+
+
+template <uint16_t k>
+void Read_CdBG_Constructor<k>::scatter_updates(Kmer_SPMC_Iterator<k + 1>& edge_parser, const uint16_t thread_id)
+{
+    Scatter_Worker& worker = scatter_worker[thread_id];
+    if(worker.exhausted)
+        return;
+
+    Edge<k> e;  // For the edges to be processed one-by-one.
+    uint64_t edge_count = 0;    // Number of edges processed by this thread in this round.
+
+    while(edge_count < ROUND_EDGE_COUNT)
+    {
+        if(!edge_parser.tasks_expected(thread_id))
+        {
+            worker.exhausted = true;
+            break;
+        }
+
+        if(edge_parser.value_at(thread_id, e.e()))
+        {
+            e.configure(hash_table);
+
+            if(e.is_loop())
+                if(e.u().side() != e.v().side())    // It is a crossing loop.
+                {
+                    add_update(thread_id, e.u().hash(), cuttlefish::side_t::front, cuttlefish::edge_encoding_t::N);
+                    add_update(thread_id, e.u().hash(), cuttlefish::side_t::back, cuttlefish::edge_encoding_t::N);
+                }
+                else    // A one-sided loop.
+                    add_update(thread_id, e.u().hash(), e.u().side(), cuttlefish::edge_encoding_t::N);
+            else    // It connects two endpoints `u` and `v` of two distinct vertex.
+            {
+                add_update(thread_id, e.u().hash(), e.u().side(), e.u().edge());
+                add_update(thread_id, e.v().hash(), e.v().side(), e.v().edge());
+            }
+
+            edge_count++;
+            if(progress_tracker.track_work(++worker.progress))
+                worker.progress = 0;
+        }
+    }
+
+    worker.edge_count += edge_count;
+}
+
+
+template <uint16_t k>
+void Read_CdBG_Constructor<k>::apply_updates(const uint16_t owner_id)
+{
+    for(auto& worker: scatter_worker)
+    {
+        std::vector<uint64_t>& buf = worker.buf[owner_id];
+
+        for(const uint64_t update: buf)
+        {
+            const uint64_t bucket_id = update >> 4;
+            const cuttlefish::side_t s = static_cast<cuttlefish::side_t>((update >> 3) & 1);
+            const cuttlefish::edge_encoding_t e = static_cast<cuttlefish::edge_encoding_t>(update & 0b111);
+
+            Kmer_Hash_Entry_API<cuttlefish::BITS_PER_READ_KMER> bucket = hash_table.at_exclusive(bucket_id);
+            State_Read_Space& state = bucket.get_state();
+            const cuttlefish::edge_encoding_t e_curr = state.edge_at(s);
+            const cuttlefish::edge_encoding_t e_new = transition(e_curr, e);    // The loops are encoded as `N`-updates.
+            if(e_new == e_curr)
+                continue;
+
+            state.update_edge_at(s, e_new);
+            hash_table.update_exclusive(bucket);
+        }
+
+        buf.clear();
+    }
+}
+
+
 template <uint16_t k>
 uint64_t Read_CdBG_Constructor<k>::vertex_count() const
 {
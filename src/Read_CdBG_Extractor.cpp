@@ -4,6 +4,12 @@
 #include "Kmer_SPMC_Iterator.hpp"
 #include "Character_Buffer.hpp"
 #include "Thread_Pool.hpp"
+#include "File_Extensions.hpp"
+#include "dBG_Utilities.hpp"
+#include "utility.hpp"
+
+#include <algorithm>
+#include <fstream>
 
 
 template <uint16_t k>
@@ -47,10 +53,28 @@ void Read_CdBG_Extractor<k>::extract_maximal_unitigs(const std::string& vertex_d
     //生产者线程开始
     vertex_parser.launch_production();
 
-    // Clear the output file and initialize the output sink.
+    // The DFA states are frozen from here on; only the output-flags of the vertices change.
+    outputted.resize(vertex_count());
+    path_buf.assign(thread_count, std::vector<uint64_t>());
+
+    // Clear the output file and initialize the output sink, unless the unitigs go to a sink of the caller.
     // 清空输出文件并初始化输出接收器。
-    clear_file(output_file_path);
-    init_output_sink(output_file_path);
+    if(!params.unitig_sink())
+    {
+        clear_file(output_file_path);
+        init_output_sink(output_file_path);
+
+        // The long walks are streamed only into the output file, through spills of the threads.
+        const std::string prefix = params.working_dir_path() + filename(params.output_prefix());
+        walk_spill.assign(thread_count, Walk_Spill());
+        for(uint16_t t_id = 0; t_id < thread_count; ++t_id)
+        {
+            const std::string suffix = "." + std::to_string(t_id);
+            walk_spill[t_id].label_path = prefix + cuttlefish::file_ext::long_walk_ext + suffix;
+            walk_spill[t_id].hash_path = prefix + cuttlefish::file_ext::long_walk_hash_ext + suffix;
+            walk_spill[t_id].unitigs_path = prefix + cuttlefish::file_ext::long_unitigs_ext + suffix;
+        }
+    }
 
     // Launch (multi-threaded) extraction of the maximal unitigs.
     // 启动(多线程)提取maximal unitigs。
@@ -60,16 +84,39 @@ void Read_CdBG_Extractor<k>::extract_maximal_unitigs(const std::string& vertex_d
     // total_work = vertex_count() * 2, 总工作量是vertex_count()*2
     progress_tracker.setup(vertex_count() * 2, thread_load_percentile,
                             params.path_cover() ? "Extracting maximal path cover" :  "Extracting maximal unitigs");
-    distribute_unipaths_extraction(&vertex_parser, thread_pool);
+    // The walks start only from the flanking vertices of the maximal unitigs, so that each vertex
+    // is mostly visited once.
+    distribute_unipaths_extraction(&vertex_parser, thread_pool, flanks_pass);
 
     // Wait for the vertices to be depleted from the database.
     vertex_parser.seize_production();
 
     // Wait for the consumer threads to finish parsing and processing edges.
+    thread_pool.wait_completion();
+    progress_tracker.finish();
+
+    // The vertices left are in the detached chordless cycles, which have no flanking vertex. These
+    // are extracted from their spilled candidate vertices.
+    if(vertices_marked < vertex_count())
+    {
+        progress_tracker.setup(vertex_count() - vertices_marked, thread_load_percentile, "Extracting the detached chordless cycles");
+        distribute_unipaths_extraction(nullptr, thread_pool, cycles_pass);
+
+        thread_pool.wait_completion();
+        progress_tracker.finish();
+    }
+
+    for(uint16_t t_id = 0; t_id < thread_count; ++t_id)
+        remove_file(cycle_candidates_path(t_id));
+
     thread_pool.close();
 
     // Close the output sink.
-    close_output_sink();
+    if(!params.unitig_sink())
+    {
+        close_output_sink();
+        append_streamed_unitigs(output_file_path);
+    }
 
     std::cout << "\nNumber of scanned vertices: " << vertices_scanned << ".\n";
     unipaths_meta_info_.print();
@@ -90,7 +137,7 @@ template <uint16_t k>
  * @param vertex_parser 顶点解析器指针
  * @param thread_pool 线程池引用
  */
-void Read_CdBG_Extractor<k>::distribute_unipaths_extraction(Kmer_SPMC_Iterator<k>* const vertex_parser, Thread_Pool<k>& thread_pool)
+void Read_CdBG_Extractor<k>::distribute_unipaths_extraction(Kmer_SPMC_Iterator<k>* const vertex_parser, Thread_Pool<k>& thread_pool, const uint8_t pass)
 {
     const uint16_t thread_count = params.thread_count();
 
@@ -98,7 +145,7 @@ void Read_CdBG_Extractor<k>::distribute_unipaths_extraction(Kmer_SPMC_Iterator<k
     {
         //在线程池里找到pending的线程，将任务分配给空闲线程
         const uint16_t idle_thread_id = thread_pool.get_idle_thread();
-        thread_pool.assign_read_dBG_compaction_task(vertex_parser, idle_thread_id);
+        thread_pool.assign_read_dBG_compaction_task(vertex_parser, idle_thread_id, pass);
     }
 }
 
@@ -117,7 +164,6 @@ void Read_CdBG_Extractor<k>::process_vertices(Kmer_SPMC_Iterator<k>* const verte
     // 每个线程进入相同函数,局部变量都是不同的,相当于创建副本
     // Data structures to be reused per each vertex scanned.
     // 每个扫描的顶点都重用数据结构。
-    Kmer<k> v_hat;  // The vertex copy to be scanned one-by-one.逐一扫描顶点副本。
     // 用于构建`v_hat`的最大单位的暂存空间。
     Maximal_Unitig_Scratch<k> maximal_unitig;  // The scratch space to be used to construct the containing maximal unitig of `v_hat`.
     // 此线程扫描的顶点数。
@@ -126,43 +172,329 @@ void Read_CdBG_Extractor<k>::process_vertices(Kmer_SPMC_Iterator<k>* const verte
     Unipaths_Meta_info<k> extracted_unipaths_info;  // Meta-information over the maximal unitigs extracted by this thread.
     // 线程扫描的顶点数;重置为其近似工作量的1%。
     uint64_t progress = 0;  // Number of vertices scanned by the thread; is reset at reaching 1% of its approximate workload.
+    uint64_t marked_count = 0;  // Number of vertices in the maximal unitigs extracted by this thread.
 
     Character_Buffer<BUFF_SZ, sink_t> output_buffer(output_sink.sink());  // The output buffer for maximal unitigs.
 
+    // The vertices are parsed and hashed in batches, so that their MPHF lookups overlap.
+    std::vector<Kmer<k>> batch(VERTEX_BATCH_SZ);    // The batch of vertices to be scanned.
+    uint64_t h[VERTEX_BATCH_SZ];    // Hashes of the vertices in the batch.
+
+    // The interior vertices with smaller hashes than their neighbors, spilled as candidates to walk
+    // the detached chordless cycles from.
+    std::vector<Cycle_Candidate> candidate_buf;
+    candidate_buf.reserve(CANDIDATE_BUF_SZ);
+    const std::string candidates_path = cycle_candidates_path(thread_id);
+    std::FILE* const candidates = std::fopen(candidates_path.c_str(), "wb");
+    if(candidates == nullptr)
+    {
+        std::cerr << "Error opening the cycle-candidates file " << candidates_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
 
-    while(vertex_parser->tasks_expected(thread_id))
-    //value_at: 读取一条kmer
-        if(vertex_parser->value_at(thread_id, v_hat))
+    const auto flush_candidates =
+        [&]()
         {
-            if(extract_maximal_unitig(v_hat, maximal_unitig))
+            if(std::fwrite(candidate_buf.data(), sizeof(Cycle_Candidate), candidate_buf.size(), candidates) != candidate_buf.size())
             {
-                //标记前向和后向的状态为已经输出
-                mark_maximal_unitig(maximal_unitig);
+                std::cerr << "Error writing to the cycle-candidates file " << candidates_path << ". Aborting.\n";
+                std::exit(EXIT_FAILURE);
+            }
 
-                extracted_unipaths_info.add_maximal_unitig(maximal_unitig);
-                // output_buffer += maximal_unitig.fasta_rec();
-                maximal_unitig.add_fasta_rec_to_buffer(output_buffer);
+            candidate_buf.clear();
+        };
 
-                if(progress_tracker.track_work(progress += maximal_unitig.size()))
-                    progress = 0;
+    Walk_Spill* const spill = (params.unitig_sink() ? nullptr : &walk_spill[thread_id]); // Spill for the long walks of the thread.
+    uint64_t h_nbr_min; // Smaller hash of the neighbors of an interior vertex.
+
+
+    while(vertex_parser->tasks_expected(thread_id))
+    {
+        //value_at: 读取一条kmer
+        std::size_t batch_size = 0;
+        while(batch_size < VERTEX_BATCH_SZ && vertex_parser->value_at(thread_id, batch[batch_size]))
+            batch_size++;
+
+        if(batch_size == 0)
+            continue;
+
+        hash_table.bucket_ids(batch.data(), batch_size, h);
+
+        for(std::size_t i = 0; i < batch_size; ++i)
+        {
+            if(!outputted.test(h[i]))
+            {
+                const State_Read_Space state = hash_table.at_exclusive(h[i]).state();
+                if(is_flanking_vertex(batch[i], state, h_nbr_min))
+                {
+                    if(extract_maximal_unitig(batch[i], h[i], maximal_unitig, spill))
+                    {
+                        output_maximal_unitig(maximal_unitig, thread_id, output_buffer, extracted_unipaths_info);
+                        marked_count += maximal_unitig.size();
+
+                        if(progress_tracker.track_work(progress += maximal_unitig.size()))
+                            progress = 0;
+                    }
+                }
+                else if(h[i] <= h_nbr_min)
+                {
+                    candidate_buf.push_back({batch[i], h[i]});
+                    if(candidate_buf.size() == CANDIDATE_BUF_SZ)
+                        flush_candidates();
+                }
             }
 
             vertex_count++;//每个线程各自统计顶点数
             if(progress_tracker.track_work(++progress))
                 progress = 0;
         }
+    }
+
+    flush_candidates();
+    if(std::fclose(candidates) != 0)
+    {
+        std::cerr << "Error closing the cycle-candidates file " << candidates_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
 
 
     // Aggregate the meta-information over the extracted maximal unitigs and the thread-executions.
     lock.lock();
 
     vertices_scanned += vertex_count;
+    vertices_marked += marked_count;
     unipaths_meta_info_.aggregate(extracted_unipaths_info);
 
     lock.unlock();
 }
 
 
+template <uint16_t k>
+void Read_CdBG_Extractor<k>::process_cycle_candidates(const uint16_t thread_id)
+{
+    Maximal_Unitig_Scratch<k> maximal_unitig;   // The scratch space to be used to construct the containing cycles of the candidates.
+    Unipaths_Meta_info<k> extracted_unipaths_info;  // Meta-information over the cycles extracted by this thread.
+    uint64_t progress = 0;  // Number of vertices in the cycles extracted by the thread; is reset at reaching 1% of its approximate workload.
+    uint64_t marked_count = 0;  // Number of vertices in the cycles extracted by this thread.
+
+    Character_Buffer<BUFF_SZ, sink_t> output_buffer(output_sink.sink());  // The output buffer for the cycles.
+
+    std::vector<Cycle_Candidate> candidate_buf(CANDIDATE_BUF_SZ);
+    const std::string candidates_path = cycle_candidates_path(thread_id);
+    std::FILE* const candidates = std::fopen(candidates_path.c_str(), "rb");
+    if(candidates == nullptr)
+    {
+        std::cerr << "Error opening the cycle-candidates file " << candidates_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    std::size_t count;
+    while((count = std::fread(candidate_buf.data(), sizeof(Cycle_Candidate), CANDIDATE_BUF_SZ, candidates)) > 0)
+        for(std::size_t i = 0; i < count; ++i)
+            if(!outputted.test(candidate_buf[i].h) && extract_maximal_unitig(candidate_buf[i].v_hat, candidate_buf[i].h, maximal_unitig))
+            {
+                output_maximal_unitig(maximal_unitig, thread_id, output_buffer, extracted_unipaths_info);
+                marked_count += maximal_unitig.size();
+
+                if(progress_tracker.track_work(progress += maximal_unitig.size()))
+                    progress = 0;
+            }
+
+    if(std::ferror(candidates))
+    {
+        std::cerr << "Error reading the cycle-candidates file " << candidates_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    std::fclose(candidates);
+
+
+    lock.lock();
+
+    vertices_marked += marked_count;
+    unipaths_meta_info_.aggregate(extracted_unipaths_info);
+
+    lock.unlock();
+}
+
+
+template <uint16_t k>
+const std::string Read_CdBG_Extractor<k>::cycle_candidates_path(const uint16_t thread_id) const
+{
+    return params.working_dir_path() + filename(params.output_prefix()) + cuttlefish::file_ext::cycle_candidates_ext + "." + std::to_string(thread_id);
+}
+
+
+template <uint16_t k>
+void Read_CdBG_Extractor<k>::output_maximal_unitig(const Maximal_Unitig_Scratch<k>& maximal_unitig, const uint16_t thread_id, Character_Buffer<BUFF_SZ, sink_t>& output_buffer, Unipaths_Meta_info<k>& info)
+{
+    mark_maximal_unitig(maximal_unitig, path_buf[thread_id]);
+    info.add_maximal_unitig(maximal_unitig);
+
+    // output_buffer += maximal_unitig.fasta_rec();
+    if(maximal_unitig.is_linear() && maximal_unitig.is_streamed())
+    {
+        mark_spilled_path(walk_spill[thread_id]);
+        write_streamed_unitig(maximal_unitig, walk_spill[thread_id]);
+    }
+    else if(params.unitig_sink())
+        params.unitig_sink()(maximal_unitig.view(), thread_id);
+    else
+        maximal_unitig.add_fasta_rec_to_buffer(output_buffer);
+}
+
+
+template <uint16_t k>
+void Read_CdBG_Extractor<k>::stream_chunk(Unitig_Scratch<k>& unitig, Walk_Spill& spill)
+{
+    if(spill.label == nullptr)
+    {
+        spill.label = std::fopen(spill.label_path.c_str(), "w+b");
+        spill.hash = std::fopen(spill.hash_path.c_str(), "w+b");
+        spill.unitigs = std::fopen(spill.unitigs_path.c_str(), "wb");
+        if(spill.label == nullptr || spill.hash == nullptr || spill.unitigs == nullptr)
+        {
+            std::cerr << "Error opening the temporary files for the long maximal unitigs at " << spill.label_path << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        spill.buf.reserve(STREAM_CHUNK_SZ);
+        spill.hash_buf.reserve(STREAM_CHUNK_SZ);
+    }
+
+    // The spill files are overwritten by each streamed walk.
+    if(!unitig.is_spilled())    // The first chunk of the walk.
+        spill.label_len = spill.hash_count = 0;
+
+    const std::vector<char>& label = unitig.label();
+    const std::vector<uint64_t>& hash = unitig.hash();
+    if(fseeko(spill.label, spill.label_len, SEEK_SET) != 0 ||
+        std::fwrite(label.data(), 1, label.size(), spill.label) != label.size() ||
+        fseeko(spill.hash, spill.hash_count * static_cast<off_t>(sizeof(uint64_t)), SEEK_SET) != 0 ||
+        std::fwrite(hash.data(), sizeof(uint64_t), hash.size(), spill.hash) != hash.size())
+    {
+        std::cerr << "Error writing to the spill files at " << spill.label_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    spill.label_len += label.size();
+    spill.hash_count += hash.size();
+    unitig.spill();
+}
+
+
+template <uint16_t k>
+void Read_CdBG_Extractor<k>::mark_spilled_path(Walk_Spill& spill)
+{
+    if(fseeko(spill.hash, 0, SEEK_SET) != 0)
+    {
+        std::cerr << "Error reading the spill file " << spill.hash_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    for(off_t pos = 0; pos < spill.hash_count; )
+    {
+        const std::size_t count = static_cast<std::size_t>(std::min(static_cast<off_t>(STREAM_CHUNK_SZ), spill.hash_count - pos));
+        spill.hash_buf.resize(count);
+        if(std::fread(spill.hash_buf.data(), sizeof(uint64_t), count, spill.hash) != count)
+        {
+            std::cerr << "Error reading the spill file " << spill.hash_path << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        mark_path(spill.hash_buf);
+        pos += count;
+    }
+}
+
+
+template <uint16_t k>
+void Read_CdBG_Extractor<k>::write_streamed_unitig(const Maximal_Unitig_Scratch<k>& maximal_unitig, Walk_Spill& spill)
+{
+    const std::vector<char>& tail = maximal_unitig.unitig(maximal_unitig.streamed_side()).label();  // The label of the walk retained in the scratch.
+    const std::string header = ">" + std::to_string(maximal_unitig.id()) + "\n";
+    std::vector<char>& buf = spill.buf;
+
+    bool ok = (std::fwrite(header.data(), 1, header.size(), spill.unitigs) == header.size());
+    if(maximal_unitig.is_streamed_canonical())
+    {
+        for(off_t pos = 0; ok && pos < spill.label_len; pos += STREAM_CHUNK_SZ)
+        {
+            const std::size_t len = static_cast<std::size_t>(std::min(static_cast<off_t>(STREAM_CHUNK_SZ), spill.label_len - pos));
+            buf.resize(len);
+            ok = (fseeko(spill.label, pos, SEEK_SET) == 0 &&
+                    std::fread(buf.data(), 1, len, spill.label) == len &&
+                    std::fwrite(buf.data(), 1, len, spill.unitigs) == len);
+        }
+
+        ok = ok && (std::fwrite(tail.data(), 1, tail.size(), spill.unitigs) == tail.size());
+    }
+    else    // The reverse complement of the label: of the tail first, and then of the spilled chunks, from the last.
+    {
+        if(!tail.empty())
+        {
+            buf.assign(tail.begin(), tail.end());
+            cuttlefish::reverse_complement(buf);
+            ok = ok && (std::fwrite(buf.data(), 1, buf.size(), spill.unitigs) == buf.size());
+        }
+
+        for(off_t end = spill.label_len; ok && end > 0; )
+        {
+            const std::size_t len = static_cast<std::size_t>(std::min(static_cast<off_t>(STREAM_CHUNK_SZ), end));
+            end -= len;
+
+            buf.resize(len);
+            ok = (fseeko(spill.label, end, SEEK_SET) == 0 &&
+                    std::fread(buf.data(), 1, len, spill.label) == len);
+            if(ok)
+            {
+                cuttlefish::reverse_complement(buf);
+                ok = (std::fwrite(buf.data(), 1, len, spill.unitigs) == len);
+            }
+        }
+    }
+
+    ok = ok && (std::fputc('\n', spill.unitigs) != EOF);
+    if(!ok)
+    {
+        std::cerr << "Error streaming a long maximal unitig to " << spill.unitigs_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+
+template <uint16_t k>
+void Read_CdBG_Extractor<k>::append_streamed_unitigs(const std::string& output_file_path)
+{
+    for(Walk_Spill& spill : walk_spill)
+    {
+        if(spill.label == nullptr)
+            continue;
+
+        std::fclose(spill.label);
+        std::fclose(spill.hash);
+        std::fclose(spill.unitigs);
+        spill.label = spill.hash = spill.unitigs = nullptr;
+        remove_file(spill.label_path);
+        remove_file(spill.hash_path);
+
+        std::ifstream input(spill.unitigs_path, std::ios::binary);
+        std::ofstream output(output_file_path, std::ios::binary | std::ios::app);
+        if(input.peek() != std::ifstream::traits_type::eof() && !(output << input.rdbuf()))
+        {
+            std::cerr << "Error appending the long maximal unitigs to the output file " << output_file_path << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        input.close();
+        output.close();
+        remove_file(spill.unitigs_path);
+    }
+
+    walk_spill.clear();
+}
+
+
 template <uint16_t k>
 /**
  * @brief 初始化输出接收器
@@ -0,0 +1,183 @@
+
+#include "Scaling_Bench.hpp"
+#include "Synthetic_Data.hpp"
+#include "Build_Params.hpp"
+#include "Read_CdBG.hpp"
+#include "Application.hpp"
+#include "File_Extensions.hpp"
+#include "Input_Defaults.hpp"
+#include "utility.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+
+Scaling_Bench::Scaling_Bench(const Config& config):
+    config(config)
+{}
+
+
+Scaling_Bench::~Scaling_Bench()
+{
+    for(const auto& p: reads_path)
+        remove_file(p.second);
+}
+
+
+const std::string& Scaling_Bench::reads_for(const uint64_t genome_len)
+{
+    const auto it = reads_path.find(genome_len);
+    if(it != reads_path.end())
+        return it->second;
+
+    const std::string path = config.working_dir_path + "/cf_bench_reads_" + std::to_string(genome_len) + ".fq";
+    std::cerr << "Simulating reads from a synthetic genome of length " << genome_len << ".\n";
+
+    // Each genome length gets its own deterministic stream, independent of the sweep order.
+    Synthetic_Data generator(config.seed ^ genome_len);
+    const std::string genome = generator.genome(genome_len, config.repeat_frac, config.repeat_len, config.repeat_family_count, config.repeat_divergence);
+    generator.write_reads(genome, config.read_len, config.coverage, config.error_rate, path);
+
+    return reads_path.emplace(genome_len, path).first->second;
+}
+
+
+nlohmann::ordered_json Scaling_Bench::run(const uint64_t genome_len, const uint16_t thread_count)
+{
+    const std::string& reads = reads_for(genome_len);
+    const std::string output_prefix = config.working_dir_path + "/cf_bench_" + std::to_string(genome_len) + "_" + std::to_string(thread_count);
+    const std::string log_path = output_prefix + ".log";
+
+    std::cerr << "Benchmarking genome length " << genome_len << " with " << thread_count << " thread(s).\n";
+
+    std::cout.flush();
+    const auto t_start = std::chrono::high_resolution_clock::now();
+    const pid_t pid = fork();
+    if(pid < 0)
+    {
+        std::cerr << "Error forking a benchmark run. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    // The construction runs in a child process so that its peak RSS is isolated from the other
+    // runs, and its logs are diverted into a file.
+    if(pid == 0)
+    {
+        const int log_fd = open(log_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(log_fd < 0 || dup2(log_fd, STDOUT_FILENO) < 0)
+            std::_Exit(EXIT_FAILURE);
+
+        const Build_Params params(  true, false,
+                                    std::vector<std::string>(1, reads), std::nullopt, std::nullopt,
+                                    config.k, config.cutoff, cuttlefish::_default::EMPTY, cuttlefish::_default::EMPTY,
+                                    thread_count, config.max_memory, true,
+                                    output_prefix, std::nullopt, false, false, config.working_dir_path,
+                                    false, false, false, false, false,
+                                    false, false, false
+#ifdef CF_DEVELOP_MODE
+                                    , cuttlefish::_default::GAMMA
+#endif
+                                );
+        if(!params.is_valid())
+            std::_Exit(EXIT_FAILURE);
+
+        Application<Read_CdBG>(params).execute();
+        std::exit(EXIT_SUCCESS);
+    }
+
+    int status;
+    struct rusage usage;
+    if(wait4(pid, &status, 0, &usage) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+    {
+        std::cerr << "Benchmark run for genome length " << genome_len << " with " << thread_count << " thread(s) failed. Check " << log_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    const auto t_end = std::chrono::high_resolution_clock::now();
+
+
+    nlohmann::ordered_json result;
+    result["genome length"] = genome_len;
+    result["threads"] = thread_count;
+    result["wall time (s)"] = std::chrono::duration_cast<std::chrono::duration<double>>(t_end - t_start).count();
+    result["user time (s)"] = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6;
+    result["system time (s)"] = usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+    result["peak RSS (MB)"] = usage.ru_maxrss / 1024.0;  // `ru_maxrss` is in KB on Linux.
+
+    const std::string json_path = output_prefix + cuttlefish::file_ext::json_ext;
+    std::ifstream input(json_path);
+    nlohmann::ordered_json dbg_info;
+    input >> dbg_info;
+    if(input.fail())
+    {
+        std::cerr << "Error loading the graph information from " << json_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    input.close();
+    result["phase metrics"] = dbg_info["phase metrics"];
+
+    remove_file(json_path);
+    remove_file(output_prefix + cuttlefish::file_ext::unipaths_ext);
+    remove_file(log_path);
+
+    return result;
+}
+
+
+nlohmann::ordered_json Scaling_Bench::execute()
+{
+    nlohmann::ordered_json report;
+    report["k"] = config.k;
+    report["repeat fraction"] = config.repeat_frac;
+    report["coverage"] = config.coverage;
+    report["error rate"] = config.error_rate;
+
+
+    // Strong scaling: fixed input size, increasing thread counts.
+    nlohmann::ordered_json strong = nlohmann::ordered_json::array();
+    for(const uint64_t genome_len: config.genome_lens)
+    {
+        double base_time = 0;
+        for(const uint16_t thread_count: config.thread_counts)
+        {
+            nlohmann::ordered_json result = run(genome_len, thread_count);
+            const double wall_time = result["wall time (s)"];
+            if(thread_count == config.thread_counts.front())
+                base_time = wall_time;
+
+            const double speedup = base_time / wall_time;
+            result["speedup"] = speedup;
+            result["efficiency"] = speedup * config.thread_counts.front() / thread_count;
+            strong.push_back(result);
+        }
+    }
+
+    report["strong scaling"] = strong;
+
+
+    // Weak scaling: input size proportional to the thread count.
+    nlohmann::ordered_json weak = nlohmann::ordered_json::array();
+    const uint64_t base_len = config.genome_lens.front();
+    double base_time = 0;
+    for(const uint16_t thread_count: config.thread_counts)
+    {
+        const uint64_t genome_len = base_len * thread_count / config.thread_counts.front();
+        nlohmann::ordered_json result = run(genome_len, thread_count);
+        const double wall_time = result["wall time (s)"];
+        if(thread_count == config.thread_counts.front())
+            base_time = wall_time;
+
+        result["efficiency"] = base_time / wall_time;
+        weak.push_back(result);
+    }
+
+    report["weak scaling"] = weak;
+
+    return report;
+}
@@ -0,0 +1,157 @@
+
+#include "Synthetic_Data.hpp"
+#include "DNA_Utility.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+
+Synthetic_Data::Synthetic_Data(const uint64_t seed):
+    rng(seed)
+{}
+
+
+char Synthetic_Data::random_base()
+{
+    static constexpr char base[] = {'A', 'C', 'G', 'T'};
+    return base[rng() & 3];
+}
+
+
+char Synthetic_Data::substitute(const char base)
+{
+    char sub;
+    while((sub = random_base()) == base);
+
+    return sub;
+}
+
+
+std::string Synthetic_Data::random_seq(const uint64_t len)
+{
+    std::string seq(len, 'N');
+    for(char& base: seq)
+        base = random_base();
+
+    return seq;
+}
+
+
+uint64_t Synthetic_Data::mutate(std::string& seq, const double rate)
+{
+    if(rate <= 0)
+        return 0;
+
+    std::bernoulli_distribution is_mutated(rate);
+    uint64_t sub_count = 0;
+    for(char& base: seq)
+        if(is_mutated(rng))
+            base = substitute(base),
+            sub_count++;
+
+    return sub_count;
+}
+
+
+std::string Synthetic_Data::genome(const uint64_t len, const double repeat_frac, const uint32_t repeat_len, const uint32_t repeat_family_count, const double repeat_divergence)
+{
+    const uint64_t copy_count = (repeat_len > 0 && repeat_family_count > 0 ?
+                                    static_cast<uint64_t>(repeat_frac * len) / repeat_len : 0);
+    const uint64_t unique_len = len - copy_count * repeat_len;
+
+    std::vector<std::string> unit(copy_count > 0 ? repeat_family_count : 0);
+    for(std::string& u: unit)
+        u = random_seq(repeat_len);
+
+    // The copies are inserted at random offsets of the unique sequence.
+    std::uniform_int_distribution<uint64_t> offset_dist(0, unique_len);
+    std::vector<uint64_t> offset(copy_count);
+    for(uint64_t& o: offset)
+        o = offset_dist(rng);
+
+    std::sort(offset.begin(), offset.end());
+
+
+    std::string g;
+    g.reserve(len);
+
+    uint64_t unique_pos = 0;
+    for(const uint64_t o: offset)
+    {
+        g += random_seq(o - unique_pos);
+        unique_pos = o;
+
+        std::string copy = unit[rng() % unit.size()];
+        mutate(copy, repeat_divergence);
+        g += copy;
+    }
+
+    g += random_seq(unique_len - unique_pos);
+
+    return g;
+}
+
+
+void Synthetic_Data::write_FASTA(const std::string& genome, const std::string& name, const std::string& file_path)
+{
+    std::ofstream output(file_path);
+
+    output << ">" << name << "\n";
+    for(std::size_t pos = 0; pos < genome.size(); pos += FASTA_LINE_LEN)
+        output.write(genome.data() + pos, std::min(FASTA_LINE_LEN, genome.size() - pos)),
+        output << "\n";
+
+    output.close();
+    if(output.fail())
+    {
+        std::cerr << "Error writing the synthetic genome to " << file_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+
+uint64_t Synthetic_Data::write_reads(const std::string& genome, const uint32_t read_len, const double coverage, const double error_rate, const std::string& file_path)
+{
+    if(read_len == 0 || genome.size() < read_len)
+    {
+        std::cerr << "Read length " << read_len << " is invalid for a genome of length " << genome.size() << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    const uint64_t read_count = static_cast<uint64_t>(coverage * genome.size() / read_len);
+    std::uniform_int_distribution<uint64_t> pos_dist(0, genome.size() - read_len);
+    std::bernoulli_distribution is_error(error_rate > 0 ? error_rate : 0);
+
+    std::ofstream output(file_path);
+    std::string read(read_len, 'N');
+    std::string qual(read_len, QUAL_CORRECT);
+
+    for(uint64_t i = 0; i < read_count; ++i)
+    {
+        const uint64_t pos = pos_dist(rng);
+        if(rng() & 1)
+            std::copy(genome.begin() + pos, genome.begin() + pos + read_len, read.begin());
+        else    // Sample from the reverse strand.
+            for(uint32_t j = 0; j < read_len; ++j)
+                read[j] = DNA_Utility::complement(genome[pos + read_len - 1 - j]);
+
+        std::fill(qual.begin(), qual.end(), QUAL_CORRECT);
+        for(uint32_t j = 0; j < read_len; ++j)
+            if(is_error(rng))
+                read[j] = substitute(read[j]),
+                qual[j] = QUAL_ERROR;
+
+        output << "@read_" << i << "\n" << read << "\n+\n" << qual << "\n";
+    }
+
+    output.close();
+    if(output.fail())
+    {
+        std::cerr << "Error writing the simulated reads to " << file_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    return read_count;
+}
@@ -5,7 +5,12 @@
 #include "Read_CdBG_Constructor.hpp"
 #include "Read_CdBG_Extractor.hpp"
 
+#include "Trace.hpp"
+
 #include <iostream>
+#ifdef CF_PERF_COUNTERS
+#include "Perf_Counters.hpp"
+#endif
 
 
 template <uint16_t k>
@@ -73,6 +78,10 @@ template <uint16_t k>
  */
 void Thread_Pool<k>::task(const uint16_t thread_id)
 {
+#ifdef CF_PERF_COUNTERS
+    const Perf_Thread_Scope perf_scope("pool thread " + std::to_string(thread_id));
+#endif
+
     while(true)
     {
         // Busy-wait for some task.
@@ -86,6 +95,8 @@ void Thread_Pool<k>::task(const uint16_t thread_id)
         // Some task is available for the thread number `thread_id`.
         if(task_status[thread_id] == Task_Status::available)
         {
+            const Trace_Span span(task_name());
+
             switch(task_type)
             {
             case Task_Type::classification:
@@ -113,9 +124,14 @@ void Thread_Pool<k>::task(const uint16_t thread_id)
             case Task_Type::compute_states_read_space:
                 {//线程池里所有线程任务都相同
                     const Read_dBG_Compaction_Params& params = read_dBG_compaction_params[thread_id];
-                    static_cast<Read_CdBG_Constructor<k> *>(dBG)->process_edges(
-                        static_cast<Kmer_SPMC_Iterator<k + 1> *>(params.parser),
-                        params.thread_id);
+                    Read_CdBG_Constructor<k>* const constructor = static_cast<Read_CdBG_Constructor<k>*>(dBG);
+                    Kmer_SPMC_Iterator<k + 1>* const edge_parser = static_cast<Kmer_SPMC_Iterator<k + 1>*>(params.parser);
+                    if(params.pass == Read_CdBG_Constructor<k>::scatter_pass)
+                        constructor->scatter_updates(*edge_parser, params.thread_id);
+                    else if(params.pass == Read_CdBG_Constructor<k>::apply_pass)
+                        constructor->apply_updates(params.thread_id);
+                    else
+                        constructor->process_edges(edge_parser, params.thread_id);
                     // 将 void* 类型的指针 dBG 转换为 Read_CdBG_Constructor<k>*
                     // 类型的指针。这种转换是显式的，编译器会检查转换是否安全。
                     // 在src/Read_CdBG_Constructor.cpp 调用函数时传入的是this指针,也就是转换是安全的
@@ -126,8 +142,11 @@ void Thread_Pool<k>::task(const uint16_t thread_id)
                 {
                     //取对应线程的参数
                     const Read_dBG_Compaction_Params& params = read_dBG_compaction_params[thread_id];
-                    static_cast<Read_CdBG_Extractor<k>*>(dBG)->
-                        process_vertices(static_cast<Kmer_SPMC_Iterator<k>*>(params.parser), params.thread_id);
+                    Read_CdBG_Extractor<k>* const extractor = static_cast<Read_CdBG_Extractor<k>*>(dBG);
+                    if(params.pass == Read_CdBG_Extractor<k>::flanks_pass)
+                        extractor->process_vertices(static_cast<Kmer_SPMC_Iterator<k>*>(params.parser), params.thread_id);
+                    else
+                        extractor->process_cycle_candidates(params.thread_id);
                 }
                 break;
             }
@@ -139,6 +158,23 @@ void Thread_Pool<k>::task(const uint16_t thread_id)
 }
 
 
+template <uint16_t k>
+const char* Thread_Pool<k>::task_name() const
+{
+    switch(task_type)
+    {
+    case Task_Type::classification: return "classification task";
+    case Task_Type::output_plain: return "plain output task";
+    case Task_Type::output_gfa: return "GFA output task";
+    case Task_Type::output_gfa_reduced: return "GFA-reduced output task";
+    case Task_Type::compute_states_read_space: return "DFA states task";
+    case Task_Type::extract_unipaths_read_space: return "unitig extraction task";
+    }
+
+    return "task";
+}
+
+
 template <uint16_t k>
 /**
  * @brief 获取空闲线程
@@ -197,10 +233,10 @@ template <uint16_t k>
  * @param parser 解析器指针
  * @param thread_id 线程ID
  */
-void Thread_Pool<k>::assign_read_dBG_compaction_task(void* const parser, const uint16_t thread_id)
+void Thread_Pool<k>::assign_read_dBG_compaction_task(void* const parser, const uint16_t thread_id, const uint8_t pass)
 {
     //给对应线程分配函数参数
-    read_dBG_compaction_params[thread_id] = Read_dBG_Compaction_Params(parser, thread_id);
+    read_dBG_compaction_params[thread_id] = Read_dBG_Compaction_Params(parser, thread_id, pass);
 
     assign_task(thread_id);
 }
@@ -0,0 +1,141 @@
+
+#include "Trace.hpp"
+#include "Spin_Lock.hpp"
+
+#include <chrono>
+#include <vector>
+#include <list>
+#include <algorithm>
+#include <limits>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+
+std::atomic<bool> Trace::enabled_{false};
+thread_local Trace::Ring_Holder Trace::ring_holder;
+std::vector<std::unique_ptr<Trace::Ring>> Trace::all_rings;
+std::vector<Trace::Ring*> Trace::free_rings;
+std::list<std::string> Trace::interned_names;
+Spin_Lock Trace::registry_lock;
+
+
+Trace::Ring_Holder::~Ring_Holder()
+{
+    if(ring != nullptr)
+    {
+        registry_lock.lock();
+        free_rings.push_back(ring);
+        registry_lock.unlock();
+    }
+}
+
+
+void Trace::enable()
+{
+    enabled_.store(true, std::memory_order_relaxed);
+}
+
+
+uint64_t Trace::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+Trace::Ring& Trace::ring()
+{
+    if(ring_holder.ring == nullptr)
+    {
+        registry_lock.lock();
+
+        if(!free_rings.empty())
+        {
+            ring_holder.ring = free_rings.back();
+            free_rings.pop_back();
+        }
+        else
+        {
+            all_rings.emplace_back(new Ring());
+            Ring& r = *all_rings.back();
+            r.id = static_cast<uint32_t>(all_rings.size() - 1);
+            r.span.reset(new Span[RING_CAPACITY]);
+            ring_holder.ring = &r;
+        }
+
+        registry_lock.unlock();
+    }
+
+    return *ring_holder.ring;
+}
+
+
+void Trace::record(const char* const name, const uint64_t begin, const uint64_t end)
+{
+    if(!enabled())
+        return;
+
+    Ring& r = ring();
+    const uint64_t head = r.head.load(std::memory_order_relaxed);
+    r.span[head & (RING_CAPACITY - 1)] = {name, begin, end};
+    r.head.store(head + 1, std::memory_order_release);
+}
+
+
+const char* Trace::intern(const std::string& name)
+{
+    registry_lock.lock();
+    const auto it = std::find(interned_names.begin(), interned_names.end(), name);
+    const char* const interned = (it != interned_names.end() ? it->c_str() : interned_names.emplace_back(name).c_str());
+    registry_lock.unlock();
+
+    return interned;
+}
+
+
+void Trace::dump(const std::string& file_path)
+{
+    std::ofstream output(file_path);
+
+    registry_lock.lock();
+
+    uint64_t epoch = std::numeric_limits<uint64_t>::max();
+    for(const auto& r: all_rings)
+    {
+        const uint64_t head = r->head.load(std::memory_order_acquire);
+        for(uint64_t i = (head > RING_CAPACITY ? head - RING_CAPACITY : 0); i < head; ++i)
+            epoch = std::min(epoch, r->span[i & (RING_CAPACITY - 1)].begin);
+    }
+
+    // The timestamps are in microseconds in the trace-event format.
+    output << std::fixed << std::setprecision(3);
+    output << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    bool first = true;
+    for(const auto& r: all_rings)
+    {
+        output << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << r->id
+                << ", \"args\": {\"name\": \"thread " << r->id << "\"}}";
+        first = false;
+
+        const uint64_t head = r->head.load(std::memory_order_acquire);
+        for(uint64_t i = (head > RING_CAPACITY ? head - RING_CAPACITY : 0); i < head; ++i)
+        {
+            const Span& s = r->span[i & (RING_CAPACITY - 1)];
+            output << ",\n{\"name\": \"" << s.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << r->id
+                    << ", \"ts\": " << (s.begin - epoch) / 1000.0 << ", \"dur\": " << (s.end - s.begin) / 1000.0 << "}";
+        }
+    }
+
+    output << "\n]}\n";
+
+    registry_lock.unlock();
+
+    output.close();
+    if(output.fail())
+    {
+        std::cerr << "Error writing the trace to " << file_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    std::cout << "\nThe timeline trace is written to " << file_path << ".\n";
+}
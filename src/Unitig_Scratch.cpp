@@ -3,7 +3,8 @@
 
 
 template <uint16_t k>
-Unitig_Scratch<k>::Unitig_Scratch()
+Unitig_Scratch<k>::Unitig_Scratch():
+    spilled_(0)
 {
     label_.reserve(BUFF_SZ + k - 1),
     hash_.reserve(BUFF_SZ);
@@ -24,8 +24,26 @@ void Validator<k>::build_mph_function()
         console->info("Loading the MPH function from file {}\n", mph_file_path);
         
         std::ifstream input(mph_file_path.c_str(), std::ifstream::in);
+
+        // The saved levels are only valid over the k-mer hashes they were built with.
+        uint64_t magic = 0;
+        uint32_t hash_scheme = 0;
+        uint16_t kmer_len = 0;
+        input.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+        input.read(reinterpret_cast<char*>(&hash_scheme), sizeof(hash_scheme));
+        input.read(reinterpret_cast<char*>(&kmer_len), sizeof(kmer_len));
+        if(!input || magic != mph_file_magic || hash_scheme != Kmer_Hasher<Kmer<k>::width_t::word_count>::scheme || kmer_len != k)
+        {
+            console->error("The MPH function at file {} was built over a different k-mer hash scheme or k-value. Remove it to have it rebuilt. Aborting.\n", mph_file_path);
+            std::exit(EXIT_FAILURE);
+        }
+
         mph = new mphf_t();
-        mph->load(input);
+        if(!mph->load(input))
+        {
+            console->error("The MPH function at file {} was saved in a newer, unsupported format. Aborting.\n", mph_file_path);
+            std::exit(EXIT_FAILURE);
+        }
         input.close();
         
         console->info("Loaded the MPH function into memory.\n");
@@ -46,6 +64,11 @@ void Validator<k>::build_mph_function()
         console->info("Saving the MPH function in file {}\n", mph_file_path);
 
         std::ofstream output(mph_file_path.c_str(), std::ofstream::out);
+        const uint32_t hash_scheme = Kmer_Hasher<Kmer<k>::width_t::word_count>::scheme;
+        const uint16_t kmer_len = k;
+        output.write(reinterpret_cast<const char*>(&mph_file_magic), sizeof(mph_file_magic));
+        output.write(reinterpret_cast<const char*>(&hash_scheme), sizeof(hash_scheme));
+        output.write(reinterpret_cast<const char*>(&kmer_len), sizeof(kmer_len));
         mph->save(output);
         output.close();
 
@@ -0,0 +1,470 @@
+
+#include "Kmer.hpp"
+#include "Kmer_Hasher.hpp"
+#include "Kmer_Hash_Table.hpp"
+#include "Kmer_Bucket_Iterator.hpp"
+#include "Kmer_Container.hpp"
+#include "Kmer_SPMC_Iterator.hpp"
+#include "Directed_Vertex.hpp"
+#include "State_Read_Space.hpp"
+#include "Character_Buffer.hpp"
+#include "DNA_Utility.hpp"
+#include "utility.hpp"
+#include "globals.hpp"
+#include "kmc_api/kmc_file.h"
+#include "cxxopts/cxxopts.hpp"
+#include "nlohmann/json.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <thread>
+#include <memory>
+#include <chrono>
+#include <random>
+#include <limits>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+
+// Microbenchmarks for the core kernels of the compacted de Bruijn graph construction. Each kernel
+// is timed for a fixed number of operations over a few repetitions, and the best repetition is
+// reported — as nanoseconds per operation, and bytes of data processed per operation — in JSON.
+
+
+// Parameters of a benchmark session.
+struct Bench_Params
+{
+    uint64_t kmer_count;    // Number of k-mers in the sets for the hash-based kernels.
+    uint16_t thread_count;  // Number of threads for the multi-threaded kernels.
+    std::string working_dir_path;   // Working directory for the temporary files.
+    std::string kmc_db_path;    // Optional KMC database for the parser throughput.
+    uint32_t repeat;    // Number of repetitions per kernel.
+};
+
+
+// Sink for the computed values, so that the timed computations are not optimized away.
+static volatile uint64_t sink;
+
+
+// Returns the best wall-time (in nanoseconds) among `repeat` executions of `f`.
+template <typename T_f_>
+double best_time_ns(const uint32_t repeat, T_f_&& f)
+{
+    double best = std::numeric_limits<double>::max();
+    for(uint32_t r = 0; r < repeat; ++r)
+    {
+        const auto t_start = std::chrono::steady_clock::now();
+        f();
+        const auto t_end = std::chrono::steady_clock::now();
+
+        best = std::min(best, std::chrono::duration<double, std::nano>(t_end - t_start).count());
+    }
+
+    return best;
+}
+
+
+// Adds the result of the kernel `kernel` for the k-value `k` with `threads` threads into the
+// report `report`, where `ops` operations took `time_ns` nanoseconds, processing `bytes_per_op`
+// bytes per operation.
+void add_result(nlohmann::ordered_json& report, const std::string& kernel, const uint16_t k, const uint16_t threads,
+                const uint64_t ops, const double time_ns, const double bytes_per_op)
+{
+    nlohmann::ordered_json result;
+    result["kernel"] = kernel;
+    result["k"] = k;
+    result["threads"] = threads;
+    result["ops"] = ops;
+    result["ns/op"] = time_ns / ops;
+    result["bytes/op"] = bytes_per_op;
+
+    std::cerr << kernel << " (k = " << k << ", threads = " << threads << "): " << time_ns / ops << " ns/op.\n";
+    report.push_back(result);
+}
+
+
+// Returns a random DNA sequence of length `len`, generated from the generator `rng`.
+std::string random_seq(const std::size_t len, std::mt19937_64& rng)
+{
+    static constexpr char base[] = {'A', 'C', 'G', 'T'};
+
+    std::string seq(len, 'N');
+    for(std::size_t i = 0; i < len; ++i)
+        seq[i] = base[rng() & 3];
+
+    return seq;
+}
+
+
+// Returns the length of the k-mers in the KMC database at path `kmc_db_path`.
+uint32_t kmc_db_kmer_length(const std::string& kmc_db_path)
+{
+    CKMC_DB kmer_database;
+    CKMCFileInfo kmer_database_info;
+    if(!kmer_database.OpenForListing(kmc_db_path) || !kmer_database.Info(kmer_database_info))
+    {
+        std::cerr << "Error reading from the KMC database " << kmc_db_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    kmer_database.Close();
+    return kmer_database_info.kmer_length;
+}
+
+
+// Benchmarks the k-mer manipulation kernels for the k-value `k`.
+template <uint16_t k>
+void bench_kmer_ops(const Bench_Params& params, const std::string& seq, nlohmann::ordered_json& report)
+{
+    const uint64_t ops = seq.length() - k + 1;
+    std::vector<Kmer<k>> kmers;
+    kmers.reserve(ops);
+    for(std::size_t i = 0; i + k <= seq.length(); ++i)
+        kmers.emplace_back(seq, i);
+
+
+    // Rolling, along with the reverse complement.
+    const double roll_ns = best_time_ns(params.repeat,
+        [&]()
+        {
+            Kmer<k> kmer(seq, 0), kmer_bar(kmer.reverse_complement());
+            for(std::size_t i = k; i < seq.length(); ++i)
+                kmer.roll_to_next_kmer(seq[i], kmer_bar);
+
+            sink = (kmer < kmer_bar);
+        });
+    add_result(report, "kmer_roll", k, 1, ops - 1, roll_ns, 1);
+
+
+    const double rc_ns = best_time_ns(params.repeat,
+        [&]()
+        {
+            Kmer<k> kmer_bar;
+            uint64_t count = 0;
+            for(const auto& kmer: kmers)
+            {
+                kmer_bar.as_reverse_complement(kmer);
+                count += (kmer_bar < kmer);
+            }
+
+            sink = count;
+        });
+    add_result(report, "kmer_reverse_complement", k, 1, ops, rc_ns, sizeof(Kmer<k>));
+
+
+    const double canonical_ns = best_time_ns(params.repeat,
+        [&]()
+        {
+            uint64_t count = 0;
+            for(const auto& kmer: kmers)
+                count += (kmer.canonical() == kmer);
+
+            sink = count;
+        });
+    add_result(report, "kmer_canonical", k, 1, ops, canonical_ns, sizeof(Kmer<k>));
+
+
+    const Kmer_Hasher<Kmer<k>::width_t::word_count> hasher;
+    const double hash_ns = best_time_ns(params.repeat,
+        [&]()
+        {
+            uint64_t h = 0;
+            for(const auto& kmer: kmers)
+                h ^= hasher(kmer);
+
+            sink = h;
+        });
+    add_result(report, "kmer_hasher", k, 1, ops, hash_ns, sizeof(Kmer<k>));
+}
+
+
+// Benchmarks the hash table kernels for the k-value `k`, over the k-mers of the sequence `seq`.
+template <uint16_t k>
+void bench_hash_table(const Bench_Params& params, const std::string& seq, nlohmann::ordered_json& report)
+{
+    typedef Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER> hash_table_t;
+
+    // The distinct canonical k-mers of `seq` are dumped into a bucket, to build the table over.
+    std::vector<Kmer<k>> kmers;
+    kmers.reserve(seq.length() - k + 1);
+    for(std::size_t i = 0; i + k <= seq.length(); ++i)
+        kmers.emplace_back(Kmer<k>(seq, i).canonical());
+
+    std::sort(kmers.begin(), kmers.end());
+    kmers.erase(std::unique(kmers.begin(), kmers.end()), kmers.end());
+
+    const std::string bucket_path = params.working_dir_path + "/cf_bench." + std::to_string(k) + ".bucket";
+    std::FILE* const bucket = std::fopen(bucket_path.c_str(), "wb");
+    if(bucket == nullptr || std::fwrite(kmers.data(), sizeof(Kmer<k>), kmers.size(), bucket) != kmers.size() || std::fclose(bucket) != 0)
+    {
+        std::cerr << "Error writing the k-mer bucket " << bucket_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    const uint64_t n = kmers.size();
+    std::shuffle(kmers.begin(), kmers.end(), std::mt19937_64(k));
+
+
+    // Parsing throughput of the k-mer buckets.
+    const double bucket_ns = best_time_ns(params.repeat,
+        [&]()
+        {
+            Kmer_Bucket_Iterator<k> it(bucket_path, n, params.thread_count);
+            it.launch_production();
+
+            std::vector<std::unique_ptr<std::thread>> T(params.thread_count);
+            for(uint16_t t_id = 0; t_id < params.thread_count; ++t_id)
+                T[t_id].reset(new std::thread(
+                    [&it, t_id]()
+                    {
+                        Kmer<k> kmer;
+                        uint64_t count = 0;
+                        while(it.tasks_expected(t_id))
+                            count += it.value_at(t_id, kmer);
+
+                        sink = count;
+                    }));
+
+            for(auto& t: T)
+                t->join();
+        });
+    add_result(report, "kmer_bucket_iterator", k, params.thread_count, n, bucket_ns, sizeof(Kmer<k>));
+
+
+    hash_table_t hash_table(bucket_path, n);
+    hash_table.construct_over_bucket(params.thread_count, params.working_dir_path);
+    remove_file(bucket_path);
+
+
+    // BBHash lookups.
+    const double lookup_ns = best_time_ns(params.repeat,
+        [&]()
+        {
+            uint64_t h = 0;
+            for(const auto& kmer: kmers)
+                h ^= hash_table(kmer);
+
+            sink = h;
+        });
+    add_result(report, "bbhash_lookup", k, 1, n, lookup_ns, sizeof(Kmer<k>));
+
+
+    // Hash table updates, with `hot_set` buckets updated by all the threads: the full table
+    // for low contention, and a few buckets for high contention.
+    const auto bench_updates =
+        [&](const char* const kernel, const uint64_t hot_set, const bool tied)
+        {
+            const uint64_t ops_per_thread = n;
+            const double update_ns = best_time_ns(params.repeat,
+                [&]()
+                {
+                    std::vector<std::unique_ptr<std::thread>> T(params.thread_count);
+                    for(uint16_t t_id = 0; t_id < params.thread_count; ++t_id)
+                        T[t_id].reset(new std::thread(
+                            [&, t_id]()
+                            {
+                                std::mt19937_64 rng(t_id);
+                                for(uint64_t i = 0; i < ops_per_thread; ++i)
+                                {
+                                    const uint64_t b_1 = rng() % hot_set;
+                                    const cuttlefish::edge_encoding_t e = static_cast<cuttlefish::edge_encoding_t>(1 + (rng() & 3));
+
+                                    if(!tied)
+                                        while(true)
+                                        {
+                                            Kmer_Hash_Entry_API<cuttlefish::BITS_PER_READ_KMER> bucket = hash_table[b_1];
+                                            bucket.get_state().update_edge_at(cuttlefish::side_t::back, e);
+                                            if(hash_table.update(bucket))
+                                                break;
+                                        }
+                                    else
+                                    {
+                                        const uint64_t b_2 = (b_1 + 1) % hot_set;
+                                        while(true)
+                                        {
+                                            Kmer_Hash_Entry_API<cuttlefish::BITS_PER_READ_KMER> bucket_1 = hash_table[b_1];
+                                            Kmer_Hash_Entry_API<cuttlefish::BITS_PER_READ_KMER> bucket_2 = hash_table[b_2];
+                                            bucket_1.get_state().update_edge_at(cuttlefish::side_t::back, e);
+                                            bucket_2.get_state().update_edge_at(cuttlefish::side_t::front, e);
+                                            if(hash_table.update_concurrent(bucket_1, bucket_2))
+                                                break;
+                                        }
+                                    }
+                                }
+                            }));
+
+                    for(auto& t: T)
+                        t->join();
+                });
+
+            add_result(report, kernel, k, params.thread_count, ops_per_thread * params.thread_count, update_ns,
+                        (tied ? 2.0 : 1.0) * cuttlefish::BITS_PER_READ_KMER / 8);
+        };
+
+    bench_updates("hash_table_update", n, false);
+    bench_updates("hash_table_update_hot", std::min<uint64_t>(n, 64), false);
+    bench_updates("hash_table_update_concurrent", n, true);
+    bench_updates("hash_table_update_concurrent_hot", std::min<uint64_t>(n, 64), true);
+
+
+    // Unitig walks: the per-vertex step of `Read_CdBG_Extractor::walk_unitig` — rolling the
+    // vertex forward, hashing it, and reading its state — along the sequence.
+    const double walk_ns = best_time_ns(params.repeat,
+        [&]()
+        {
+            Directed_Vertex<k> v(Kmer<k>(seq, 0), hash_table);
+            uint64_t count = 0;
+            for(std::size_t i = k; i < seq.length(); ++i)
+            {
+                v.roll_forward(DNA_Utility::map_base(seq[i]), hash_table);
+                const State_Read_Space state = hash_table.at_exclusive(v.hash()).state();
+                count += static_cast<uint64_t>(state.edge_at(v.entrance_side()));
+            }
+
+            sink = count;
+        });
+    add_result(report, "unitig_walk_step", k, 1, seq.length() - k, walk_ns, 1);
+}
+
+
+// Benchmarks the parsing throughput of the KMC database at path `kmc_db_path` of k-mers.
+template <uint16_t k>
+void bench_spmc_iterator(const Bench_Params& params, nlohmann::ordered_json& report)
+{
+    const Kmer_Container<k> kmer_container(params.kmc_db_path);
+    const uint64_t n = kmer_container.size();
+
+    const double parse_ns = best_time_ns(params.repeat,
+        [&]()
+        {
+            Kmer_SPMC_Iterator<k> it(&kmer_container, params.thread_count);
+            it.launch_production();
+
+            std::vector<std::unique_ptr<std::thread>> T(params.thread_count);
+            for(uint16_t t_id = 0; t_id < params.thread_count; ++t_id)
+                T[t_id].reset(new std::thread(
+                    [&it, t_id]()
+                    {
+                        Kmer<k> kmer;
+                        uint64_t count = 0;
+                        while(it.tasks_expected(t_id))
+                            count += it.value_at(t_id, kmer);
+
+                        sink = count;
+                    }));
+
+            it.seize_production();
+            for(auto& t: T)
+                t->join();
+        });
+    add_result(report, "kmer_spmc_iterator", k, params.thread_count, n, parse_ns, sizeof(Kmer<k>));
+}
+
+
+// Benchmarks the appends of FASTA-sized records into character buffers.
+void bench_character_buffer(const Bench_Params& params, const std::string& seq, nlohmann::ordered_json& report)
+{
+    static constexpr std::size_t REC_LEN = 100;
+    const uint64_t ops = seq.length() / REC_LEN;
+
+    std::vector<std::string> rec;
+    rec.reserve(ops);
+    for(uint64_t i = 0; i < ops; ++i)
+        rec.emplace_back(seq.substr(i * REC_LEN, REC_LEN));
+
+    std::ofstream output("/dev/null");
+    const double append_ns = best_time_ns(params.repeat,
+        [&]()
+        {
+            Character_Buffer<100 * 1024ULL, std::ofstream> buffer(output);
+            for(const auto& r: rec)
+                buffer += r;
+        });
+    add_result(report, "character_buffer_append", 0, 1, ops, append_ns, REC_LEN);
+}
+
+
+// Runs all the k-specific benchmarks for the k-value `k`, if `k` is within the instantiated k-values.
+template <uint16_t k>
+void bench_k(const Bench_Params& params, const std::string& seq, const uint32_t kmc_k, nlohmann::ordered_json& report)
+{
+    if constexpr(cuttlefish::k_supported(k))
+    {
+        bench_kmer_ops<k>(params, seq, report);
+        bench_hash_table<k>(params, seq, report);
+
+        if(kmc_k == k)
+            bench_spmc_iterator<k>(params, report);
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    cxxopts::Options options("cf_bench", "Microbenchmarks for the core kernels of Cuttlefish");
+    options.add_options()
+        ("n,kmer-count", "number of k-mers per benchmarked set", cxxopts::value<uint64_t>()->default_value(std::to_string(1 << 20)))
+        ("t,threads", "number of threads for the multi-threaded kernels", cxxopts::value<uint16_t>()->default_value("4"))
+        ("r,repeat", "number of repetitions per kernel", cxxopts::value<uint32_t>()->default_value("5"))
+        ("w,work-dir", "working directory", cxxopts::value<std::string>()->default_value("."))
+        ("kmc-db", "KMC database to benchmark the parser with", cxxopts::value<std::string>()->default_value(""))
+        ("o,output", "output file for the JSON report (default: standard output)", cxxopts::value<std::string>()->default_value(""))
+        ("h,help", "print usage");
+
+    try
+    {
+        const auto result = options.parse(argc, argv);
+        if(result.count("help"))
+        {
+            std::cout << options.help() << std::endl;
+            return 0;
+        }
+
+        Bench_Params params;
+        params.kmer_count = result["kmer-count"].as<uint64_t>();
+        params.thread_count = std::max<uint16_t>(result["threads"].as<uint16_t>(), 1);
+        params.repeat = std::max<uint32_t>(result["repeat"].as<uint32_t>(), 1);
+        params.working_dir_path = result["work-dir"].as<std::string>();
+        params.kmc_db_path = result["kmc-db"].as<std::string>();
+        const std::string output_path = result["output"].as<std::string>();
+
+        const uint32_t kmc_k = (params.kmc_db_path.empty() ? 0 : kmc_db_kmer_length(params.kmc_db_path));
+
+        std::mt19937_64 rng(0);
+        const std::string seq = random_seq(params.kmer_count + cuttlefish::MAX_K, rng);
+
+        nlohmann::ordered_json report = nlohmann::ordered_json::array();
+        bench_character_buffer(params, seq, report);
+        bench_k<21>(params, seq, kmc_k, report);
+        bench_k<31>(params, seq, kmc_k, report);
+        bench_k<63>(params, seq, kmc_k, report);
+        bench_k<127>(params, seq, kmc_k, report);
+
+        if(output_path.empty())
+            std::cout << report.dump(4) << "\n";
+        else
+        {
+            std::ofstream output(output_path);
+            output << report.dump(4) << "\n";
+            if(output.fail())
+            {
+                std::cerr << "Error writing the benchmark report to " << output_path << ". Aborting.\n";
+                std::exit(EXIT_FAILURE);
+            }
+        }
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        std::cerr << "Error parsing the command line arguments. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+
+    return EXIT_SUCCESS;
+}
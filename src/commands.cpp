@@ -5,6 +5,11 @@
 #include "Build_Params.hpp"
 #include "Validation_Params.hpp"
 #include "Application.hpp"
+#include "Synthetic_Data.hpp"
+#include "Scaling_Bench.hpp"
+#include "Batch_Runner.hpp"
+#include "Trace.hpp"
+#include "Progress_Tracker.hpp"
 #include "version.hpp"
 #include "cxxopts/cxxopts.hpp"
 
@@ -12,12 +17,18 @@
 #include <vector>
 #include <iostream>
 #include <optional>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
   int cf_build(int argc, char** argv);
   int cf_validate(int argc, char** argv);
+  int cf_generate(int argc, char** argv);
+  int cf_bench(int argc, char** argv);
+  int cf_batch(int argc, char** argv);
 #ifdef __cplusplus
 }
 #endif
@@ -60,7 +71,11 @@ int cf_build(int argc, char** argv)
           std::to_string(cuttlefish::_default::MAX_MEMORY) + ")",
       cxxopts::value<std::optional<std::size_t>>(max_memory))(
       "unrestrict-memory",
-      "do not impose memory usage restriction")("h,help", "print usage");
+      "do not impose memory usage restriction")(
+      "status", "also report the progress as JSON lines into a file, or into a UNIX socket with a `unix:` prefix",
+      cxxopts::value<std::string>()->default_value(cuttlefish::_default::EMPTY))(
+      "status-interval", "interval between the progress reports in seconds",
+      cxxopts::value<double>()->default_value("1"))("h,help", "print usage");
 
   std::optional<uint32_t> cutoff;
   options.add_options("cuttlefish_2")(
@@ -72,7 +87,11 @@ int cf_build(int argc, char** argv)
           std::to_string(cuttlefish::_default::CUTOFF_FREQ_REFS) + ", reads: " +
           std::to_string(cuttlefish::_default::CUTOFF_FREQ_READS) + ")",
       cxxopts::value<std::optional<uint32_t>>(cutoff))(
-      "path-cover", "extract a maximal path cover of the de Bruijn graph");
+      "path-cover", "extract a maximal path cover of the de Bruijn graph")(
+      "partitioned", "construct out-of-core over minimizer-partitioned buckets, bounded by the memory limit")(
+      "minimizer-layout", "lay out the vertices sharing minimizers contiguously in the hash table, for cache-locality")(
+      "owner-computes", "compute the DFA states with each thread owning a slice of the hash table, without locks")(
+      "coalesce-edges", "coalesce the state updates of consecutive edges sharing their prefix vertex");
 
   std::optional<uint16_t> format_code;
   options.add_options("cuttlefish_1")(
@@ -93,6 +112,8 @@ int cf_build(int argc, char** argv)
       cxxopts::value<std::string>()->default_value(
           cuttlefish::_default::EMPTY))(
       "edge-set", "set of edges, i.e. (k + 1)-mers (KMC database) prefix",
+      cxxopts::value<std::string>()->default_value(cuttlefish::_default::EMPTY))(
+      "trace", "record a timeline of the threads into a Chrome trace-event JSON file",
       cxxopts::value<std::string>()->default_value(cuttlefish::_default::EMPTY))
 #ifdef CF_DEVELOP_MODE
       ("gamma", "gamma for the BBHash MPHF",
@@ -124,9 +145,16 @@ int cf_build(int argc, char** argv)
         const auto poly_n_stretch = result["poly-N-stretch"].as<bool>();
         const auto working_dir = result["work-dir"].as<std::string>();
         const auto path_cover = result["path-cover"].as<bool>();
+        const auto partitioned = result["partitioned"].as<bool>();
+        const auto minimizer_layout = result["minimizer-layout"].as<bool>();
+        const auto owner_computes = result["owner-computes"].as<bool>();
+        const auto coalesce_edges = result["coalesce-edges"].as<bool>();
         const auto save_mph = result["save-mph"].as<bool>();
         const auto save_buckets = result["save-buckets"].as<bool>();
         const auto save_vertices = result["save-vertices"].as<bool>();
+        const auto trace_file = result["trace"].as<std::string>();
+        const auto status_sink = result["status"].as<std::string>();
+        const auto status_interval = result["status-interval"].as<double>();
 #ifdef CF_DEVELOP_MODE
         const double gamma = result["gamma"].as<double>();
 #endif
@@ -135,7 +163,7 @@ int cf_build(int argc, char** argv)
                                     seqs, lists, dirs,
                                     k, cutoff, vertex_db, edge_db, thread_count, max_memory, strict_memory,
                                     output_file, format, track_short_seqs, poly_n_stretch, working_dir,
-                                    path_cover,
+                                    path_cover, partitioned, minimizer_layout, owner_computes, coalesce_edges,
                                     save_mph, save_buckets, save_vertices
 #ifdef CF_DEVELOP_MODE
                                     , gamma
@@ -154,9 +182,23 @@ int cf_build(int argc, char** argv)
 
         std::cout << "\nConstructing the compacted " << dBg_type << " de Bruijn graph for k = " << k << ".\n";
 
+        if(status_interval <= 0)
+        {
+            std::cerr << "The progress reporting interval must be positive. Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        Progress_Tracker::set_status_sink(status_sink, status_interval);
+
+        if(!trace_file.empty())
+            Trace::enable();
+
         (params.is_read_graph() || params.is_ref_graph()) ?
-            Application<cuttlefish::MAX_K, Read_CdBG>(params).execute() :
-            Application<cuttlefish::MAX_K, CdBG>(params).execute();
+            Application<Read_CdBG>(params).execute() :
+            Application<CdBG>(params).execute();
+
+        if(!trace_file.empty())
+            Trace::dump(trace_file);
 
         std::cout << "\nConstructed the " << dBg_type << " compacted de Bruijn graph at " << output_file << ".\n";
     }
@@ -224,7 +266,7 @@ int cf_validate(int argc, char** argv)
 
         std::cout << "\nValidating the compacted de Bruijn graph for k = " << k << "\n";
 
-        std::cout << (Application<cuttlefish::MAX_K, CdBG>(params).validate() ?
+        std::cout << (Application<CdBG>(params).validate() ?
                         "\nValidation successful" : "\nValidation failed") << std::endl;
     }
     catch(const std::exception& e)
@@ -237,3 +279,212 @@ int cf_validate(int argc, char** argv)
 }
 
 
+
+
+// Driver function for the synthetic data generation.
+int cf_generate(int argc, char** argv)
+{
+    cxxopts::Options options("cuttlefish generate", "Generate a random genome with tunable repeat content, and simulated reads from it");
+    options.add_options()
+        ("g,genome-len", "genome length", cxxopts::value<uint64_t>()->default_value("1000000"))
+        ("repeat-frac", "fraction of the genome made of repeats", cxxopts::value<double>()->default_value("0.1"))
+        ("repeat-len", "length of the repeat-units", cxxopts::value<uint32_t>()->default_value("300"))
+        ("repeat-families", "number of distinct repeat-units", cxxopts::value<uint32_t>()->default_value("16"))
+        ("divergence", "base-substitution rate of the repeat copies", cxxopts::value<double>()->default_value("0.02"))
+        ("c,coverage", "coverage of the simulated reads (0: no reads)", cxxopts::value<double>()->default_value("30"))
+        ("L,read-len", "length of the simulated reads", cxxopts::value<uint32_t>()->default_value("150"))
+        ("e,error-rate", "base-substitution error rate of the simulated reads", cxxopts::value<double>()->default_value("0.005"))
+        ("seed", "seed for the random generation", cxxopts::value<uint64_t>()->default_value("0"))
+        ("o,output", "output prefix; the genome goes to <prefix>.fa and the reads to <prefix>.fq", cxxopts::value<std::string>())
+        ("h,help", "print usage");
+
+    try
+    {
+        auto result = options.parse(argc, argv);
+        if(result.count("help"))
+        {
+            std::cout << options.help() << std::endl;
+            return 0;
+        }
+
+        const auto genome_len = result["genome-len"].as<uint64_t>();
+        const auto repeat_frac = result["repeat-frac"].as<double>();
+        const auto repeat_len = result["repeat-len"].as<uint32_t>();
+        const auto repeat_families = result["repeat-families"].as<uint32_t>();
+        const auto divergence = result["divergence"].as<double>();
+        const auto coverage = result["coverage"].as<double>();
+        const auto read_len = result["read-len"].as<uint32_t>();
+        const auto error_rate = result["error-rate"].as<double>();
+        const auto seed = result["seed"].as<uint64_t>();
+        const auto output_prefix = result["output"].as<std::string>();
+
+        if(repeat_frac < 0 || repeat_frac > 1)
+        {
+            std::cerr << "Repeat fraction must be in [0, 1]. Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        Synthetic_Data generator(seed);
+        const std::string genome = generator.genome(genome_len, repeat_frac, repeat_len, repeat_families, divergence);
+        Synthetic_Data::write_FASTA(genome, "synthetic_genome", output_prefix + ".fa");
+        std::cout << "Generated a genome of length " << genome.size() << " at " << output_prefix << ".fa.\n";
+
+        if(coverage > 0)
+        {
+            const uint64_t read_count = generator.write_reads(genome, read_len, coverage, error_rate, output_prefix + ".fq");
+            std::cout << "Simulated " << read_count << " reads at " << output_prefix << ".fq.\n";
+        }
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::cerr << std::endl << "Usage :" << std::endl;
+        std::cerr << options.help() << std::endl;
+    }
+    return 0;
+}
+
+
+// Driver function for the end-to-end scaling benchmark.
+int cf_bench(int argc, char** argv)
+{
+    cxxopts::Options options("cuttlefish bench", "Benchmark the strong and the weak scaling of the read de Bruijn graph compaction over synthetic data");
+    options.add_options()
+        ("k,kmer-len", "k-mer length", cxxopts::value<uint16_t>()->default_value(std::to_string(cuttlefish::_default::K)))
+        ("t,threads", "thread counts to sweep over", cxxopts::value<std::vector<uint16_t>>()->default_value("1,2,4,8"))
+        ("g,genome-lens", "genome lengths to sweep over; the first one is the base size for weak scaling", cxxopts::value<std::vector<uint64_t>>()->default_value("1000000"))
+        ("repeat-frac", "fraction of the genomes made of repeats", cxxopts::value<double>()->default_value("0.1"))
+        ("repeat-len", "length of the repeat-units", cxxopts::value<uint32_t>()->default_value("300"))
+        ("repeat-families", "number of distinct repeat-units", cxxopts::value<uint32_t>()->default_value("16"))
+        ("divergence", "base-substitution rate of the repeat copies", cxxopts::value<double>()->default_value("0.02"))
+        ("c,coverage", "coverage of the simulated reads", cxxopts::value<double>()->default_value("30"))
+        ("L,read-len", "length of the simulated reads", cxxopts::value<uint32_t>()->default_value("150"))
+        ("e,error-rate", "base-substitution error rate of the simulated reads", cxxopts::value<double>()->default_value("0.005"))
+        ("cutoff", "frequency cutoff for (k + 1)-mers", cxxopts::value<uint32_t>()->default_value(std::to_string(cuttlefish::_default::CUTOFF_FREQ_READS)))
+        ("m,max-memory", "soft maximum memory limit in GB", cxxopts::value<std::size_t>()->default_value(std::to_string(cuttlefish::_default::MAX_MEMORY)))
+        ("seed", "seed for the random generation", cxxopts::value<uint64_t>()->default_value("0"))
+        ("w,work-dir", "working directory", cxxopts::value<std::string>()->default_value(cuttlefish::_default::WORK_DIR))
+        ("o,output", "output JSON report file (default: standard output)", cxxopts::value<std::string>()->default_value(cuttlefish::_default::EMPTY))
+        ("h,help", "print usage");
+
+    try
+    {
+        auto result = options.parse(argc, argv);
+        if(result.count("help"))
+        {
+            std::cout << options.help() << std::endl;
+            return 0;
+        }
+
+        Scaling_Bench::Config config;
+        config.k = result["kmer-len"].as<uint16_t>();
+        config.thread_counts = result["threads"].as<std::vector<uint16_t>>();
+        config.genome_lens = result["genome-lens"].as<std::vector<uint64_t>>();
+        config.repeat_frac = result["repeat-frac"].as<double>();
+        config.repeat_len = result["repeat-len"].as<uint32_t>();
+        config.repeat_family_count = result["repeat-families"].as<uint32_t>();
+        config.repeat_divergence = result["divergence"].as<double>();
+        config.read_len = result["read-len"].as<uint32_t>();
+        config.coverage = result["coverage"].as<double>();
+        config.error_rate = result["error-rate"].as<double>();
+        config.cutoff = result["cutoff"].as<uint32_t>();
+        config.max_memory = result["max-memory"].as<std::size_t>();
+        config.seed = result["seed"].as<uint64_t>();
+        config.working_dir_path = result["work-dir"].as<std::string>();
+        const auto output_file = result["output"].as<std::string>();
+
+        if(config.thread_counts.empty() || config.genome_lens.empty())
+        {
+            std::cerr << "At least one thread count and one genome length are required. Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        if(std::find(config.thread_counts.cbegin(), config.thread_counts.cend(), 0) != config.thread_counts.cend())
+        {
+            std::cerr << "Thread counts must be positive. Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        if(config.repeat_frac < 0 || config.repeat_frac > 1)
+        {
+            std::cerr << "Repeat fraction must be in [0, 1]. Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        const nlohmann::ordered_json report = Scaling_Bench(config).execute();
+
+        if(output_file.empty())
+            std::cout << std::setw(4) << report << "\n";
+        else
+        {
+            std::ofstream output(output_file);
+            output << std::setw(4) << report << "\n";
+            output.close();
+            if(output.fail())
+            {
+                std::cerr << "Error writing the benchmark report to " << output_file << ". Aborting.\n";
+                std::exit(EXIT_FAILURE);
+            }
+
+            std::cout << "Benchmark report is written to " << output_file << ".\n";
+        }
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::cerr << std::endl << "Usage :" << std::endl;
+        std::cerr << options.help() << std::endl;
+    }
+    return 0;
+}
+
+
+// Driver function for the batch construction of many graphs.
+int cf_batch(int argc, char** argv)
+{
+    std::optional<std::size_t> max_memory;
+    cxxopts::Options options("cuttlefish batch", "Construct many independent compacted de Bruijn graphs in a single process, from a manifest of jobs");
+    options.add_options()
+        ("manifest", "manifest of the jobs; one job per line, as: <read | ref> <k> <output prefix> <input>[,<input>...] [<cutoff>]", cxxopts::value<std::string>())
+        ("t,threads", "budget of threads for the concurrent jobs", cxxopts::value<uint16_t>()->default_value(std::to_string(cuttlefish::_default::THREAD_COUNT)))
+        ("j,jobs", "maximum number of small jobs to run concurrently, with an even share of the threads each", cxxopts::value<uint16_t>()->default_value("1"))
+        ("large-input", "input size in MB from which a job is large, and runs alone with all the threads", cxxopts::value<std::size_t>()->default_value("1024"))
+        ("m,max-memory", "soft maximum memory limit in GB shared by the jobs (default: " + std::to_string(cuttlefish::_default::MAX_MEMORY) + ")", cxxopts::value<std::optional<std::size_t>>(max_memory))
+        ("unrestrict-memory", "do not impose memory usage restriction")
+        ("w,work-dir", "working directory", cxxopts::value<std::string>()->default_value(cuttlefish::_default::WORK_DIR))
+        ("h,help", "print usage");
+
+    try
+    {
+        auto result = options.parse(argc, argv);
+        if(result.count("help"))
+        {
+            std::cout << options.help() << std::endl;
+            return 0;
+        }
+
+        Batch_Runner::Config config;
+        config.manifest_path = result["manifest"].as<std::string>();
+        config.thread_count = result["threads"].as<uint16_t>();
+        config.job_count = result["jobs"].as<uint16_t>();
+        config.large_input = result["large-input"].as<std::size_t>() * 1024U * 1024U;
+        config.max_memory = max_memory;
+        config.strict_memory = !result["unrestrict-memory"].as<bool>();
+        config.working_dir_path = result["work-dir"].as<std::string>();
+
+        if(config.thread_count == 0 || config.job_count == 0)
+        {
+            std::cerr << "The thread and the job counts must be positive. Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        Batch_Runner(config).execute();
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::cerr << std::endl << "Usage :" << std::endl;
+        std::cerr << options.help() << std::endl;
+    }
+    return 0;
+}
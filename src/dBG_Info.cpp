@@ -2,12 +2,17 @@
 #include "dBG_Info.hpp"
 #include "Read_CdBG_Constructor.hpp"
 #include "Read_CdBG_Extractor.hpp"
+#include "Partitioned_CdBG.hpp"
 #include "CdBG.hpp"
 #include "Unipaths_Meta_info.hpp"
 #include "Build_Params.hpp"
+#include "Phase_Metrics.hpp"
+#include "Trace.hpp"
+#include "Memory_Budget.hpp"
 #include "utility.hpp"
 
 #include <iomanip>
+#include <chrono>
 #include <fstream>
 #include <iostream>
 
@@ -71,6 +76,18 @@ void dBG_Info<k>::add_basic_info(const CdBG<k>& cdbg)
 }
 
 
+template <uint16_t k>
+void dBG_Info<k>::add_basic_info(const Partitioned_CdBG<k>& cdbg)
+{
+    dBg_info[basic_field]["vertex count"] = cdbg.vertex_count();
+    dBg_info[basic_field]["edge count"] = cdbg.edge_count();
+
+    dBg_info[partitions_field]["partition count"] = cdbg.partition_count();
+    dBg_info[partitions_field]["max partition size"] = cdbg.max_partition_size();
+    dBg_info[partitions_field]["crossing fragment count"] = cdbg.crossing_fragment_count();
+}
+
+
 template <uint16_t k>
 void dBG_Info<k>::add_short_seqs_info(const std::vector<std::pair<std::string, std::size_t>>& short_seqs)
 {
@@ -128,6 +145,21 @@ void dBG_Info<k>::add_unipaths_info(const CdBG<k>& cdbg)
 }
 
 
+template <uint16_t k>
+void dBG_Info<k>::add_unipaths_info(const Partitioned_CdBG<k>& cdbg)
+{
+    const Unipaths_Meta_info<k>& unipaths_info = cdbg.unipaths_meta_info();
+    add_unipaths_info(unipaths_info);
+
+    dBg_info[dcc_field]["DCC count"] = unipaths_info.dcc_count();
+    if(unipaths_info.dcc_count() > 0)
+    {
+        dBg_info[dcc_field]["vertex count in the DCCs"] = unipaths_info.dcc_kmer_count();
+        dBg_info[dcc_field]["sum DCC length (in bases)"] = unipaths_info.dcc_sum_len();
+    }
+}
+
+
 template <uint16_t k>
 /**
  * @brief 添加构建参数
@@ -148,6 +180,43 @@ void dBG_Info<k>::add_build_params(const Build_Params& params)
 }
 
 
+template <uint16_t k>
+void dBG_Info<k>::add_phase_metrics(const std::string& phase, const Phase_Metrics& metrics)
+{
+    auto& phase_info = dBg_info[phases_field][phase];
+
+    phase_info["wall time (s)"] = metrics.wall_time();
+    phase_info["items processed"] = metrics.items();
+
+    if(Trace::enabled())
+    {
+        const auto ns = [](const auto t){ return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count()); };
+        Trace::record(Trace::intern(phase), ns(metrics.start_time()), ns(metrics.end_time()));
+    }
+
+    // The process-wide measurements would mix in the other jobs sharing the process.
+    if(Phase_Metrics::process_shared())
+        return;
+
+    phase_info["CPU time (s)"] = metrics.cpu_time();
+    phase_info["peak RSS (bytes)"] = metrics.peak_rss();
+    phase_info["peak RSS rise (bytes)"] = metrics.peak_rss_rise();
+    phase_info["current RSS (bytes)"] = metrics.curr_rss();
+    phase_info["bytes read"] = metrics.bytes_read();
+    phase_info["bytes written"] = metrics.bytes_written();
+    if(Memory_Budget::bounded())
+        phase_info["memory headroom (bytes)"] = Memory_Budget::headroom(metrics.peak_rss());
+
+    Memory_Budget::report(phase, metrics.peak_rss());
+#ifdef CF_CONTENTION_STATS
+    phase_info["contention"] = metrics.contention();
+#endif
+#ifdef CF_PERF_COUNTERS
+    phase_info["hardware counters"] = metrics.hw_counters();
+#endif
+}
+
+
 template <uint16_t k>
 void dBG_Info<k>::dump_info() const
 {
@@ -12,6 +12,9 @@ extern "C" {
 #endif
   int cf_build(int argc, char** argv);
   int cf_validate(int argc, char** argv);
+  int cf_generate(int argc, char** argv);
+  int cf_bench(int argc, char** argv);
+  int cf_batch(int argc, char** argv);
 #ifdef __cplusplus
 }
 #endif
@@ -26,10 +29,13 @@ std::string executable_version()
 void display_help_message()
 {
     std::cout << executable_version() << "\n";
-    std::cout << "Supported commands: `build`, `help`, `version`.\n";
+    std::cout << "Supported commands: `build`, `batch`, `generate`, `bench`, `help`, `version`.\n";
     
     std::cout << "Usage:\n";
     std::cout << "\tcuttlefish build [options]\n";
+    std::cout << "\tcuttlefish batch [options]\n";
+    std::cout << "\tcuttlefish generate [options]\n";
+    std::cout << "\tcuttlefish bench [options]\n";
 }
 
 
@@ -52,8 +58,14 @@ int main(int argc, char** argv)
 
       if (command == "build")
         return cf_build(argc - 1, argv + 1);
+      else if (command == "batch")
+        return cf_batch(argc - 1, argv + 1);
       else if (command == "validate")
         return cf_validate(argc - 1, argv + 1);
+      else if (command == "generate")
+        return cf_generate(argc - 1, argv + 1);
+      else if (command == "bench")
+        return cf_bench(argc - 1, argv + 1);
       else if (command == "help")
         display_help_message();
       else if (command == "version")
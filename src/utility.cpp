@@ -50,6 +50,14 @@ bool dir_exists(const std::string& dir_path)
 }
 
 
+bool create_dir(const std::string& dir_path)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(dir_path, ec);
+    return dir_exists(dir_path);
+}
+
+
 std::size_t file_size(const std::string& file_path)
 {
     std::error_code ec;
@@ -170,19 +178,12 @@ void move_file(const std::string& from_path, const std::string& to_path)
 }
 
 
-/**
- * @brief 获取进程峰值内存使用量
- *
- * 读取进程状态文件，获取进程的峰值内存使用量（以字节为单位）。
- *
- * @return 进程的峰值内存使用量（以字节为单位），若读取文件失败则返回0
- */
-std::size_t process_peak_memory()
+// Returns the value (in bytes) of the memory field `field` of the running process' status
+// information. Returns `0` in case of errors encountered.
+static std::size_t process_memory_field(const char* const field)
 {
-    
     constexpr const char* process_file = "/proc/self/status";
-    constexpr const char* peak_mem_field = "VmHWM:";
-    const std::size_t field_len = std::strlen(peak_mem_field);
+    const std::size_t field_len = std::strlen(field);
 
     std::FILE* fp = std::fopen(process_file, "r");
     if(fp == NULL)
@@ -192,22 +193,54 @@ std::size_t process_peak_memory()
     }
 
     char line[1024];
-    std::size_t peak_mem = 0;
+    std::size_t mem = 0;
     while(std::fgets(line, sizeof(line) - 1, fp))
-        if(std::strncmp(line, peak_mem_field, field_len) == 0)
+        if(std::strncmp(line, field, field_len) == 0)
         {
-          // 将后面的字符串转换为无符号长整数，并存储在 peak_mem 中。
-          peak_mem = std::strtoul(line + field_len, NULL, 0);
-          break;
+            mem = std::strtoul(line + field_len, NULL, 0);  // The field is in KB.
+            break;
         }
 
-    
-    if(std::ferror(fp))
+    const bool err = std::ferror(fp);
+    std::fclose(fp);
+    if(err)
     {
         std::cerr << "Error reading the process information file.\n";
         return 0;
     }
 
 
-    return peak_mem * 1024;
+    return mem * 1024;
+}
+
+
+std::size_t process_peak_memory()
+{
+    return process_memory_field("VmHWM:");
+}
+
+
+std::size_t process_curr_memory()
+{
+    return process_memory_field("VmRSS:");
+}
+
+
+void process_io_bytes(uint64_t& bytes_read, uint64_t& bytes_written)
+{
+    // The counters are collected from the `rchar` and the `wchar` fields of the process' I/O
+    // information, as the storage-level fields are not always exposed.
+    bytes_read = bytes_written = 0;
+    std::FILE* const fp = std::fopen("/proc/self/io", "r");
+    if(fp == NULL)
+        return;
+
+    char line[256];
+    while(std::fgets(line, sizeof(line) - 1, fp))
+        if(std::strncmp(line, "rchar:", 6) == 0)
+            bytes_read = std::strtoull(line + 6, NULL, 10);
+        else if(std::strncmp(line, "wchar:", 6) == 0)
+            bytes_written = std::strtoull(line + 6, NULL, 10);
+
+    std::fclose(fp);
 }